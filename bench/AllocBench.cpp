@@ -0,0 +1,123 @@
+// Counts the heap allocations made to lex and parse typical statements,
+// with their tokens, nodes and value lists allocated from the heap and from
+// a per-statement Arena.
+//
+//   $ ./ursql_bench [rounds]
+
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "common/Arena.hpp"
+#include "parser/Lexer.hpp"
+#include "parser/Parser.hpp"
+#include "parser/TokenStream.hpp"
+#include "statement/Statement.hpp"
+
+namespace {
+
+std::size_t allocationCount = 0;
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+    ++allocationCount;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// std::pmr::new_delete_resource() goes through the aligned forms.
+void* operator new(std::size_t size, std::align_val_t align) {
+    ++allocationCount;
+    auto alignment = static_cast<std::size_t>(align);
+    std::size_t rounded = (size + alignment - 1) / alignment * alignment;
+    if (void* p = std::aligned_alloc(alignment, rounded ? rounded : alignment))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+namespace ursql {
+
+std::ostream& out = std::cout;
+std::ostream& err = std::cerr;
+
+}  // namespace ursql
+
+namespace {
+
+using namespace ursql;
+
+std::vector<std::string> makeStatements() {
+    std::string insert = "insert into users (id, name, score) values ";
+    for (int i = 0; i < 100; ++i) {
+        insert += std::format("{}({}, 'user{}', {}.5)", i ? ", " : "", i, i,
+                              i * 3);
+    }
+    return {
+        "create table users (id int primary key auto_increment, "
+        "name varchar, score float, active boolean)",
+        "select id, name from users where score > 10 and active = true",
+        "update users set score = 0, active = false where id < 50",
+        "delete from users where name = 'user7'",
+        std::move(insert),
+    };
+}
+
+template<typename Lex>
+void measure(const char* label, const std::vector<std::string>& statements,
+             std::size_t rounds, Lex&& lex) {
+    std::size_t before = allocationCount;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t round = 0; round < rounds; ++round) {
+        for (auto& text : statements) {
+            TokenStream ts(lex(text));
+            ResourcePtr<Statement> pStmt = parser::parse(ts);
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    std::size_t count = rounds * statements.size();
+    std::cout << std::format(
+      "{:<8} {:>8.1f} allocations/statement {:>8.2f} us/statement\n", label,
+      static_cast<double>(allocationCount - before) / count,
+      std::chrono::duration<double, std::micro>(elapsed).count() / count);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::size_t rounds = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    std::vector<std::string> statements = makeStatements();
+    measure("heap", statements, rounds, [](const std::string& text) {
+        return Lexer(text).lex();
+    });
+    Arena arena;
+    measure("arena", statements, rounds, [&arena](const std::string& text) {
+        arena.reset();
+        return Lexer(text).lex(arena.resource());
+    });
+    return EXIT_SUCCESS;
+}
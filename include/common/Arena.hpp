@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "common/Macros.hpp"
+
+namespace ursql {
+
+// Memory for what's parsed from statements: their tokens, nodes and value
+// lists. Allocations are carved out of an inline buffer, then out of growing
+// heap chunks, and are given back all at once by reset() or when the arena
+// goes; deallocating is a no-op.
+class Arena {
+public:
+    Arena()
+        : buffer_(),
+          resource_(buffer_.data(), buffer_.size(),
+                    std::pmr::new_delete_resource()) {}
+    ~Arena() = default;
+
+    URSQL_DISABLE_COPY(Arena);
+
+    [[nodiscard]] std::pmr::memory_resource* resource() noexcept {
+        return &resource_;
+    }
+
+    // Everything allocated from the arena must be dead by now.
+    void reset() {
+        resource_.release();
+    }
+
+    static constexpr const std::size_t inlineSize = 8 << 10;
+
+private:
+    alignas(std::max_align_t) std::array<std::byte, inlineSize> buffer_;
+    std::pmr::monotonic_buffer_resource resource_;
+};
+
+// Destroys an object made by allocateUnique() and gives its memory back to
+// the resource it came from. It remembers the size of the object it was
+// made for, so that the object may be deleted through a base class.
+class ResourceDeleter {
+public:
+    ResourceDeleter() noexcept = default;
+    ResourceDeleter(std::pmr::memory_resource* resource, std::size_t size,
+                    std::size_t alignment) noexcept
+        : resource_(resource),
+          size_(size),
+          alignment_(alignment) {}
+
+    template<typename T>
+    void operator()(T* p) const {
+        void* memory;
+        if constexpr (std::is_polymorphic_v<T>) {
+            memory = dynamic_cast<void*>(p);
+        } else {
+            memory = p;
+        }
+        std::destroy_at(p);
+        resource_->deallocate(memory, size_, alignment_);
+    }
+
+private:
+    std::pmr::memory_resource* resource_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t alignment_ = 0;
+};
+
+template<typename T>
+using ResourcePtr = std::unique_ptr<T, ResourceDeleter>;
+
+// Like std::make_unique, but the object is allocated from resource.
+template<typename T, typename... Args>
+ResourcePtr<T> allocateUnique(std::pmr::memory_resource* resource,
+                              Args&&... args) {
+    void* memory = resource->allocate(sizeof(T), alignof(T));
+    try {
+        return ResourcePtr<T>(new (memory) T(std::forward<Args>(args)...),
+                              ResourceDeleter(resource, sizeof(T), alignof(T)));
+    } catch (...) {
+        resource->deallocate(memory, sizeof(T), alignof(T));
+        throw;
+    }
+}
+
+}  // namespace ursql
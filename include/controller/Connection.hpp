@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string_view>
+
+#include "controller/DBManager.hpp"
+
+namespace ursql {
+
+class PreparedStatement;
+class View;
+
+// Embeds UrSQL in another program. Statements run as they do at the prompt,
+// but their results are handed back as values instead of being rendered,
+// and append() loads batches of values into a table without any SQL text.
+class Connection {
+public:
+    // The outcome of one statement: the rows a query selected, or the number
+    // of rows a modification affected, or a message for anything else.
+    class Result {
+    public:
+        explicit Result(std::unique_ptr<View> view);
+        ~Result();
+
+        URSQL_DISABLE_COPY(Result);
+        URSQL_DEFAULT_MOVE(Result);
+
+        [[nodiscard]] bool hasRows() const;
+        [[nodiscard]] const std::vector<std::string>& getColumnNames() const;
+        [[nodiscard]] const std::vector<std::vector<Value>>& getRows() const;
+        [[nodiscard]] std::size_t getRowsAffected() const;
+        [[nodiscard]] std::string_view getMessage() const;
+
+    private:
+        std::unique_ptr<View> view_;
+    };
+
+    Connection(const fs::path& dbDirectoryPath, fs::path dbFileExtension);
+    ~Connection();
+
+    URSQL_DISABLE_COPY(Connection);
+
+    // Makes dbName the active database, creating it first if it's missing
+    // and createIfMissing is set.
+    void open(const std::string& dbName, bool createIfMissing = false);
+
+    Result execute(std::string_view sql);
+
+    [[nodiscard]] std::unique_ptr<PreparedStatement> prepare(std::string sql);
+    Result execute(PreparedStatement& statement, const ValueList& params);
+
+    // Inserts columns[j][i] into columnNames[j] of the i-th new row, with the
+    // same validation and conversion as INSERT INTO; all columns must have
+    // the same length. Returns the number of rows inserted.
+    std::size_t append(const std::string& tableName,
+                       const std::vector<std::string>& columnNames,
+                       std::vector<std::vector<Value>> columns);
+
+private:
+    DBManager dbManager_;
+};
+
+}  // namespace ursql
@@ -1,32 +1,57 @@
 #pragma once
 
 #include "model/Database.hpp"
+#include "model/Transaction.hpp"
 
 namespace ursql {
 
+class DatabasePool;
+class PreparedStatement;
+
+// One session: its active database, open transaction and prepared
+// statements. Sessions of a server share the databases of their
+// DatabasePool.
 class DBManager {
 public:
     DBManager(const fs::path& dbDirectoryPath, fs::path dbFileExtension);
-    ~DBManager() = default;
+    explicit DBManager(std::shared_ptr<DatabasePool> pool);
+    ~DBManager();
 
     URSQL_DISABLE_COPY(DBManager);
 
     Database* getActiveDB();
-    std::unique_ptr<Database> getExistingDBByName(const std::string& dbName);
+    std::shared_ptr<Database> getExistingDBByName(const std::string& dbName);
 
     bool databaseExists(const std::string& dbName);
-    void createDatabases(const std::vector<std::string>& dbNames);
+    void createDatabases(const std::vector<std::string>& dbNames,
+                         std::size_t blockSize = Block::defaultSize);
     void dropDatabases(const std::vector<std::string>& dbNames);
     void useDatabase(const std::string& dbName);
     std::vector<std::string> getDatabaseNames();
 
-private:
-    const fs::path dbDirectoryPath_;
-    const fs::path dbFileExtension_;
-    std::unique_ptr<Database> activeDB_;
+    // A transaction runs on the database that was active when it began,
+    // which can't be switched until it ends. Like in MySQL, beginning
+    // another one or changing databases or tables commits it first, and
+    // ending the session rolls it back.
+    void beginTransaction();
+    void commitTransaction();
+    void rollbackTransaction();
+    // The open transaction, if any, for statements to run in.
+    Transaction* getTransaction();
+
+    // Prepared statements live for the session, across databases, and are
+    // replaced by preparing another one under the same name.
+    void addPreparedStatement(const std::string& name,
+                              std::unique_ptr<PreparedStatement> statement);
+    PreparedStatement& getPreparedStatement(const std::string& name);
+    void deallocatePreparedStatement(const std::string& name);
 
-    fs::path _dbName2Path(const std::string& dbName);
-    std::optional<std::string> _dirEnt2DbName(const fs::directory_entry& entry);
+private:
+    const std::shared_ptr<DatabasePool> pool_;
+    std::shared_ptr<Database> activeDB_;
+    std::unique_ptr<Transaction> transaction_;
+    std::unordered_map<std::string, std::unique_ptr<PreparedStatement>>
+      preparedStatements_;
 };
 
 }  // namespace ursql
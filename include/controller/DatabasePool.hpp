@@ -0,0 +1,55 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+
+#include "model/Database.hpp"
+
+namespace ursql {
+
+// The databases of one data directory, shared by every session working on
+// it. A database is opened by the first session that uses it and stays
+// open while some session uses it or it's among the most recently used
+// ones, so switching back and forth between databases doesn't reopen them.
+class DatabasePool {
+public:
+    DatabasePool(const fs::path& dbDirectoryPath, fs::path dbFileExtension,
+                 std::size_t cacheCapacity = defaultCacheCapacity);
+    ~DatabasePool() = default;
+
+    URSQL_DISABLE_COPY(DatabasePool);
+
+    [[nodiscard]] std::shared_ptr<Database> open(const std::string& dbName);
+
+    bool exists(const std::string& dbName);
+    void create(const std::vector<std::string>& dbNames,
+                std::size_t blockSize = Block::defaultSize);
+    // Sessions still using a dropped database keep working on their handle
+    // until they switch away from it; new sessions can't open it any more.
+    void drop(const std::vector<std::string>& dbNames);
+    std::vector<std::string> getNames();
+    // The databases some session is using right now.
+    std::vector<std::shared_ptr<Database>> getOpenDatabases();
+
+    static constexpr const std::size_t defaultCacheCapacity = 32;
+
+private:
+    const fs::path dbDirectoryPath_;
+    const fs::path dbFileExtension_;
+    const std::size_t cacheCapacity_;
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::weak_ptr<Database>> openDBs_;
+    // The most recently used databases first, kept open even when no
+    // session uses them. Short enough to be searched linearly.
+    std::list<std::shared_ptr<Database>> recentDBs_;
+
+    // Returns the database that fell out of the cache, if any, to be
+    // closed once the mutex is let go.
+    [[nodiscard]] std::shared_ptr<Database> _touch(
+      std::shared_ptr<Database> database);
+    bool _exists(const std::string& dbName);
+    fs::path _dbName2Path(const std::string& dbName);
+    std::optional<std::string> _dirEnt2DbName(const fs::directory_entry& entry);
+};
+
+}  // namespace ursql
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <stop_token>
+
+#include "common/Arena.hpp"
+#include "controller/DatabasePool.hpp"
+
+namespace ursql {
+
+// How the server writes changes to the open databases in the background.
+struct WriteBehindOptions {
+    // The rate at which cached blocks waiting to be written are trickled
+    // out, so that reads rarely wait for an eviction to write one.
+    std::size_t dirtyBlocksPerSecond = 512;
+    // How often each database saves what has committed, which bounds what
+    // a crash loses and what's left to write on shutdown.
+    std::chrono::milliseconds checkpointInterval = std::chrono::seconds(10);
+};
+
+// Serves concurrent sessions over a Unix domain socket. Clients write SQL
+// as they would type it at the prompt and read back what the prompt would
+// print. One thread multiplexes every connection with epoll and parses
+// statements as they arrive; a pool of workers runs them, each session's in
+// order and one at a time, with its own active database. Background
+// threads reclaim the row versions that long reads held on to, compact the
+// databases a little at a time, and write changes behind the sessions'
+// backs.
+class Server {
+public:
+    Server(const fs::path& socketPath, std::shared_ptr<DatabasePool> pool,
+           std::size_t workerCount, WriteBehindOptions writeBehind = {});
+    ~Server();
+
+    URSQL_DISABLE_COPY(Server);
+
+    // Serves clients until stop() is called.
+    void run();
+    // May be called from any thread, and from a signal handler.
+    void stop() noexcept;
+
+    static std::size_t defaultWorkerCount();
+
+private:
+    struct Session;
+
+    const fs::path socketPath_;
+    const std::shared_ptr<DatabasePool> pool_;
+    const std::size_t workerCount_;
+    const WriteBehindOptions writeBehind_;
+    int listenFd_;
+    int epollFd_;
+    int wakeFd_;
+    std::atomic<bool> stopping_;
+    // Owned by the event loop.
+    std::unordered_map<int, std::shared_ptr<Session>> sessions_;
+    Arena arena_;
+
+    // Shared between the event loop and the workers.
+    std::mutex queueMutex_;
+    std::condition_variable queueCond_;
+    std::deque<std::shared_ptr<Session>> runnable_;
+    std::vector<std::shared_ptr<Session>> withOutput_;
+
+    void _accept();
+    void _read(const std::shared_ptr<Session>& session);
+    void _parse(const std::shared_ptr<Session>& session, std::string_view text);
+    void _flush(Session& session);
+    void _watch(Session& session);
+    void _closeIfDone(Session& session);
+    void _work();
+    // Reclaims the row versions no snapshot sees any more, in the
+    // background, until asked to stop.
+    void _vacuum(std::stop_token stopToken);
+    // Trickles out dirty blocks and takes checkpoints until asked to stop.
+    void _writeBehind(std::stop_token stopToken);
+    void _runStatements(const std::shared_ptr<Session>& session);
+    void _wake() noexcept;
+};
+
+}  // namespace ursql
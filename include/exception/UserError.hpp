@@ -72,4 +72,16 @@ public:
     ~MisMatch() override = default;
 };
 
+class LockTimeout : public UserError {
+public:
+    explicit LockTimeout(std::string_view what);
+    ~LockTimeout() override = default;
+};
+
+class Deadlock : public UserError {
+public:
+    explicit Deadlock(std::string_view what);
+    ~Deadlock() override = default;
+};
+
 }  // namespace ursql
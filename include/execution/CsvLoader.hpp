@@ -0,0 +1,39 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+
+#include "CsvParser.hpp"
+
+namespace ursql {
+
+namespace fs = std::filesystem;
+
+// Streams a CSV file in chunks that end on a record boundary. Each chunk is
+// cut into pieces of whole records which are parsed concurrently.
+class CsvLoader {
+public:
+    CsvLoader(const fs::path& filePath, CsvParser parser,
+              std::size_t threadCount = defaultThreadCount());
+    ~CsvLoader() = default;
+
+    URSQL_DISABLE_COPY(CsvLoader);
+
+    // Replaces rows with the records of the next chunk. Returns false once
+    // the file is exhausted.
+    bool next(std::vector<ValueRow>& rows);
+
+    [[nodiscard]] static std::size_t defaultThreadCount();
+
+    static constexpr const std::size_t chunkSize = 4 << 20;
+
+private:
+    std::ifstream file_;
+    const CsvParser parser_;
+    const std::size_t threadCount_;
+    std::string buffer_;
+
+    void _readChunk();
+};
+
+}  // namespace ursql
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string_view>
+
+#include "RowCursor.hpp"
+
+namespace ursql {
+
+// Converts CSV records straight into typed rows, one column per type, with
+// no tokenizer in between. Fields may be quoted with '"' and a doubled
+// quote escapes one. An empty unquoted field or \N is NULL. Blank lines
+// are skipped.
+class CsvParser {
+public:
+    explicit CsvParser(std::vector<ValueType> columnTypes);
+    ~CsvParser() = default;
+
+    URSQL_DEFAULT_COPY(CsvParser);
+    URSQL_DEFAULT_MOVE(CsvParser);
+
+    // Parses text, which must hold only complete records, into rows.
+    void parse(std::string_view text, std::vector<ValueRow>& rows) const;
+
+    // Returns the offsets where text can be cut into about `parts` pieces of
+    // complete records. The last offset ends the last complete record.
+    [[nodiscard]] static std::vector<std::size_t> splitRecords(
+      std::string_view text, std::size_t parts);
+
+private:
+    std::vector<ValueType> columnTypes_;
+};
+
+}  // namespace ursql
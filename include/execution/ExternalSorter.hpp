@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+
+#include "RowCursor.hpp"
+
+namespace ursql {
+
+// Sorts rows on one key column within a fixed memory budget. Whenever the
+// buffered rows exceed the budget they are sorted and spilled as a run to a
+// temporary file through Storage; finish() k-way merges the runs, holding
+// one block per run in memory.
+class ExternalSorter {
+public:
+    explicit ExternalSorter(std::size_t keyIndex,
+                            std::size_t memoryBudget = defaultMemoryBudget);
+    ~ExternalSorter();
+
+    URSQL_DISABLE_COPY(ExternalSorter);
+
+    void add(ValueRow row);
+    [[nodiscard]] std::unique_ptr<RowCursor> finish();
+
+    [[nodiscard]] std::size_t getRunCount() const;
+
+    static constexpr const std::size_t defaultMemoryBudget = 4 << 20;
+
+    class SpillRun;
+
+private:
+    const std::size_t keyIndex_;
+    const std::size_t memoryBudget_;
+    std::vector<ValueRow> buffer_;
+    std::size_t bufferedBytes_;
+    bool bufferSorted_;
+    std::vector<std::unique_ptr<SpillRun>> runs_;
+
+    void _sortBuffer();
+    void _spill();
+};
+
+}  // namespace ursql
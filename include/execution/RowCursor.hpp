@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+
+#include "common/Macros.hpp"
+#include "model/Value.hpp"
+
+namespace ursql {
+
+using ValueRow = std::vector<Value>;
+
+// Pull-based row source shared by the scan, sort and join operators.
+class RowCursor {
+public:
+    explicit RowCursor() = default;
+    virtual ~RowCursor() = default;
+
+    URSQL_DISABLE_COPY(RowCursor);
+
+    // Moves the next row into `row` and returns true, or returns false once
+    // the cursor is exhausted.
+    virtual bool next(ValueRow& row) = 0;
+};
+
+class VectorRowCursor : public RowCursor {
+public:
+    explicit VectorRowCursor(std::vector<ValueRow> rows);
+    ~VectorRowCursor() override = default;
+
+    bool next(ValueRow& row) override;
+
+private:
+    std::vector<ValueRow> rows_;
+    std::size_t i_;
+};
+
+}  // namespace ursql
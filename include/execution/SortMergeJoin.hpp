@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory>
+
+#include "RowCursor.hpp"
+
+namespace ursql {
+
+// Inner equi-join of two inputs that are both ordered on their join key.
+// Each output row is the left row followed by the right row. Runs of equal
+// keys on the right are buffered so that every matching left row is paired
+// with all of them; NULL keys never match.
+class SortMergeJoin : public RowCursor {
+public:
+    SortMergeJoin(std::unique_ptr<RowCursor> left, std::size_t leftKeyIndex,
+                  std::unique_ptr<RowCursor> right, std::size_t rightKeyIndex);
+    ~SortMergeJoin() override = default;
+
+    bool next(ValueRow& row) override;
+
+private:
+    const std::unique_ptr<RowCursor> left_;
+    const std::unique_ptr<RowCursor> right_;
+    const std::size_t leftKeyIndex_;
+    const std::size_t rightKeyIndex_;
+
+    ValueRow leftRow_;
+    ValueRow rightRow_;
+    bool leftValid_;
+    bool rightValid_;
+
+    std::vector<ValueRow> rightRun_;
+    std::size_t runPos_;
+    bool inRun_;
+
+    void _advanceLeft();
+    void _advanceRight();
+    void _collectRightRun();
+};
+
+}  // namespace ursql
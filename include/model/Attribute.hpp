@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Storable.hpp"
 #include "Value.hpp"
 
 namespace ursql {
@@ -30,6 +31,7 @@ public:
     [[nodiscard]] bool isAutoInc() const;
 
     [[nodiscard]] bool mustBeSpecified() const;
+    [[nodiscard]] std::size_t encodedSize() const;
 
     static Attribute parse(TokenStream& ts);
 
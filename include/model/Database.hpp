@@ -1,11 +1,20 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <fstream>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
 #include <unordered_map>
+#include <unordered_set>
 
+#include "execution/RowCursor.hpp"
 #include "model/Attribute.hpp"
 #include "model/Entity.hpp"
+#include "model/LockManager.hpp"
 #include "model/TOC.hpp"
 #include "persistence/Storage.hpp"
 
@@ -13,20 +22,53 @@ namespace ursql {
 
 class Filter;
 class Order;
+class Transaction;
 
+// Safe to share between threads; each call is atomic. Calls take these
+// latches in this order:
+// - the catalog latch, shared, or exclusive to create or drop tables;
+// - the latch of a table, shared to copy its row versions and exclusive to
+//   change them;
+// - the allocation latch, to find blocks for new rows or free blocks;
+// - the storage latch, inside each block access.
+// Reads run on a snapshot of the committed transactions and only latch a
+// table while copying its row versions. Writers keep the versions a
+// snapshot still sees, so long reads and writes to the same table don't
+// wait for each other.
+// Each call runs in a transaction of its own unless it's given an explicit
+// one. Writers lock the rows they delete or replace and hold the locks until
+// their transaction ends; truncating or dropping a table locks all of it.
+// A writer that has to wait for a lock lets go of its latches first, and
+// starts over once it's granted.
 class Database {
+private:
+    struct Table;
+
 public:
-    using EntityCache = std::unordered_map<std::string, Entity>;
+    // The column resolution and checks of an INSERT, done once per statement
+    // shape. A plan is only valid under the schema stamp it was made with.
+    struct InsertPlan {
+        std::uint64_t schemaStamp;
+        Table* table;
+        std::vector<std::size_t> attrIndexes;
+        std::vector<bool> attrSpecified;
+    };
 
-    Database(std::string name, const fs::path& filePath, CreateNewFile);
+    Database(std::string name, const fs::path& filePath,
+             CreateNewFile createNewFile);
     Database(std::string name, const fs::path& filePath, OpenExistingFile);
     ~Database();
 
     URSQL_DISABLE_COPY(Database);
 
     [[nodiscard]] const std::string& getName() const;
+    // Changes whenever a table is created or dropped, and is never shared by
+    // two databases.
+    [[nodiscard]] std::uint64_t getSchemaStamp() const;
     [[nodiscard]] std::vector<BlockType> getBlockTypes();
-    [[nodiscard]] std::vector<std::string> getAllEntityNames() const;
+    [[nodiscard]] std::vector<std::string> getAllEntityNames();
+    [[nodiscard]] std::vector<std::string> getAttributeNames(
+      const std::string& entityName);
 
     void createTable(const std::string& entityName,
                      const std::vector<Attribute>& attributes);
@@ -36,21 +78,85 @@ public:
     void insertIntoTable(
       const std::string& entityName,
       const std::optional<std::vector<std::string>>& attrNames,
-      const std::vector<std::vector<Value>>& valueLists);
+      const std::pmr::vector<ValueList>& valueLists,
+      Transaction* transaction = nullptr);
+
+    [[nodiscard]] InsertPlan planInsert(
+      const std::string& entityName,
+      const std::optional<std::vector<std::string>>& attrNames);
+    // Validates and converts the values a column at a time, then encodes
+    // the new rows straight into blocks written in runs of adjacent blocks.
+    void insertRows(const InsertPlan& plan,
+                    std::pmr::vector<ValueList> valueLists,
+                    Transaction* transaction = nullptr);
+
+    [[nodiscard]] std::vector<std::vector<Value>> selectFromTable(
+      const std::string& entityName,
+      const std::optional<std::vector<std::string>>& attrNames,
+      const Filter* filter, const Transaction* transaction = nullptr);
+
+    // Inner equi-join of two tables through a sort-merge join. Attribute
+    // names may be qualified as "table.column".
+    [[nodiscard]] std::vector<std::vector<Value>> joinTables(
+      const std::string& leftEntityName, const std::string& rightEntityName,
+      const std::string& leftAttrName, const std::string& rightAttrName,
+      const std::optional<std::vector<std::string>>& attrNames,
+      const Transaction* transaction = nullptr);
+
+    // Appends the records of a CSV file, whose fields follow the column
+    // order, without going through the SQL parser.
+    std::size_t loadIntoTable(const std::string& entityName,
+                              const fs::path& filePath,
+                              Transaction* transaction = nullptr);
+
+    std::size_t deleteFromTable(const std::string& entityName,
+                                const Filter* filter,
+                                Transaction* transaction = nullptr);
+
+    // Empties the table without touching its row blocks; they are handed
+    // to the free block pool and released in bulk later.
+    std::size_t truncateTable(const std::string& entityName,
+                              Transaction* transaction = nullptr);
+
+    // Rows are patched in cached blocks and written back in one batch, or
+    // get new versions while snapshots are being read.
+    std::size_t updateTable(
+      const std::string& entityName,
+      const std::vector<std::pair<std::string, Value>>& assignments,
+      const Filter* filter, Transaction* transaction = nullptr);
+
+    // A transaction reads on the snapshot it begins with, and nobody else
+    // sees its changes until it commits.
+    [[nodiscard]] std::unique_ptr<Transaction> beginTransaction();
+    // Publishes the changes, then saves the row directories of the tables
+    // they touched and flushes them with their rows in one go.
+    void commit(Transaction& transaction);
+    // Drops the row versions the transaction created and revives the ones
+    // it deleted.
+    void rollback(Transaction& transaction);
+
+    // Forgets the row versions no snapshot sees any more and hands their
+    // blocks to the free block pool. Writers already do so for their table
+    // when they finish; this catches versions that readers held on to.
+    std::size_t reclaimVersions();
+
+    // Moves live rows of the table, or of every table, down into the lowest
+    // free blocks, at most maxRows of them, then cuts the free blocks at the
+    // end off the file. Moved rows keep their order, so scans read runs of
+    // adjacent blocks again. Tables other transactions are writing are left
+    // for later. Returns how many rows were moved.
+    std::size_t vacuum(const std::optional<std::string>& entityName,
+                       std::size_t maxRows = Entity::npos);
+
+    // Trickles out up to maxBlocks cached blocks waiting to be written, the
+    // least recently used first.
+    std::size_t writeDirtyBlocks(std::size_t maxBlocks);
+    // Saves what has committed so far, a table at a time, and flushes it
+    // with every dirty block, so that the file is up to date without
+    // closing the database. Writers are only held up while their table is
+    // saved.
+    void checkpoint();
 
-    //
-    //    StatusResult selectFromTable(RowCollection& aRowCollection,
-    //                                 const std::string& anEntityName,
-    //                                 StringList& aFieldNames, const Filter*
-    //                                 aFilter, const Order* anOrder);
-    //
-    //    StatusResult deleteFromTable(const std::string& anEntityName,
-    //                                 const Filter* aFilter);
-    //
-    //    StatusResult updateTable(const std::string& anEntityName,
-    //                             const Row::DataMap& aFieldValues,
-    //                             const Filter* aFilter);
-    //
     //    inline const std::string& getName() const {
     //        return m_storage.getName();
     //    }
@@ -65,19 +171,122 @@ public:
     //    }
 
 private:
+    // A cached entity with the latch of its table.
+    struct Table {
+        Table(std::string name, Entity entity);
+
+        const std::string name;
+        Entity entity;
+        std::shared_mutex latch;
+    };
+
+    // A lock a writer has to wait for.
+    struct LockRequest {
+        LockTarget target;
+        LockMode mode;
+    };
+
+    // Tables are never moved once cached, so references to them stay valid
+    // until they are dropped.
+    using EntityCache = std::unordered_map<std::string, Table>;
+
     std::string name_;
     Storage storage_;
     TOC toc_;
     EntityCache entityCache_;
+    std::atomic<std::uint64_t> schemaStamp_;
+    std::shared_mutex catalogLatch_;
+    // Guards entityCache_ against tables loaded under a shared catalog latch.
+    std::mutex entityCacheLatch_;
+    std::mutex allocationLatch_;
+    // Guards the transaction bookkeeping below.
+    std::mutex txnLatch_;
+    std::condition_variable txnCond_;
+    TxnId lastTxnId_;
+    std::set<TxnId> runningTxns_;
+    std::multiset<TxnId> snapshotHorizons_;
+    // Writers changing rows in place, which no snapshot may observe.
+    std::size_t inPlaceWriters_;
+    LockManager lockManager_;
+    // Blocks that no entity refers to any more but that are still typed as
+    // rows on disk. They are reused first and marked free on close.
+    std::vector<std::vector<std::size_t>> pendingFreeBlockNums_;
+    // The free blocks left of the extent each table last grew the file by,
+    // highest first, which nothing else takes.
+    std::unordered_map<std::string, std::vector<std::size_t>> extents_;
+    std::unordered_set<std::size_t> reservedBlockNums_;
 
-    [[nodiscard]] std::size_t _findFreeBlockNumber();
-    [[nodiscard]] Entity& _getEntityByName(const std::string& entityName);
+    // Callers hold the allocation latch, as for everything below that
+    // touches the free blocks.
+    [[nodiscard]] std::vector<std::size_t> _allocateBlockNumbers(
+      std::size_t count, const Table* table);
+    void _releaseExtent(const std::string& entityName);
+    [[nodiscard]] std::optional<std::size_t> _takePendingFreeBlock();
+    void _releaseLater(std::vector<std::size_t> blockNums);
+    void _releasePending();
+    [[nodiscard]] Table& _getTable(const std::string& entityName);
+    [[nodiscard]] InsertPlan _planInsert(
+      const std::string& entityName,
+      const std::optional<std::vector<std::string>>& attrNames);
+    // Takes the values once the locks are granted.
+    [[nodiscard]] std::optional<LockRequest> _insertRows(
+      const InsertPlan& plan, std::pmr::vector<ValueList>& valueLists,
+      TxnId txn, Transaction* transaction);
+    // Encodes the rows into newly allocated blocks, in order, and returns
+    // the block numbers.
+    [[nodiscard]] std::vector<std::size_t> _writeRows(
+      const Table& table, std::vector<std::vector<Value>> valueRows);
+    // Callers hold the allocation latch, and the block numbers ascend.
+    void _writeRowsTo(const std::vector<std::size_t>& blockNums,
+                      std::vector<std::vector<Value>> valueRows);
+    std::size_t _compactTable(Table& table, std::size_t maxRows);
+    // Saves what has committed of every dirty table and flushes. Callers
+    // hold the catalog latch.
+    void _saveTables();
+    // Saves a dirty entity with its directory blocks, taking more of them
+    // or releasing some as the directory grew or shrank. Takes the
+    // allocation latch only then.
+    void _saveEntity(Entity& entity);
+    // Saves what the snapshot sees of the entity, whose directory blocks
+    // follow. Callers hold the table latch.
+    void _saveEntityAsOf(Entity& entity, const Snapshot& snapshot);
     void _addEntity(const std::string& entityName, Entity& entity);
     void _dropEntity(const std::string& entityName);
 
-    void _insertIntoTableInternal(
-      Entity& entity, const std::vector<std::size_t>& attrIndexes,
-      const std::vector<std::vector<Value>>& valueLists);
+    // The transaction a change runs in: the given one, or one of its own
+    // that _endWrite() ends and unlocks, which may be done more than once.
+    [[nodiscard]] TxnId _beginWrite(Transaction* transaction);
+    void _endWrite(TxnId txn, const Transaction* transaction);
+    // Locks the table in the given mode, then the rows held in the blocks
+    // exclusively, as far as that needs no waiting. Returns the first lock
+    // that does. Callers hold the table latch exclusively.
+    [[nodiscard]] std::optional<LockRequest> _tryLockForWrite(
+      TxnId txn, const Table& table, LockMode tableMode,
+      const std::vector<std::size_t>& blockNums, Transaction* transaction);
+    // Callers hold no latch. A deadlock victim is rolled back.
+    void _waitForLock(TxnId txn, const LockRequest& request,
+                      Transaction* transaction);
+    [[nodiscard]] TxnId _beginTxn();
+    void _endTxn(TxnId txn);
+    // Waits for writers changing rows in place. The snapshot sees the
+    // changes of its own transaction, if any, and must be released once its
+    // reads are done.
+    [[nodiscard]] Snapshot _takeSnapshot(TxnId own = 0);
+    void _releaseSnapshot(const Snapshot& snapshot);
+    // What has committed so far, plus the changes of its own transaction.
+    // Writers pick the rows to change on it; it's never registered, so it
+    // can't be read once the table latch is let go.
+    [[nodiscard]] Snapshot _currentSnapshot(TxnId own);
+    // Starts changing rows in place unless a snapshot is being read.
+    [[nodiscard]] bool _enterInPlace();
+    void _leaveInPlace();
+    // Callers hold the table latch exclusively.
+    std::size_t _pruneRowVersions(Entity& entity);
+
+    [[nodiscard]] std::unique_ptr<RowCursor> _scanTable(
+      Table& table, const Snapshot& snapshot);
+    [[nodiscard]] std::unique_ptr<RowCursor> _sortedScan(
+      Table& table, const Snapshot& snapshot, std::size_t keyIndex);
 };
 
 }  // namespace ursql
@@ -1,14 +1,25 @@
 #pragma once
 
 #include <algorithm>
+#include <functional>
+#include <optional>
 #include <vector>
 
 #include "Attribute.hpp"
+#include "RowVersion.hpp"
 
 namespace ursql {
 
+// Only the live row versions are saved; the file holds no history. The row
+// directory lists their blocks after the attributes in the entity block, and
+// what doesn't fit there continues in a chain of directory blocks. Each of
+// those holds as many block numbers as fit and the number of the next one,
+// so a table isn't limited by the block size.
 class Entity : public MonoStorable {
 public:
+    using DirectoryBlockWriter =
+      std::function<void(const Block&, std::size_t)>;
+
     explicit Entity(std::size_t blockNum);
     ~Entity() override = default;
 
@@ -22,15 +33,56 @@ public:
     void setAttributes(std::vector<Attribute> attributes);
     [[nodiscard]] const std::vector<Attribute>& getAttributes() const;
 
+    [[nodiscard]] bool attributeExists(std::string_view name) const;
     std::size_t attributeIndex(std::string_view name) const;
     const Attribute& getAttribute(std::size_t index) const;
 
     std::size_t getNextAutoInc();
     void updateAutoInc(std::size_t i);
 
-    void addRowPosition(std::size_t blockNum);
-    void dropRowPosition(std::size_t blockNum);
-    const std::vector<std::size_t>& getRowBlockNums() const;
+    // Adds versions of new rows, held in blocks known to be fresh.
+    void appendRowVersions(const std::vector<std::size_t>& blockNums,
+                           TxnId xmin);
+    // Marks the live versions held in the given blocks deleted by xmax.
+    void deleteRowVersions(const std::vector<std::size_t>& blockNums,
+                           TxnId xmax);
+    // Marks the live versions held in the old blocks deleted by txn, each
+    // followed by its new version created by txn, so rows keep their order.
+    void replaceRowVersions(const std::vector<std::size_t>& oldBlockNums,
+                            const std::vector<std::size_t>& newBlockNums,
+                            TxnId txn);
+    // Marks every live version deleted by xmax and returns their count.
+    std::size_t deleteAllRowVersions(TxnId xmax);
+    // Undoes a transaction: forgets the versions it created, returning
+    // their blocks, and makes the ones it deleted live again.
+    [[nodiscard]] std::vector<std::size_t> rollbackRowVersions(TxnId txn);
+    // Forgets versions deleted before the horizon and returns their blocks.
+    [[nodiscard]] std::vector<std::size_t> pruneRowVersions(TxnId horizon);
+    // Forgets all versions and returns their blocks.
+    [[nodiscard]] std::vector<std::size_t> releaseRowBlockNums();
+    const std::vector<RowVersion>& getRowVersions() const;
+
+    // How many directory blocks the live rows need with blocks of the given
+    // payload size.
+    [[nodiscard]] std::size_t getDirectoryBlockCount(
+      std::size_t payloadSize) const;
+    [[nodiscard]] const std::vector<std::size_t>& getDirectoryBlockNums() const;
+    // The directory blocks to save the entity with, which the caller
+    // allocates. The entity doesn't become dirty.
+    void setDirectoryBlockNums(std::vector<std::size_t> blockNums);
+    // Encodes the directory blocks one at a time into a block of the given
+    // size, and hands each to write with its number.
+    void encodeDirectoryBlocks(std::size_t blockSize,
+                               const DirectoryBlockWriter& write) const;
+    // The directory block to decode next after the entity block is decoded,
+    // until the directory is complete.
+    [[nodiscard]] std::optional<std::size_t> getUndecodedDirectoryBlockNum()
+      const;
+    void decodeDirectoryBlock(const Block& block);
+
+    // The entity as the snapshot sees it, to be saved while other
+    // transactions still have uncommitted versions in it.
+    [[nodiscard]] Entity copyAsOf(const Snapshot& snapshot) const;
 
     //    Row generateNewRow(const std::vector<std::string>& fieldNames, const
     //    StringList& aValueStrs);
@@ -40,7 +92,15 @@ public:
 private:
     std::vector<Attribute> attributes_;
     std::size_t autoInc_;
-    std::vector<std::size_t> rowBlockNums_;
+    std::vector<RowVersion> rowVersions_;
+    std::vector<std::size_t> directoryBlockNums_;
+    std::size_t undecodedDirectoryBlockNum_;
+
+    [[nodiscard]] std::vector<std::size_t> _getLiveBlockNums() const;
+    // How many block numbers the entity block has room for after the
+    // attributes.
+    [[nodiscard]] std::size_t _getEntityBlockCapacity(
+      std::size_t payloadSize) const;
 };
 
 }  // namespace ursql
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/Macros.hpp"
+#include "model/RowVersion.hpp"
+
+namespace ursql {
+
+// A row is locked in a plain mode after its table is locked in the matching
+// intention mode, so that locking a whole table only checks the table.
+enum class LockMode {
+    intention_shared,
+    intention_exclusive,
+    shared,
+    exclusive
+};
+
+// A table, or a row of it named by the block of the row version being
+// changed.
+struct LockTarget {
+    static constexpr const std::size_t noRow =
+      std::numeric_limits<std::size_t>::max();
+
+    static LockTarget ofTable(std::string entityName);
+    static LockTarget ofRow(std::string entityName, std::size_t blockNum);
+
+    bool operator==(const LockTarget&) const = default;
+
+    std::string entityName;
+    std::size_t blockNum;
+};
+
+// Locks that transactions hold until they end. Readers take none since
+// they read snapshots; writers lock what they change, so writers of the
+// same rows take turns while writers of different rows never wait.
+// The lock table is split into shards by target, each with its own mutex.
+// A transaction that has to wait records whom it waits for; it fails with
+// Deadlock if that closes a cycle, and with LockTimeout if the wait outlasts
+// the timeout.
+class LockManager {
+public:
+    explicit LockManager(std::chrono::milliseconds timeout);
+    ~LockManager() = default;
+
+    URSQL_DISABLE_COPY(LockManager);
+
+    void lock(TxnId txn, const LockTarget& target, LockMode mode);
+    // Grants the lock only if that doesn't need any waiting.
+    [[nodiscard]] bool tryLock(TxnId txn, const LockTarget& target,
+                               LockMode mode);
+    void unlockAll(TxnId txn);
+
+    // How many tables and rows are locked by any transaction.
+    [[nodiscard]] std::size_t getLockedTargetCount();
+
+private:
+    struct TargetHash {
+        std::size_t operator()(const LockTarget& target) const;
+    };
+
+    struct Holder {
+        TxnId txn;
+        LockMode mode;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::unordered_map<LockTarget, std::vector<Holder>, TargetHash>
+          holders;
+    };
+
+    // The targets each transaction holds, split by transaction.
+    struct HeldShard {
+        std::mutex mutex;
+        std::unordered_map<TxnId, std::vector<LockTarget>> targets;
+    };
+
+    static constexpr const std::size_t shardCount = 16;
+
+    const std::chrono::milliseconds timeout_;
+    std::array<Shard, shardCount> shards_;
+    std::array<HeldShard, shardCount> heldShards_;
+    std::mutex waitsForMutex_;
+    // The holders each waiting transaction waits for.
+    std::unordered_map<TxnId, std::vector<TxnId>> waitsFor_;
+
+    [[nodiscard]] Shard& _shardOf(const LockTarget& target);
+    // Grants the lock and returns nothing, or returns the holders in the
+    // way. Callers hold the shard mutex.
+    [[nodiscard]] std::vector<TxnId> _grant(Shard& shard, TxnId txn,
+                                            const LockTarget& target,
+                                            LockMode mode);
+    void _startWaiting(TxnId txn, std::vector<TxnId> blockers,
+                       const LockTarget& target);
+    void _stopWaiting(TxnId txn);
+};
+
+}  // namespace ursql
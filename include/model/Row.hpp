@@ -21,6 +21,19 @@ public:
     void serialize(BufferWriter& writer) const override;
     void deserialize(BufferReader& reader) override;
 
+    [[nodiscard]] const std::vector<Value>& getValues() const;
+    [[nodiscard]] std::vector<Value> releaseValues();
+
+    // The size the row takes up in its block once updates are assigned.
+    [[nodiscard]] std::size_t getEncodedSize(
+      const std::vector<std::pair<std::size_t, Value>>& updates) const;
+
+    // Assigns values to fields of a row decoded from block and patches the
+    // block to match. If every assigned field keeps its encoded size, only
+    // those fields are overwritten; otherwise the row is re-encoded.
+    void updateInBlock(Block& block,
+                       std::vector<std::pair<std::size_t, Value>> updates);
+
 private:
     std::vector<Value> values_;
 };
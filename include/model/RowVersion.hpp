@@ -0,0 +1,47 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace ursql {
+
+// Transactions are numbered from 1 each time a database is opened. 0 stands
+// for rows already in the file, which every transaction sees, and for rows
+// nobody deleted.
+using TxnId = std::uint64_t;
+
+// The transactions a reader sees: those started up to `last`, except the
+// ones still running when the snapshot was taken.
+struct Snapshot {
+    TxnId last;
+    std::vector<TxnId> running;
+
+    [[nodiscard]] bool sees(TxnId txn) const {
+        return txn <= last && !std::ranges::binary_search(running, txn);
+    }
+
+    // Row versions deleted before this transaction are invisible to the
+    // snapshot.
+    [[nodiscard]] TxnId horizon() const {
+        return running.empty() ? last + 1 : running.front();
+    }
+};
+
+// The header of a version of a row: the block holding it, the transaction
+// that created it and the one that deleted it.
+struct RowVersion {
+    std::size_t blockNum;
+    TxnId xmin;
+    TxnId xmax;
+
+    [[nodiscard]] bool isLive() const {
+        return xmax == 0;
+    }
+
+    [[nodiscard]] bool visibleTo(const Snapshot& snapshot) const {
+        return snapshot.sees(xmin) && (isLive() || !snapshot.sees(xmax));
+    }
+};
+
+}  // namespace ursql
@@ -8,7 +8,7 @@ namespace ursql {
 
 class TOC : public MonoStorable {
 public:
-    explicit TOC();
+    explicit TOC(std::size_t blockSize);
     ~TOC() override = default;
 
     URSQL_DISABLE_COPY(TOC);
@@ -28,6 +28,8 @@ public:
     [[nodiscard]] std::vector<std::string> getAllEntityNames() const;
 
 private:
+    // Comes first, where Storage looks for it.
+    std::size_t blockSize_;
     std::unordered_map<std::string, std::size_t> entityPosMap_;
 };
 
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <set>
+#include <string>
+
+#include "common/Macros.hpp"
+#include "model/RowVersion.hpp"
+
+namespace ursql {
+
+// An explicit transaction of a session on one database, from BEGIN to COMMIT
+// or ROLLBACK. It reads on the snapshot taken when it began, plus its own
+// changes. Those changes are the row versions stamped with its id, so the
+// only undo records it needs are the names of the tables it changed.
+class Transaction {
+public:
+    Transaction(TxnId id, Snapshot snapshot);
+    ~Transaction() = default;
+
+    URSQL_DISABLE_COPY(Transaction);
+
+    [[nodiscard]] TxnId getId() const;
+    [[nodiscard]] const Snapshot& getSnapshot() const;
+
+    void addChangedTable(const std::string& entityName);
+    [[nodiscard]] const std::set<std::string>& getChangedTables() const;
+
+    // Set once it commits or rolls back, which may happen under the feet of
+    // its session when it's picked as a deadlock victim.
+    void end();
+    [[nodiscard]] bool hasEnded() const;
+
+private:
+    const TxnId id_;
+    const Snapshot snapshot_;
+    std::set<std::string> changedTables_;
+    bool ended_;
+};
+
+}  // namespace ursql
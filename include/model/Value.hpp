@@ -1,10 +1,14 @@
 #pragma once
 
-#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <tuple>
+#include <variant>
+#include <vector>
 
-#include "Storable.hpp"
 #include "parser/TokenEnums.hpp"
 
 namespace ursql {
@@ -15,6 +19,8 @@ enum class ValueType : std::size_t {
     float_type,
     bool_type,
     varchar_type,
+    // Appended so that the encoding of the older types is unchanged.
+    bigint_type,
 };
 
 namespace {
@@ -31,94 +37,125 @@ inline constexpr const std::size_t val_type_ordinal_v =
 }  // namespace
 
 class TokenStream;
-
-class Value : public Storable {
+class BufferReader;
+class BufferWriter;
+
+// A 16-byte tagged value. Numbers and booleans are stored in place, and so
+// are varchars of up to inlineCapacity characters; longer varchars live in a
+// heap buffer owned by the value. Rows of short strings therefore never
+// allocate per cell.
+class Value {
 public:
     using null_t = std::monostate;
     using int_t = int;
     using float_t = float;
     using bool_t = bool;
-    using varchar_t = std::string;
-
-    explicit Value() noexcept(
-      std::is_nothrow_constructible_v<
-        Var, std::in_place_index_t<val_type_ordinal_v<ValueType::null_type>>,
-        null_t>) = default;
-    explicit Value(int_t intVal) noexcept(
-      std::is_nothrow_constructible_v<
-        Var, std::in_place_index_t<val_type_ordinal_v<ValueType::int_type>>,
-        int_t>);
-    explicit Value(float_t floatVal) noexcept(
-      std::is_nothrow_constructible_v<
-        Var, std::in_place_index_t<val_type_ordinal_v<ValueType::float_type>>,
-        float_t>);
-    explicit Value(bool_t boolVal) noexcept(
-      std::is_nothrow_constructible_v<
-        Var, std::in_place_index_t<val_type_ordinal_v<ValueType::bool_type>>,
-        bool_t>);
-    explicit Value(varchar_t varcharVal) noexcept(
-      std::is_nothrow_constructible_v<
-        Var, std::in_place_index_t<val_type_ordinal_v<ValueType::varchar_type>>,
-        std::add_rvalue_reference_t<varchar_t>>);
-
-    ~Value() override = default;
-
-    constexpr Value(const Value& rhs) noexcept(
-      std::is_nothrow_copy_constructible_v<Var>) = default;
-    constexpr Value(Value&& rhs) noexcept(
-      std::is_nothrow_move_constructible_v<Var>) = default;
-    Value& operator=(const Value& rhs) noexcept(
-      std::is_nothrow_copy_assignable_v<Var>) = default;
-    Value& operator=(Value&& rhs) noexcept(
-      std::is_nothrow_move_assignable_v<Var>) = default;
+    using varchar_t = std::string_view;
+    using bigint_t = std::int64_t;
+
+    Value() noexcept;
+    explicit Value(int_t intVal) noexcept;
+    explicit Value(float_t floatVal) noexcept;
+    explicit Value(bool_t boolVal) noexcept;
+    explicit Value(varchar_t varcharVal);
+    explicit Value(bigint_t bigintVal) noexcept;
+
+    ~Value();
+
+    Value(const Value& rhs);
+    Value(Value&& rhs) noexcept;
+    Value& operator=(const Value& rhs);
+    Value& operator=(Value&& rhs) noexcept;
 
     [[nodiscard]] ValueType getType() const;
     [[nodiscard]] bool isNull() const;
     [[nodiscard]] bool castableTo(ValueType type) const;
     [[nodiscard]] Value cast(ValueType type) const;
+    [[nodiscard]] bigint_t toInteger() const;
     [[nodiscard]] std::string toString() const;
     [[nodiscard]] std::size_t displayWidth() const;
+    [[nodiscard]] std::size_t encodedSize() const;
     void show(std::ostream& os) const;
 
+    // The payload of a value of the given type; varchars are viewed, and
+    // the view is valid as long as the value is alive and unmodified.
     template<ValueType type>
-    decltype(auto) raw() const {
-        return std::get<val_type_ordinal_v<type>>(var_);
+    [[nodiscard]] auto raw() const {
+        using T = var_alt_t<type>;
+        if constexpr (type == ValueType::varchar_type) {
+            return _varchar();
+        } else if constexpr (type == ValueType::null_type) {
+            return T();
+        } else {
+            T val;
+            std::memcpy(&val, bytes_, sizeof(T));
+            return val;
+        }
     }
 
-    void serialize(BufferWriter& aWriter) const override;
-    void deserialize(BufferReader& aReader) override;
+    void serialize(BufferWriter& writer) const;
+    void deserialize(BufferReader& reader);
 
     static Value parse(TokenStream& ts);
+    // The narrowest integer value holding the given integer.
+    static Value fromInteger(bigint_t integer);
+
+    static constexpr const std::size_t inlineCapacity = 14;
 
     friend bool operator<(const Value& lhs, const Value& rhs);
     friend bool operator==(const Value& lhs, const Value& rhs);
+    friend bool operator>(const Value& lhs, const Value& rhs);
+    friend bool operator<=(const Value& lhs, const Value& rhs);
+    friend bool operator>=(const Value& lhs, const Value& rhs);
 
 private:
-    using Var = std::variant<null_t, int_t, float_t, bool_t, varchar_t>;
-
-    Var var_;
+    using Alts =
+      std::tuple<null_t, int_t, float_t, bool_t, varchar_t, bigint_t>;
 
     template<ValueType valueType>
-    struct var_alt {
-        using type =
-          std::variant_alternative_t<val_type_ordinal_v<valueType>, Var>;
-    };
+    using var_alt_t = std::tuple_element_t<val_type_ordinal_v<valueType>, Alts>;
 
-    template<ValueType valueType>
-    using var_alt_t = typename var_alt<valueType>::type;
+    // Bytes 0-13 hold the payload: a number, an inline string, or the
+    // pointer and 32-bit length of a heap string at bytes 0 and 8. Byte 14
+    // is the inline string length, or heapMark, and byte 15 the type.
+    static constexpr const std::size_t lengthByte = 14;
+    static constexpr const std::size_t typeByte = 15;
+    static constexpr const unsigned char heapMark = 0xff;
+
+    alignas(std::int64_t) unsigned char bytes_[16];
+
+    template<ValueType type>
+    void _set(var_alt_t<type> val) noexcept {
+        std::memcpy(bytes_, &val, sizeof(val));
+        bytes_[typeByte] = static_cast<unsigned char>(type);
+    }
+
+    [[nodiscard]] bool _onHeap() const noexcept;
+    [[nodiscard]] varchar_t _varchar() const noexcept;
+    void _setVarchar(varchar_t varcharVal);
+    void _release() noexcept;
 
     static_assert(std::is_same_v<null_t, var_alt_t<ValueType::null_type>>,
-                  "null type should match variant index");
+                  "null type should match type ordinal");
     static_assert(std::is_same_v<int_t, var_alt_t<ValueType::int_type>>,
-                  "int type should match variant index");
+                  "int type should match type ordinal");
     static_assert(std::is_same_v<float_t, var_alt_t<ValueType::float_type>>,
-                  "float type should match variant index");
+                  "float type should match type ordinal");
     static_assert(std::is_same_v<bool_t, var_alt_t<ValueType::bool_type>>,
-                  "bool type should match variant index");
+                  "bool type should match type ordinal");
     static_assert(std::is_same_v<varchar_t, var_alt_t<ValueType::varchar_type>>,
-                  "varchar type should match variant index");
+                  "varchar type should match type ordinal");
+    static_assert(std::is_same_v<bigint_t, var_alt_t<ValueType::bigint_type>>,
+                  "bigint type should match type ordinal");
+    static_assert(inlineCapacity <= lengthByte,
+                  "inline strings must not overlap the length byte");
 };
 
+static_assert(sizeof(Value) == 16, "Value should be 16 bytes");
+
+// Values parsed from a statement, which may be allocated from its Arena.
+using ValueList = std::pmr::vector<Value>;
+
 std::ostream& operator<<(std::ostream& os, const Value& val);
 
 }  // namespace ursql
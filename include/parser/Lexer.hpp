@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string_view>
+
+#include "Token.hpp"
+
+namespace ursql {
+
+// Single pass lexer over a contiguous statement. Identifier and text tokens
+// are views into the lexed text, which must outlive them.
+class Lexer {
+public:
+    explicit Lexer(std::string_view text);
+    ~Lexer() = default;
+
+    URSQL_DISABLE_COPY(Lexer);
+
+    [[nodiscard]] TokenList lex(
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+private:
+    const char* cur_;
+    const char* const end_;
+
+    [[nodiscard]] std::string_view _readUntilSeparator();
+    [[nodiscard]] std::string_view _readComparator();
+    [[nodiscard]] std::string_view _readQuoted(char quote);
+};
+
+}  // namespace ursql
@@ -3,6 +3,7 @@
 #include <memory>
 
 #include "TokenStream.hpp"
+#include "common/Arena.hpp"
 #include "exception/UserError.hpp"
 
 namespace ursql {
@@ -12,7 +13,7 @@ class TokenStream;
 
 namespace parser {
 
-std::unique_ptr<Statement> parse(TokenStream& ts);
+ResourcePtr<Statement> parse(TokenStream& ts);
 
 std::string parseNextIdentifier(TokenStream& ts);
 std::string parseNextIdentifierAsLast(TokenStream& ts);
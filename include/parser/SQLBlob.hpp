@@ -1,5 +1,6 @@
 #pragma once
-#include <sstream>
+
+#include <string>
 
 #include "TokenStream.hpp"
 #include "common/Macros.hpp"
@@ -16,23 +17,19 @@ public:
 
     [[nodiscard]] bool ready() const;
 
-    [[nodiscard]] TokenStream tokenize();
+    [[nodiscard]] TokenStream tokenize(
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
     friend std::istream& operator>>(std::istream& input, SQLBlob& blob);
 
 private:
-    std::stringstream buf_;
+    std::string buf_;
     bool ready_ = false;
     bool inSingleQuote_ = false;
     bool inDoubleQuote_ = false;
 
     static constexpr const char delim = ';';
 
-    using CharPredicate = std::function<bool(char)>;
-
-    std::string _readUntil(const CharPredicate& pred);
-    std::string _readUntil(char c);
-    std::string _readWhile(const CharPredicate& pred);
     void _reset();
 };
 
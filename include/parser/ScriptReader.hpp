@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "common/Macros.hpp"
+
+namespace ursql {
+
+// Splits a whole SQL script, such as a dump replayed with `ursql -f`, into
+// statements on ';' outside of quotes. Regular files are memory-mapped and
+// other inputs, e.g. pipes, are read in large blocks; either way statements
+// are handed out as views instead of being copied character by character.
+class ScriptReader {
+public:
+    // Reads from fd, which the caller keeps open for the reader's lifetime.
+    explicit ScriptReader(int fd);
+    ~ScriptReader();
+
+    URSQL_DISABLE_COPY(ScriptReader);
+
+    // Views the next non-blank statement without its ';'; the view is valid
+    // until the following call. Text after the last ';' counts as a final
+    // statement. Returns false once the script is exhausted.
+    bool next(std::string_view& statement);
+
+    static constexpr const std::size_t blockSize = 4 << 20;
+
+private:
+    const int fd_;
+    void* mapping_;
+    std::size_t mappingSize_;
+    std::string buffer_;
+    std::string_view text_;
+    bool exhausted_;
+
+    bool _readBlock();
+};
+
+}  // namespace ursql
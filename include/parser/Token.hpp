@@ -1,8 +1,12 @@
 #pragma once
 
+#include <cstdint>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <variant>
+#include <vector>
 
 #include "TokenEnums.hpp"
 #include "common/Macros.hpp"
@@ -12,9 +16,10 @@ namespace ursql {
 
 enum class TokenType : std::size_t {
     comparator = 0,
+    decimal,
     identifier,
+    integer,
     keyword,
-    number,
     op,
     punctuation,
     text
@@ -105,8 +110,11 @@ public:
     }
 
 private:
-    using Var = std::variant<Comparator, std::string, Keyword, float, Operator,
-                             Punctuation, std::string>;
+    // Identifiers and texts are views into the statement text, which the
+    // owning TokenStream keeps alive.
+    using Var =
+      std::variant<Comparator, float, std::string_view, std::uint64_t, Keyword,
+                   Operator, Punctuation, std::string_view>;
 
     const Var var_;
 
@@ -121,19 +129,26 @@ private:
 
     static_assert(std::is_same_v<Comparator, var_alt_t<TokenType::comparator>>,
                   "Comparator token should be stored as Comparator");
-    static_assert(std::is_same_v<std::string, var_alt_t<TokenType::identifier>>,
-                  "Identifier token should be stored as string");
+    static_assert(std::is_same_v<float, var_alt_t<TokenType::decimal>>,
+                  "Decimal token should be stored as float");
+    static_assert(
+      std::is_same_v<std::string_view, var_alt_t<TokenType::identifier>>,
+      "Identifier token should be stored as string_view");
+    static_assert(std::is_same_v<std::uint64_t, var_alt_t<TokenType::integer>>,
+                  "Integer token should be stored as uint64_t");
     static_assert(std::is_same_v<Keyword, var_alt_t<TokenType::keyword>>,
                   "Keyword token should be stored as Keyword");
-    static_assert(std::is_same_v<float, var_alt_t<TokenType::number>>,
-                  "Number token should be stored as float");
     static_assert(std::is_same_v<Operator, var_alt_t<TokenType::op>>,
                   "Operator token should be stored as Operator");
     static_assert(
       std::is_same_v<Punctuation, var_alt_t<TokenType::punctuation>>,
       "Punctuation token should be stored as Punctuation");
-    static_assert(std::is_same_v<std::string, var_alt_t<TokenType::text>>,
-                  "Text token should be stored as string");
+    static_assert(std::is_same_v<std::string_view, var_alt_t<TokenType::text>>,
+                  "Text token should be stored as string_view");
 };
 
+// Tokens usually live only as long as one statement is parsed, so they may
+// be allocated from a per-statement Arena.
+using TokenList = std::pmr::vector<Token>;
+
 }  // namespace ursql
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <format>
+#include <optional>
 #include <string_view>
 
 namespace ursql {
@@ -17,58 +19,83 @@ bool strIsComparator(std::string_view str);
 Comparator toComparator(std::string_view str);
 bool charIsComparator(char c);
 
+// Every keyword with its SQL spelling. The Keyword enum, the keyword lookup
+// table and the keyword names are all generated from this list.
+#define URSQL_KEYWORDS(X)                  \
+    X(add_kw, "add")                       \
+    X(and_kw, "and")                       \
+    X(asc_kw, "asc")                       \
+    X(auto_increment_kw, "auto_increment") \
+    X(begin_kw, "begin")                   \
+    X(bigint_kw, "bigint")                 \
+    X(block_size_kw, "block_size")         \
+    X(boolean_kw, "boolean")               \
+    X(by_kw, "by")                         \
+    X(char_kw, "char")                     \
+    X(commit_kw, "commit")                 \
+    X(create_kw, "create")                 \
+    X(data_kw, "data")                     \
+    X(database_kw, "database")             \
+    X(databases_kw, "databases")           \
+    X(deallocate_kw, "deallocate")         \
+    X(default_kw, "default")               \
+    X(delete_kw, "delete")                 \
+    X(desc_kw, "desc")                     \
+    X(describe_kw, "describe")             \
+    X(double_kw, "double")                 \
+    X(drop_kw, "drop")                     \
+    X(execute_kw, "execute")               \
+    X(false_kw, "false")                   \
+    X(float_kw, "float")                   \
+    X(from_kw, "from")                     \
+    X(group_kw, "group")                   \
+    X(help_kw, "help")                     \
+    X(in_kw, "in")                         \
+    X(infile_kw, "infile")                 \
+    X(insert_kw, "insert")                 \
+    X(integer_kw, "integer")               \
+    X(into_kw, "into")                     \
+    X(is_kw, "is")                         \
+    X(join_kw, "join")                     \
+    X(key_kw, "key")                       \
+    X(load_kw, "load")                     \
+    X(not_kw, "not")                       \
+    X(null_kw, "null")                     \
+    X(on_kw, "on")                         \
+    X(or_kw, "or")                         \
+    X(order_kw, "order")                   \
+    X(prepare_kw, "prepare")               \
+    X(primary_kw, "primary")               \
+    X(quit_kw, "quit")                     \
+    X(rollback_kw, "rollback")             \
+    X(select_kw, "select")                 \
+    X(set_kw, "set")                       \
+    X(show_kw, "show")                     \
+    X(summary_kw, "summary")               \
+    X(table_kw, "table")                   \
+    X(tables_kw, "tables")                 \
+    X(true_kw, "true")                     \
+    X(truncate_kw, "truncate")             \
+    X(unique_kw, "unique")                 \
+    X(update_kw, "update")                 \
+    X(use_kw, "use")                       \
+    X(using_kw, "using")                   \
+    X(vacuum_kw, "vacuum")                 \
+    X(values_kw, "values")                 \
+    X(varchar_kw, "varchar")               \
+    X(version_kw, "version")               \
+    X(where_kw, "where")
+
 enum class Keyword {
-    add_kw,
-    and_kw,
-    asc_kw,
-    auto_increment_kw,
-    boolean_kw,
-    by_kw,
-    char_kw,
-    create_kw,
-    database_kw,
-    databases_kw,
-    desc_kw,
-    default_kw,
-    delete_kw,
-    describe_kw,
-    double_kw,
-    drop_kw,
-    false_kw,
-    float_kw,
-    from_kw,
-    group_kw,
-    help_kw,
-    in_kw,
-    insert_kw,
-    integer_kw,
-    into_kw,
-    is_kw,
-    key_kw,
-    not_kw,
-    null_kw,
-    or_kw,
-    order_kw,
-    primary_kw,
-    quit_kw,
-    select_kw,
-    set_kw,
-    show_kw,
-    table_kw,
-    tables_kw,
-    true_kw,
-    truncate_kw,
-    unique_kw,
-    update_kw,
-    use_kw,
-    values_kw,
-    varchar_kw,
-    version_kw,
-    where_kw
+#define URSQL_KEYWORD_ENUMERATOR(enumerator, str) enumerator,
+    URSQL_KEYWORDS(URSQL_KEYWORD_ENUMERATOR)
+#undef URSQL_KEYWORD_ENUMERATOR
 };
 
 bool isKeyword(std::string_view str);
 Keyword toKeyword(std::string_view str);
+std::optional<Keyword> findKeyword(std::string_view str);
+std::string_view toString(Keyword keyword);
 
 enum class Operator {
     plus,
@@ -83,10 +110,21 @@ Operator toOperator(char c);
 enum class Punctuation {
     comma,
     lparen,
-    rparen
+    rparen,
+    // A parameter placeholder of a prepared statement.
+    question
 };
 
 bool isPunctuation(char c);
 Punctuation toPunctuation(char c);
 
 }  // namespace ursql
+
+template<>
+struct std::formatter<ursql::Keyword> : std::formatter<std::string_view> {
+    template<typename FormatContext>
+    decltype(auto) format(ursql::Keyword keyword, FormatContext& ctx) const {
+        return std::formatter<std::string_view>::format(
+          ursql::toString(keyword), ctx);
+    }
+};
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <functional>
+#include <memory>
 #include <sstream>
 
 #include "Token.hpp"
+#include "model/Value.hpp"
 
 namespace ursql {
 
@@ -11,7 +13,8 @@ class TokenStream {
 public:
     using TokenPredicate = std::function<bool(const Token&)>;
 
-    explicit TokenStream(std::vector<Token>&& tokens);
+    explicit TokenStream(TokenList&& tokens,
+                         std::shared_ptr<const std::string> source = nullptr);
     ~TokenStream() = default;
 
     URSQL_DISABLE_COPY(TokenStream);
@@ -28,10 +31,27 @@ public:
     bool skipIf(const TokenPredicate& pred);
     bool skipIf(Keyword keyword);
     bool skipIf(Punctuation punctuation);
+    bool skipIf(Comparator comparator);
+    bool skipIf(Operator op);
+
+    // Binds the values of a prepared statement's '?' placeholders, in
+    // order. They must outlive the stream.
+    void bindParams(const ValueList& params);
+    const Value& nextParam();
+
+    // Where the statement nodes and value lists parsed from the stream are
+    // allocated, by default where the tokens are. Tokens that die with the
+    // stream may use a scratch arena while the statement is kept in another.
+    [[nodiscard]] std::pmr::memory_resource* getResource() const noexcept;
+    void setResource(std::pmr::memory_resource* resource) noexcept;
 
 private:
-    std::vector<Token> tokens_;
+    std::shared_ptr<const std::string> source_;
+    TokenList tokens_;
     std::size_t i_;
+    const ValueList* params_;
+    std::size_t paramIndex_;
+    std::pmr::memory_resource* resource_;
 
     std::string _toString(std::size_t i) const;
 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <unordered_map>
 
 #include "common/Macros.hpp"
@@ -14,15 +15,16 @@ enum class BlockType : char {
     free = 'F'
 };
 
-class MonoStorable;
-
+// A block as it lies in the file: its type, then the payload. Every block of
+// a file has the size the file was created with.
 class Block {
 public:
-    explicit Block(BlockType aType = BlockType::free);
-    explicit Block(const MonoStorable& aMonoStorable);
+    explicit Block(BlockType type = BlockType::free,
+                   std::size_t size = defaultSize);
     ~Block() = default;
 
     URSQL_DISABLE_COPY(Block);
+    URSQL_DEFAULT_MOVE(Block);
 
     [[nodiscard]] BlockType getType() const;
 
@@ -32,18 +34,23 @@ public:
 
     [[nodiscard]] char* getData();
 
-    static constexpr const std::size_t size = 1024;
-    static constexpr const std::size_t payloadSize = size - sizeof(BlockType);
+    [[nodiscard]] std::size_t getSize() const;
+    [[nodiscard]] std::size_t getPayloadSize() const;
 
-private:
-    BlockType type_;
+    // The type and the payload together, to be read or written as is.
+    [[nodiscard]] const char* getBytes() const;
+    [[nodiscard]] char* getBytes();
 
-    union {
-        char nullState_;
-        char data_[payloadSize];
-    };
-};
+    // Powers of two from the size of the old fixed blocks up to 64 KiB.
+    [[nodiscard]] static bool isValidSize(std::size_t size);
 
-static_assert(sizeof(Block) == Block::size, "Block size is not 1024");
+    static constexpr const std::size_t minSize = 1024;
+    static constexpr const std::size_t maxSize = 64 << 10;
+    static constexpr const std::size_t defaultSize = 4096;
+
+private:
+    std::size_t size_;
+    std::unique_ptr<char[]> bytes_;
+};
 
 }  // namespace ursql
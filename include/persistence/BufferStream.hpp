@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <type_traits>
 
 #include "common/Macros.hpp"
@@ -8,6 +10,7 @@
 namespace ursql {
 
 class Storable;
+class Value;
 
 namespace detail {
 
@@ -21,6 +24,7 @@ public:
     URSQL_DISABLE_COPY(BufferData);
 
     char* getAndAdvance(std::size_t offset);
+    [[nodiscard]] std::size_t getRemaining() const;
 
 private:
     union {
@@ -49,7 +53,10 @@ public:
     }
 
     BufferReader& operator>>(std::string& str);
+    // Views the string in the buffer instead of copying it.
+    BufferReader& operator>>(std::string_view& str);
     BufferReader& operator>>(Storable& storable);
+    BufferReader& operator>>(Value& value);
 
     template<typename T>
     auto read() {
@@ -58,6 +65,9 @@ public:
         return val;
     }
 
+    // How many bytes are left to read.
+    [[nodiscard]] std::size_t getRemaining() const;
+
 private:
     detail::BufferData bufData_;
 };
@@ -77,8 +87,12 @@ public:
         return *this;
     }
 
-    BufferWriter& operator<<(const std::string& str);
+    BufferWriter& operator<<(std::string_view str);
     BufferWriter& operator<<(const Storable& storable);
+    BufferWriter& operator<<(const Value& value);
+
+    // How many bytes are left to write.
+    [[nodiscard]] std::size_t getRemaining() const;
 
 private:
     detail::BufferData bufData_;
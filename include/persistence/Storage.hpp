@@ -4,55 +4,77 @@
 #include <functional>
 #include <list>
 #include <memory>
+#include <mutex>
+#include <span>
 #include <unordered_map>
+#include <vector>
 
 #include "Block.hpp"
 #include "common/Macros.hpp"
 
-#ifndef ENABLE_BLOCKCACHE
-#endif
-
 namespace ursql {
 
-#ifdef ENABLE_BLOCKCACHE
+// LRU cache of blocks. Frames written through Storage stay dirty in memory
+// until they are evicted or flushed, so repeated writes to a block cost one
+// disk write.
 class BlockCache {
 public:
-    using UseSequence =
-      std::list<std::pair<blocknum_t, std::unique_ptr<Block>>>;
-    using CacheMap = std::unordered_map<blocknum_t, UseSequence::iterator>;
-
-    explicit BlockCache(size_type aCapacity = BlockCache::capacity);
+    struct Frame {
+        std::size_t blockNum;
+        std::unique_ptr<Block> block;
+        bool dirty;
+    };
+
+    explicit BlockCache(std::size_t blockSize,
+                        std::size_t capacity = defaultCapacity);
     ~BlockCache() = default;
 
     URSQL_DISABLE_COPY(BlockCache);
-
-    bool contains(blocknum_t aBlocknum);
-    void put(blocknum_t aBlocknum, const Block& aBlock);
-    const Block& get(blocknum_t aBlocknum);
-
-    static constexpr size_type capacity = 50;
+    URSQL_DEFAULT_MOVE(BlockCache);
+
+    [[nodiscard]] Frame* find(std::size_t blockNum);
+    [[nodiscard]] bool full() const;
+    Frame& insert(std::size_t blockNum);
+    // The least recently used frame, which is evicted next.
+    [[nodiscard]] Frame& getVictim();
+    void evict();
+    void erase(std::size_t blockNum);
+    [[nodiscard]] std::vector<Frame*> getDirtyFrames();
+    // The least recently used dirty frames, which are evicted first.
+    [[nodiscard]] std::vector<Frame*> getColdDirtyFrames(std::size_t count);
+    // Forgets the frames of blocks from blockNum on without writing them.
+    void discardFrom(std::size_t blockNum);
+
+    static constexpr const std::size_t defaultCapacity = 256;
 
 private:
-    const size_type m_capacity;
-    UseSequence m_seq;
-    CacheMap m_pos;
-
-    UseSequence::iterator _touch(blocknum_t aBlocknum);
-    void _add(blocknum_t aBlocknum, const Block& aBlock);
-    void _adjustSize();
-    void _removeTail();
+    using UseSequence = std::list<Frame>;
+    using FrameMap = std::unordered_map<std::size_t, UseSequence::iterator>;
+
+    std::size_t blockSize_;
+    std::size_t capacity_;
+    UseSequence useSeq_;
+    FrameMap frames_;
 };
-#endif
 
 struct OpenExistingFile {};
 
-struct CreateNewFile {};
+struct CreateNewFile {
+    std::size_t blockSize = Block::defaultSize;
+};
 
 class TOC;
 class MonoStorable;
 
 namespace fs = std::filesystem;
 
+// Safe to share between threads: every call holds the storage latch while
+// it touches the block cache or the file. What a block holds is guarded by
+// its owner, e.g. the latch of the table a row block belongs to.
+// The type of every block is kept in memory, read in one pass when the file
+// is opened and updated by each write, so block types never cost a read.
+// The block size is chosen when the file is created. The TOC in block 0
+// leads with it, so that it's known before any block is read.
 class Storage {
 public:
     using BlockVisitor = std::function<bool(Block&, std::size_t)>;
@@ -60,26 +82,70 @@ public:
     Storage(const fs::path& filePath, CreateNewFile);
     Storage(const fs::path& filePath, OpenExistingFile);
 
-    ~Storage() = default;
+    ~Storage();
 
     URSQL_DISABLE_COPY(Storage);
-    URSQL_DEFAULT_MOVE(Storage);
 
+    [[nodiscard]] std::size_t getBlockSize() const;
+
+    // Blocks passed in have the block size of the file.
     void readBlock(Block& block, std::size_t blockNum);
+    // Reads adjacent blocks starting at firstBlockNum from the file at once,
+    // bypassing the cache except to take the cached copies, which may be
+    // newer.
+    void readBlocks(std::size_t firstBlockNum, std::span<Block> blocks);
     void writeBlock(const Block& block, std::size_t blockNum);
+    // Writes adjacent blocks starting at firstBlockNum to the file at once,
+    // bypassing the cache except to keep already cached copies current.
+    void writeBlocks(std::size_t firstBlockNum, std::span<const Block> blocks);
+
+    // Lets the visitor modify a cached block in place. The block is marked
+    // dirty only if the visitor returns true. The visitor runs under the
+    // storage latch and must not call back into the storage.
+    bool updateBlock(std::size_t blockNum, const BlockVisitor& visitor);
+
+    // Writes all dirty blocks back in block order.
+    void flush();
+    // Writes back up to maxBlocks of the dirty blocks next in line for
+    // eviction, so that the blocks evicted for a read are mostly clean.
+    // Returns how many were written.
+    std::size_t writeBackCold(std::size_t maxBlocks);
+
+    // Adds count free blocks to the end of the file in one write, with
+    // their disk space allocated up front so that they lie together, and
+    // returns the number of the first.
+    std::size_t appendFreeBlocks(std::size_t count);
 
     std::size_t getBlockCount();
     BlockType getBlockType(std::size_t blockNum);
+    std::vector<BlockType> getBlockTypes();
+    // Cuts the free blocks at the end off the file, keeping at least
+    // minBlockCount blocks, and returns how many were cut.
+    std::size_t truncateFreeTail(std::size_t minBlockCount = 0);
     void releaseBlock(std::size_t blockNum);
+    void releaseBlocks(std::vector<std::size_t> blockNums);
 
     void save(const MonoStorable& monoStorable);
     void load(MonoStorable& monoStorable);
 
 private:
+    std::mutex latch_;
+    const fs::path filePath_;
     std::fstream file_;
-#ifdef ENABLE_BLOCKCACHE
-    BlockCache m_blockCache;
-#endif
+    // For allocating disk space, which streams can't do.
+    int fd_;
+    const std::size_t blockSize_;
+    BlockCache blockCache_;
+    std::size_t blockCount_;
+    std::vector<BlockType> blockTypes_;
+
+    [[nodiscard]] std::size_t _readBlockSize();
+    void _loadBlockTypes();
+    void _setBlockType(std::size_t blockNum, BlockType blockType);
+    void _releaseBlock(std::size_t blockNum);
+    void _flush();
+    BlockCache::Frame& _fetch(std::size_t blockNum, bool loadFromFile);
+    void _writeBack(BlockCache::Frame& frame);
     void _read(void* dst, std::size_t offset, std::size_t len);
     void _write(const void* src, std::size_t offset, std::size_t len);
 };
@@ -13,7 +13,7 @@ public:
 
     ExecuteResult run(DBManager& dbManager) const override;
 
-    static std::unique_ptr<CreateTableStatement> parse(TokenStream& ts);
+    static ResourcePtr<CreateTableStatement> parse(TokenStream& ts);
 
 private:
     const std::vector<Attribute> attributes_;
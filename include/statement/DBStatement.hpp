@@ -30,12 +30,15 @@ protected:
 
 class CreateDBStatement : public MultiDBStatement {
 public:
-    explicit CreateDBStatement(std::vector<std::string> dbNames);
+    CreateDBStatement(std::vector<std::string> dbNames, std::size_t blockSize);
     ~CreateDBStatement() override = default;
 
     [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
 
-    static std::unique_ptr<CreateDBStatement> parse(TokenStream& ts);
+    static ResourcePtr<CreateDBStatement> parse(TokenStream& ts);
+
+private:
+    const std::size_t blockSize_;
 };
 
 class DropDBStatement : public MultiDBStatement {
@@ -45,7 +48,7 @@ public:
 
     [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
 
-    static std::unique_ptr<DropDBStatement> parse(TokenStream& ts);
+    static ResourcePtr<DropDBStatement> parse(TokenStream& ts);
 };
 
 class UseDBStatement : public SingleDBStatement {
@@ -55,17 +58,22 @@ public:
 
     [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
 
-    static std::unique_ptr<UseDBStatement> parse(TokenStream& ts);
+    static ResourcePtr<UseDBStatement> parse(TokenStream& ts);
 };
 
+// Lists the type of every block, or with SUMMARY, per block type, how many
+// blocks there are and how they are spread over runs of adjacent blocks.
 class DescDBStatement : public SingleDBStatement {
 public:
-    explicit DescDBStatement(std::string dbName);
+    DescDBStatement(std::string dbName, bool summary);
     ~DescDBStatement() override = default;
 
     [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
 
-    static std::unique_ptr<DescDBStatement> parse(TokenStream& ts);
+    static ResourcePtr<DescDBStatement> parse(TokenStream& ts);
+
+private:
+    const bool summary_;
 };
 
 }  // namespace ursql
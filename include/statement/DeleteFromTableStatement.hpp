@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Filter.hpp"
+#include "TableStatement.hpp"
+
+namespace ursql {
+
+class DeleteFromTableStatement : public SingleTableStatement {
+public:
+    DeleteFromTableStatement(std::string tableName, ResourcePtr<Filter> filter);
+    ~DeleteFromTableStatement() override = default;
+
+    [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
+
+    static ResourcePtr<DeleteFromTableStatement> parse(TokenStream& ts);
+
+private:
+    const ResourcePtr<Filter> filter_;
+};
+
+}  // namespace ursql
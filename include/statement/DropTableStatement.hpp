@@ -11,7 +11,7 @@ public:
 
     [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
 
-    static std::unique_ptr<DropTableStatement> parse(TokenStream& ts);
+    static ResourcePtr<DropTableStatement> parse(TokenStream& ts);
 };
 
 }  // namespace ursql
@@ -14,6 +14,9 @@ public:
     void showView(std::ostream& os) const;
     [[nodiscard]] bool quit() const;
 
+    // Hands the view over to callers that consume its data directly.
+    [[nodiscard]] std::unique_ptr<View> releaseView();
+
 private:
     std::unique_ptr<View> view_;
     bool quit_;
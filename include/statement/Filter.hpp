@@ -1,20 +1,39 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 
+#include "common/Arena.hpp"
+#include "execution/RowCursor.hpp"
+
 namespace ursql {
 
 class TokenStream;
 class Entity;
-class Row;
 
+// Parsed WHERE clause. A filter is immutable once parsed; binding it to an
+// entity resolves column names once and yields a predicate over its rows.
+// Like statements, filters are allocated from the memory resource of the
+// stream they are parsed from.
 class Filter {
 public:
+    // Like in SQL, a condition involving NULL may be neither true nor false.
+    // 'and' takes the least of its operands, 'or' the greatest.
+    enum class Truth : char { false_value, unknown, true_value };
+
+    using RowPredicate = std::function<bool(const ValueRow&)>;
+    using RowTruth = std::function<Truth(const ValueRow&)>;
+
     explicit Filter() = default;
-    virtual ~Filter() = 0;
-    [[nodiscard]] virtual bool eval(const Entity& entity, const Row& row) const = 0;
+    virtual ~Filter() = default;
+
+    URSQL_DISABLE_COPY(Filter);
+
+    // Holds on the rows for which the condition is true.
+    [[nodiscard]] RowPredicate bind(const Entity& entity) const;
+    [[nodiscard]] virtual RowTruth bindTruth(const Entity& entity) const = 0;
 
-    static std::unique_ptr<Filter> parse(TokenStream& ts);
+    static ResourcePtr<Filter> parse(TokenStream& ts);
 };
 
-}
+}  // namespace ursql
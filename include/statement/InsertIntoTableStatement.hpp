@@ -7,20 +7,27 @@
 
 namespace ursql {
 
+class PreparedStatement;
+
 class InsertIntoTableStatement : public SingleTableStatement {
 public:
     InsertIntoTableStatement(std::string tableName,
                              std::optional<std::vector<std::string>> attrNames,
-                             std::vector<std::vector<Value>> valueLists);
+                             std::pmr::vector<ValueList> valueLists);
     ~InsertIntoTableStatement() override = default;
 
     [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
 
-    static std::unique_ptr<InsertIntoTableStatement> parse(TokenStream& ts);
+    static ResourcePtr<InsertIntoTableStatement> parse(TokenStream& ts);
+    // Parses an INSERT whose values may be '?' placeholders. The prepared
+    // statement keeps its value lists in the arena the stream allocates
+    // from.
+    static std::unique_ptr<PreparedStatement> prepare(
+      TokenStream& ts, std::unique_ptr<Arena> arena);
 
 private:
     const std::optional<std::vector<std::string>> attrNames_;
-    const std::vector<std::vector<Value>> valueLists_;
+    const std::pmr::vector<ValueList> valueLists_;
 };
 
 }  // namespace ursql
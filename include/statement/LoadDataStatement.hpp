@@ -0,0 +1,20 @@
+#pragma once
+
+#include "TableStatement.hpp"
+
+namespace ursql {
+
+class LoadDataStatement : public SingleTableStatement {
+public:
+    LoadDataStatement(std::string filePath, std::string tableName);
+    ~LoadDataStatement() override = default;
+
+    [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
+
+    static ResourcePtr<LoadDataStatement> parse(TokenStream& ts);
+
+private:
+    const std::string filePath_;
+};
+
+}  // namespace ursql
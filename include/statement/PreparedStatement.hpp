@@ -0,0 +1,81 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Statement.hpp"
+#include "model/Value.hpp"
+
+namespace ursql {
+
+// A statement lexed and parsed once, whose '?' placeholders are bound to
+// new values on every execution. INSERTs additionally keep their resolved
+// columns between executions; other statements are re-parsed from the
+// cached tokens with the values bound. What the statement keeps from
+// preparing is allocated from its own arena.
+class PreparedStatement {
+public:
+    PreparedStatement(std::unique_ptr<Arena> arena, std::size_t paramCount);
+    virtual ~PreparedStatement() = default;
+
+    URSQL_DISABLE_COPY(PreparedStatement);
+
+    [[nodiscard]] std::size_t getParamCount() const;
+
+    ExecuteResult execute(DBManager& dbManager, const ValueList& params);
+
+    static std::unique_ptr<PreparedStatement> prepare(std::string text);
+
+protected:
+    virtual ExecuteResult _execute(DBManager& dbManager,
+                                   const ValueList& params) = 0;
+
+private:
+    // Outlives what subclasses allocate from it.
+    const std::unique_ptr<Arena> arena_;
+    const std::size_t paramCount_;
+};
+
+class PrepareStatement : public Statement {
+public:
+    PrepareStatement(std::string name, std::string text);
+    ~PrepareStatement() override = default;
+
+    [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
+
+    static ResourcePtr<PrepareStatement> parse(TokenStream& ts);
+
+private:
+    const std::string name_;
+    const std::string text_;
+};
+
+class ExecuteStatement : public Statement {
+public:
+    ExecuteStatement(std::string name, ValueList params);
+    ~ExecuteStatement() override = default;
+
+    [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
+
+    static ResourcePtr<ExecuteStatement> parse(TokenStream& ts);
+
+private:
+    const std::string name_;
+    const ValueList params_;
+};
+
+class DeallocateStatement : public Statement {
+public:
+    explicit DeallocateStatement(std::string name);
+    ~DeallocateStatement() override = default;
+
+    [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
+
+    static ResourcePtr<DeallocateStatement> parse(TokenStream& ts);
+
+private:
+    const std::string name_;
+};
+
+}  // namespace ursql
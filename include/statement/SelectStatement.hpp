@@ -1,11 +1,34 @@
 #pragma once
 
+#include <optional>
+
+#include "Filter.hpp"
 #include "TableStatement.hpp"
 
 namespace ursql {
 
 class SelectStatement : public SingleTableStatement {
+public:
+    struct JoinClause {
+        std::string tableName;
+        std::string leftAttrName;
+        std::string rightAttrName;
+    };
+
+    SelectStatement(std::string tableName,
+                    std::optional<std::vector<std::string>> attrNames,
+                    std::optional<JoinClause> joinClause,
+                    ResourcePtr<Filter> filter);
+    ~SelectStatement() override = default;
+
+    [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
+
+    static ResourcePtr<SelectStatement> parse(TokenStream& ts);
 
+private:
+    const std::optional<std::vector<std::string>> attrNames_;
+    const std::optional<JoinClause> joinClause_;
+    const ResourcePtr<Filter> filter_;
 };
 
-}
+}  // namespace ursql
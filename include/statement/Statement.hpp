@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ExecuteResult.hpp"
+#include "common/Arena.hpp"
 #include "common/Macros.hpp"
 #include "parser/TokenEnums.hpp"
 
@@ -9,6 +10,8 @@ namespace ursql {
 class DBManager;
 class TokenStream;
 
+// Statements are allocated from the memory resource of the stream they are
+// parsed from, so they must not outlive the Arena it may belong to.
 class Statement {
 public:
     explicit Statement() = default;
@@ -58,7 +61,7 @@ public:
 
     [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
 
-    static std::unique_ptr<ShowDBStatement> parse(TokenStream& ts);
+    static ResourcePtr<ShowDBStatement> parse(TokenStream& ts);
 };
 
 class ShowTablesStatement : public Statement {
@@ -68,7 +71,7 @@ public:
 
     [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
 
-    static std::unique_ptr<ShowTablesStatement> parse(TokenStream& ts);
+    static ResourcePtr<ShowTablesStatement> parse(TokenStream& ts);
 };
 
 }  // namespace ursql
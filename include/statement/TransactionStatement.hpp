@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Statement.hpp"
+
+namespace ursql {
+
+class BeginStatement : public Statement {
+public:
+    explicit BeginStatement() = default;
+    ~BeginStatement() override = default;
+
+    [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
+};
+
+class CommitStatement : public Statement {
+public:
+    explicit CommitStatement() = default;
+    ~CommitStatement() override = default;
+
+    [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
+};
+
+class RollbackStatement : public Statement {
+public:
+    explicit RollbackStatement() = default;
+    ~RollbackStatement() override = default;
+
+    [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
+};
+
+}  // namespace ursql
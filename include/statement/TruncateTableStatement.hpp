@@ -0,0 +1,17 @@
+#pragma once
+
+#include "TableStatement.hpp"
+
+namespace ursql {
+
+class TruncateTableStatement : public SingleTableStatement {
+public:
+    explicit TruncateTableStatement(std::string tableName);
+    ~TruncateTableStatement() override = default;
+
+    [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
+
+    static ResourcePtr<TruncateTableStatement> parse(TokenStream& ts);
+};
+
+}  // namespace ursql
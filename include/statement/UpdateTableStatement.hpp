@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Filter.hpp"
+#include "TableStatement.hpp"
+#include "model/Value.hpp"
+
+namespace ursql {
+
+class UpdateTableStatement : public SingleTableStatement {
+public:
+    using Assignment = std::pair<std::string, Value>;
+
+    UpdateTableStatement(std::string tableName,
+                         std::vector<Assignment> assignments,
+                         ResourcePtr<Filter> filter);
+    ~UpdateTableStatement() override = default;
+
+    [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
+
+    static ResourcePtr<UpdateTableStatement> parse(TokenStream& ts);
+
+private:
+    const std::vector<Assignment> assignments_;
+    const ResourcePtr<Filter> filter_;
+};
+
+}  // namespace ursql
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <optional>
+
+#include "Statement.hpp"
+
+namespace ursql {
+
+class TokenStream;
+
+// Compacts a table, or every table of the active database.
+class VacuumStatement : public Statement {
+public:
+    explicit VacuumStatement(std::optional<std::string> tableName);
+    ~VacuumStatement() override = default;
+
+    [[nodiscard]] ExecuteResult run(DBManager& dbManager) const override;
+
+    static ResourcePtr<VacuumStatement> parse(TokenStream& ts);
+
+private:
+    std::optional<std::string> tableName_;
+};
+
+}  // namespace ursql
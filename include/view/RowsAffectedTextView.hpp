@@ -1,11 +1,20 @@
-#include "TextView.hpp"
+#pragma once
+
+#include "View.hpp"
 
 namespace ursql {
 
-class RowsAffectedTextView : public TextView {
+class RowsAffectedTextView : public View {
 public:
     explicit RowsAffectedTextView(std::size_t numRows);
     ~RowsAffectedTextView() override = default;
+
+    void show(std::ostream& os) const override;
+
+    [[nodiscard]] std::size_t getNumRows() const;
+
+private:
+    const std::size_t numRows_;
 };
 
 }  // namespace ursql
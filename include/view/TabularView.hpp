@@ -15,6 +15,9 @@ public:
 
     void show(std::ostream& os) const override;
 
+    [[nodiscard]] const std::vector<std::string>& getHeaders() const;
+    [[nodiscard]] const std::vector<std::vector<Value>>& getValueRows() const;
+
 private:
     const std::vector<std::string> headers_;
     const std::vector<std::vector<Value>> valueRows_;
@@ -11,6 +11,8 @@ public:
 
     void show(std::ostream& os) const override;
 
+    [[nodiscard]] const std::string& getText() const;
+
 private:
     const std::string text_;
 };
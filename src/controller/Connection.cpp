@@ -0,0 +1,104 @@
+#include "controller/Connection.hpp"
+
+#include <format>
+
+#include "common/Arena.hpp"
+#include "exception/UserError.hpp"
+#include "parser/Lexer.hpp"
+#include "parser/Parser.hpp"
+#include "parser/TokenStream.hpp"
+#include "statement/PreparedStatement.hpp"
+#include "view/RowsAffectedTextView.hpp"
+#include "view/TabularView.hpp"
+#include "view/TextView.hpp"
+
+namespace ursql {
+
+Connection::Result::Result(std::unique_ptr<View> view)
+    : view_(std::move(view)) {}
+
+Connection::Result::~Result() = default;
+
+bool Connection::Result::hasRows() const {
+    return dynamic_cast<const TabularView*>(view_.get()) != nullptr;
+}
+
+const std::vector<std::string>& Connection::Result::getColumnNames() const {
+    static const std::vector<std::string> none;
+    auto* tabular = dynamic_cast<const TabularView*>(view_.get());
+    return tabular ? tabular->getHeaders() : none;
+}
+
+const std::vector<std::vector<Value>>& Connection::Result::getRows() const {
+    static const std::vector<std::vector<Value>> none;
+    auto* tabular = dynamic_cast<const TabularView*>(view_.get());
+    return tabular ? tabular->getValueRows() : none;
+}
+
+std::size_t Connection::Result::getRowsAffected() const {
+    auto* rowsAffected =
+      dynamic_cast<const RowsAffectedTextView*>(view_.get());
+    return rowsAffected ? rowsAffected->getNumRows() : 0;
+}
+
+std::string_view Connection::Result::getMessage() const {
+    auto* text = dynamic_cast<const TextView*>(view_.get());
+    return text ? std::string_view(text->getText()) : std::string_view();
+}
+
+Connection::Connection(const fs::path& dbDirectoryPath,
+                       fs::path dbFileExtension)
+    : dbManager_(dbDirectoryPath, std::move(dbFileExtension)) {}
+
+Connection::~Connection() = default;
+
+void Connection::open(const std::string& dbName, bool createIfMissing) {
+    if (createIfMissing && !dbManager_.databaseExists(dbName)) {
+        dbManager_.createDatabases({ dbName });
+    }
+    dbManager_.useDatabase(dbName);
+}
+
+Connection::Result Connection::execute(std::string_view sql) {
+    Arena arena;
+    TokenStream ts(Lexer(sql).lex(arena.resource()));
+    return Result(parser::parse(ts)->run(dbManager_).releaseView());
+}
+
+std::unique_ptr<PreparedStatement> Connection::prepare(std::string sql) {
+    return PreparedStatement::prepare(std::move(sql));
+}
+
+Connection::Result Connection::execute(PreparedStatement& statement,
+                                       const ValueList& params) {
+    return Result(statement.execute(dbManager_, params).releaseView());
+}
+
+std::size_t Connection::append(const std::string& tableName,
+                               const std::vector<std::string>& columnNames,
+                               std::vector<std::vector<Value>> columns) {
+    Database* activeDB = dbManager_.getActiveDB();
+    URSQL_EXPECT(activeDB, NoActiveDB, );
+    URSQL_EXPECT(columns.size() == columnNames.size(), MisMatch,
+                 std::format("{} columns for {} names", columns.size(),
+                             columnNames.size()));
+    std::size_t numRows = columns.empty() ? 0 : columns.front().size();
+    for (auto& column : columns) {
+        URSQL_EXPECT(column.size() == numRows, MisMatch,
+                     std::format("column of {} values in a batch of {} rows",
+                                 column.size(), numRows));
+    }
+    Database::InsertPlan plan = activeDB->planInsert(tableName, columnNames);
+    std::pmr::vector<ValueList> valueLists(numRows);
+    for (std::size_t i = 0; i < numRows; ++i) {
+        valueLists[i].reserve(columns.size());
+        for (auto& column : columns) {
+            valueLists[i].push_back(std::move(column[i]));
+        }
+    }
+    activeDB->insertRows(plan, std::move(valueLists),
+                         dbManager_.getTransaction());
+    return numRows;
+}
+
+}  // namespace ursql
@@ -1,85 +1,112 @@
 #include "controller/DBManager.hpp"
 
+#include <algorithm>
 #include <format>
 
-#include "exception/InternalError.hpp"
+#include "controller/DatabasePool.hpp"
 #include "exception/UserError.hpp"
+#include "statement/PreparedStatement.hpp"
 
 namespace ursql {
 
 DBManager::DBManager(const fs::path& dbDirectoryPath, fs::path dbFileExtension)
-    : dbDirectoryPath_(fs::weakly_canonical(dbDirectoryPath)),
-      dbFileExtension_(std::move(dbFileExtension)) {}
+    : DBManager(std::make_shared<DatabasePool>(dbDirectoryPath,
+                                               std::move(dbFileExtension))) {}
+
+DBManager::DBManager(std::shared_ptr<DatabasePool> pool)
+    : pool_(std::move(pool)),
+      activeDB_(),
+      transaction_(),
+      preparedStatements_() {}
+
+DBManager::~DBManager() {
+    rollbackTransaction();
+}
 
 Database* DBManager::getActiveDB() {
     return activeDB_.get();
 }
 
-std::unique_ptr<Database> DBManager::getExistingDBByName(
+std::shared_ptr<Database> DBManager::getExistingDBByName(
   const std::string& dbName) {
-    URSQL_EXPECT(databaseExists(dbName), DoesNotExist, dbName);
-    return std::make_unique<Database>(dbName, _dbName2Path(dbName),
-                                      OpenExistingFile{});
+    return pool_->open(dbName);
 }
 
 bool DBManager::databaseExists(const std::string& dbName) {
-    return fs::exists(_dbName2Path(dbName));
+    return pool_->exists(dbName);
 }
 
-void DBManager::createDatabases(const std::vector<std::string>& dbNames) {
-    std::ranges::for_each(dbNames, [this](auto&& dbName) {
-        URSQL_EXPECT(!databaseExists(dbName), AlreadyExists, dbName);
-    });
-    std::ranges::for_each(dbNames, [this](auto&& dbName) {
-        Database(dbName, _dbName2Path(dbName), CreateNewFile{});
-    });
+void DBManager::createDatabases(const std::vector<std::string>& dbNames,
+                                std::size_t blockSize) {
+    commitTransaction();
+    pool_->create(dbNames, blockSize);
 }
 
 void DBManager::dropDatabases(const std::vector<std::string>& dbNames) {
-    std::ranges::for_each(dbNames, [this](auto&& dbName) {
-        URSQL_EXPECT(databaseExists(dbName), DoesNotExist, dbName);
-    });
-    std::ranges::for_each(dbNames, [this](auto&& dbName) {
-        URSQL_EXPECT(fs::remove(_dbName2Path(dbName)), FileAccessError,
-                     std::format("unable to drop db {}", dbName));
-    });
+    commitTransaction();
+    pool_->drop(dbNames);
+    if (activeDB_ && std::ranges::find(dbNames, activeDB_->getName()) !=
+                       std::end(dbNames))
+    {
+        activeDB_.reset();
+    }
 }
 
 void DBManager::useDatabase(const std::string& dbName) {
     if (!activeDB_ || activeDB_->getName() != dbName) {
-        activeDB_ = getExistingDBByName(dbName);
+        URSQL_EXPECT(!getTransaction(), InvalidCommand,
+                     "can't switch databases inside a transaction");
+        activeDB_ = pool_->open(dbName);
     }
 }
 
 std::vector<std::string> DBManager::getDatabaseNames() {
-    std::vector<std::string> dbNames;
-    std::ranges::for_each(
-      fs::directory_iterator(dbDirectoryPath_), [&](auto& entry) {
-          std::optional<std::string> dbNameOpt = _dirEnt2DbName(entry);
-          if (dbNameOpt.has_value()) {
-              dbNames.push_back(std::move(dbNameOpt.value()));
-          }
-      });
-    return dbNames;
+    return pool_->getNames();
 }
 
-fs::path DBManager::_dbName2Path(const std::string& dbName) {
-    return (dbDirectoryPath_ / dbName).replace_extension(dbFileExtension_);
+void DBManager::beginTransaction() {
+    URSQL_EXPECT(activeDB_, NoActiveDB, );
+    commitTransaction();
+    transaction_ = activeDB_->beginTransaction();
 }
 
-std::optional<std::string> DBManager::_dirEnt2DbName(
-  const fs::directory_entry& entry) {
-    auto& path = entry.path();
-    URSQL_ASSERT(
-      path.parent_path() == dbDirectoryPath_,
-      std::format("db file parent path should match. Expected={}, Actual={}",
-                  dbDirectoryPath_.native(), path.parent_path().native()));
-    if (!entry.is_regular_file() || path.extension() != dbFileExtension_ ||
-        !path.has_stem())
-    {
-        return std::nullopt;
+void DBManager::commitTransaction() {
+    if (getTransaction()) {
+        std::unique_ptr<Transaction> transaction = std::move(transaction_);
+        activeDB_->commit(*transaction);
+    }
+}
+
+void DBManager::rollbackTransaction() {
+    if (getTransaction()) {
+        std::unique_ptr<Transaction> transaction = std::move(transaction_);
+        activeDB_->rollback(*transaction);
     }
-    return path.stem();
+}
+
+Transaction* DBManager::getTransaction() {
+    // A deadlock victim has already been rolled back.
+    if (transaction_ && transaction_->hasEnded()) {
+        transaction_.reset();
+    }
+    return transaction_.get();
+}
+
+void DBManager::addPreparedStatement(
+  const std::string& name, std::unique_ptr<PreparedStatement> statement) {
+    preparedStatements_.insert_or_assign(name, std::move(statement));
+}
+
+PreparedStatement& DBManager::getPreparedStatement(const std::string& name) {
+    auto it = preparedStatements_.find(name);
+    URSQL_EXPECT(it != std::end(preparedStatements_), DoesNotExist,
+                 std::format("prepared statement {}", name));
+    return *it->second;
+}
+
+void DBManager::deallocatePreparedStatement(const std::string& name) {
+    URSQL_EXPECT(preparedStatements_.erase(name) > 0, DoesNotExist,
+                 std::format("prepared statement {}", name));
 }
 
 }  // namespace ursql
@@ -0,0 +1,134 @@
+#include "controller/DatabasePool.hpp"
+
+#include <format>
+
+#include "exception/InternalError.hpp"
+#include "exception/UserError.hpp"
+
+namespace ursql {
+
+DatabasePool::DatabasePool(const fs::path& dbDirectoryPath,
+                           fs::path dbFileExtension,
+                           std::size_t cacheCapacity)
+    : dbDirectoryPath_(fs::weakly_canonical(dbDirectoryPath)),
+      dbFileExtension_(std::move(dbFileExtension)),
+      cacheCapacity_(cacheCapacity),
+      mutex_(),
+      openDBs_(),
+      recentDBs_() {}
+
+std::shared_ptr<Database> DatabasePool::open(const std::string& dbName) {
+    // Declared first, so that it's closed after the mutex is let go.
+    std::shared_ptr<Database> evicted;
+    std::scoped_lock lock(mutex_);
+    auto it = openDBs_.find(dbName);
+    if (it != std::end(openDBs_)) {
+        if (std::shared_ptr<Database> database = it->second.lock()) {
+            evicted = _touch(database);
+            return database;
+        }
+    }
+    URSQL_EXPECT(_exists(dbName), DoesNotExist, dbName);
+    auto database = std::make_shared<Database>(dbName, _dbName2Path(dbName),
+                                               OpenExistingFile{});
+    openDBs_.insert_or_assign(dbName, database);
+    evicted = _touch(database);
+    return database;
+}
+
+bool DatabasePool::exists(const std::string& dbName) {
+    std::scoped_lock lock(mutex_);
+    return _exists(dbName);
+}
+
+void DatabasePool::create(const std::vector<std::string>& dbNames,
+                          std::size_t blockSize) {
+    std::scoped_lock lock(mutex_);
+    std::ranges::for_each(dbNames, [this](auto&& dbName) {
+        URSQL_EXPECT(!_exists(dbName), AlreadyExists, dbName);
+    });
+    std::ranges::for_each(dbNames, [this, blockSize](auto&& dbName) {
+        Database(dbName, _dbName2Path(dbName), CreateNewFile{ blockSize });
+    });
+}
+
+void DatabasePool::drop(const std::vector<std::string>& dbNames) {
+    std::scoped_lock lock(mutex_);
+    std::ranges::for_each(dbNames, [this](auto&& dbName) {
+        URSQL_EXPECT(_exists(dbName), DoesNotExist, dbName);
+    });
+    std::ranges::for_each(dbNames, [this](auto&& dbName) {
+        std::erase_if(recentDBs_, [&dbName](auto& database) {
+            return database->getName() == dbName;
+        });
+        openDBs_.erase(dbName);
+        URSQL_EXPECT(fs::remove(_dbName2Path(dbName)), FileAccessError,
+                     std::format("unable to drop db {}", dbName));
+    });
+}
+
+std::vector<std::string> DatabasePool::getNames() {
+    std::scoped_lock lock(mutex_);
+    std::vector<std::string> dbNames;
+    std::ranges::for_each(
+      fs::directory_iterator(dbDirectoryPath_), [&](auto& entry) {
+          std::optional<std::string> dbNameOpt = _dirEnt2DbName(entry);
+          if (dbNameOpt.has_value()) {
+              dbNames.push_back(std::move(dbNameOpt.value()));
+          }
+      });
+    return dbNames;
+}
+
+std::vector<std::shared_ptr<Database>> DatabasePool::getOpenDatabases() {
+    std::scoped_lock lock(mutex_);
+    std::vector<std::shared_ptr<Database>> databases;
+    for (auto& [_, openDB] : openDBs_) {
+        if (std::shared_ptr<Database> database = openDB.lock()) {
+            databases.push_back(std::move(database));
+        }
+    }
+    return databases;
+}
+
+std::shared_ptr<Database> DatabasePool::_touch(
+  std::shared_ptr<Database> database) {
+    if (auto it = std::ranges::find(recentDBs_, database);
+        it != std::end(recentDBs_))
+    {
+        recentDBs_.splice(std::begin(recentDBs_), recentDBs_, it);
+        return nullptr;
+    }
+    recentDBs_.push_front(std::move(database));
+    if (recentDBs_.size() <= cacheCapacity_) {
+        return nullptr;
+    }
+    std::shared_ptr<Database> evicted = std::move(recentDBs_.back());
+    recentDBs_.pop_back();
+    return evicted;
+}
+
+bool DatabasePool::_exists(const std::string& dbName) {
+    return fs::exists(_dbName2Path(dbName));
+}
+
+fs::path DatabasePool::_dbName2Path(const std::string& dbName) {
+    return (dbDirectoryPath_ / dbName).replace_extension(dbFileExtension_);
+}
+
+std::optional<std::string> DatabasePool::_dirEnt2DbName(
+  const fs::directory_entry& entry) {
+    auto& path = entry.path();
+    URSQL_ASSERT(
+      path.parent_path() == dbDirectoryPath_,
+      std::format("db file parent path should match. Expected={}, Actual={}",
+                  dbDirectoryPath_.native(), path.parent_path().native()));
+    if (!entry.is_regular_file() || path.extension() != dbFileExtension_ ||
+        !path.has_stem())
+    {
+        return std::nullopt;
+    }
+    return path.stem();
+}
+
+}  // namespace ursql
@@ -0,0 +1,503 @@
+#include "controller/Server.hpp"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <sstream>
+#include <thread>
+
+#include "common/Messaging.hpp"
+#include "controller/DBManager.hpp"
+#include "exception/InternalError.hpp"
+#include "parser/Parser.hpp"
+#include "parser/SQLBlob.hpp"
+#include "statement/Statement.hpp"
+
+namespace ursql {
+
+namespace {
+
+constexpr const std::size_t readSize = 64 << 10;
+// Output is handed to the event loop at least this often while a session
+// works through a long run of statements.
+constexpr const std::size_t outputBatchSize = 64 << 10;
+// How often row versions left behind by long reads are looked for.
+constexpr const std::chrono::seconds vacuumInterval(1);
+// How many rows each of those rounds moves at most to compact a database.
+constexpr const std::size_t vacuumRowsPerRound = 256;
+// How often dirty blocks are trickled out, a share of the rate at a time.
+constexpr const std::chrono::milliseconds writeBehindTick(100);
+
+// A statement parsed ahead of its execution, or the error parsing it. The
+// statements parsed together share an arena, which goes with the last.
+struct ParsedStatement {
+    std::shared_ptr<Arena> arena;
+    ResourcePtr<Statement> pStmt;
+    std::exception_ptr error;
+};
+
+[[noreturn]] void throwSystemError(std::string_view what) {
+    URSQL_THROW_NORMAL(FileAccessError,
+                       std::format("{}: {}", what, std::strerror(errno)));
+}
+
+}  // namespace
+
+struct Server::Session {
+    Session(int fd, std::shared_ptr<DatabasePool> pool)
+        : fd(fd),
+          dbManager(std::move(pool)) {}
+
+    ~Session() {
+        ::close(fd);
+    }
+
+    URSQL_DISABLE_COPY(Session);
+
+    const int fd;
+
+    // Owned by the event loop.
+    SQLBlob blob;
+    std::string sending;
+    // The client has shut down its sending side, or the connection broke.
+    bool eof = false;
+    bool broken = false;
+    std::uint32_t watching = EPOLLIN | EPOLLRDHUP;
+
+    // Used by one worker at a time.
+    DBManager dbManager;
+
+    std::mutex mutex;
+    std::deque<ParsedStatement> statements;
+    std::string output;
+    bool running = false;
+    bool quit = false;
+};
+
+Server::Server(const fs::path& socketPath, std::shared_ptr<DatabasePool> pool,
+               std::size_t workerCount, WriteBehindOptions writeBehind)
+    : socketPath_(socketPath),
+      pool_(std::move(pool)),
+      workerCount_(std::max<std::size_t>(workerCount, 1)),
+      writeBehind_(writeBehind),
+      listenFd_(-1),
+      epollFd_(-1),
+      wakeFd_(-1),
+      stopping_(false),
+      sessions_(),
+      arena_(),
+      queueMutex_(),
+      queueCond_(),
+      runnable_(),
+      withOutput_() {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    URSQL_EXPECT(
+      socketPath_.native().size() < sizeof(addr.sun_path), FileAccessError,
+      std::format("socket path {} is too long", socketPath_.native()));
+    std::strcpy(addr.sun_path, socketPath_.c_str());
+    std::error_code ec;
+    fs::remove(socketPath_, ec);
+
+    listenFd_ =
+      ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        throwSystemError("socket");
+    }
+    if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) !=
+          0 ||
+        ::listen(listenFd_, SOMAXCONN) != 0)
+    {
+        ::close(listenFd_);
+        throwSystemError(socketPath_.native());
+    }
+    epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || wakeFd_ < 0) {
+        throwSystemError("epoll");
+    }
+    for (int fd : { listenFd_, wakeFd_ }) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            throwSystemError("epoll_ctl");
+        }
+    }
+}
+
+Server::~Server() {
+    sessions_.clear();
+    for (int fd : { listenFd_, epollFd_, wakeFd_ }) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    std::error_code ec;
+    fs::remove(socketPath_, ec);
+}
+
+std::size_t Server::defaultWorkerCount() {
+    return std::max(std::thread::hardware_concurrency(), 2u);
+}
+
+void Server::run() {
+    std::vector<std::jthread> workers;
+    workers.reserve(workerCount_);
+    for (std::size_t i = 0; i < workerCount_; ++i) {
+        workers.emplace_back([this]() {
+            _work();
+        });
+    }
+    std::jthread vacuum([this](std::stop_token stopToken) {
+        _vacuum(stopToken);
+    });
+    std::jthread writeBehind([this](std::stop_token stopToken) {
+        _writeBehind(stopToken);
+    });
+    constexpr const int maxEvents = 64;
+    epoll_event events[maxEvents];
+    while (!stopping_) {
+        int n = ::epoll_wait(epollFd_, events, maxEvents, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            stop();
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listenFd_) {
+                _accept();
+                continue;
+            }
+            if (fd == wakeFd_) {
+                std::uint64_t count;
+                (void)::read(wakeFd_, &count, sizeof(count));
+                std::vector<std::shared_ptr<Session>> withOutput;
+                {
+                    std::scoped_lock lock(queueMutex_);
+                    withOutput.swap(withOutput_);
+                }
+                for (auto& session : withOutput) {
+                    // The session may have been closed since.
+                    auto it = sessions_.find(session->fd);
+                    if (it != std::end(sessions_) && it->second == session) {
+                        _flush(*session);
+                        _closeIfDone(*session);
+                    }
+                }
+                continue;
+            }
+            auto it = sessions_.find(fd);
+            if (it == std::end(sessions_)) {
+                continue;
+            }
+            std::shared_ptr<Session> session = it->second;
+            if (events[i].events &
+                (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+            {
+                _read(session);
+            }
+            if (events[i].events & EPOLLOUT) {
+                _flush(*session);
+            }
+            _closeIfDone(*session);
+        }
+    }
+    {
+        std::scoped_lock lock(queueMutex_);
+        runnable_.clear();
+    }
+    queueCond_.notify_all();
+}
+
+void Server::stop() noexcept {
+    stopping_ = true;
+    _wake();
+}
+
+void Server::_accept() {
+    while (true) {
+        int fd = ::accept4(listenFd_, nullptr, nullptr,
+                           SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            // EAGAIN once the backlog is drained; errors only drop the
+            // connection being accepted.
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            return;
+        }
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        if (::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            ::close(fd);
+            continue;
+        }
+        sessions_.insert_or_assign(fd, std::make_shared<Session>(fd, pool_));
+    }
+}
+
+void Server::_read(const std::shared_ptr<Session>& session) {
+    char buf[readSize];
+    while (!session->eof) {
+        ssize_t n = ::read(session->fd, buf, sizeof(buf));
+        if (n > 0) {
+            _parse(session,
+                   std::string_view(buf, static_cast<std::size_t>(n)));
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && errno == EAGAIN) {
+            break;
+        } else {
+            session->eof = true;
+            session->broken = n < 0;
+        }
+    }
+    _watch(*session);
+}
+
+void Server::_parse(const std::shared_ptr<Session>& session,
+                    std::string_view text) {
+    std::deque<ParsedStatement> parsed;
+    auto batchArena = std::make_shared<Arena>();
+    std::istringstream input{ std::string(text) };
+    while (input >> session->blob) {
+        if (!session->blob.ready()) {
+            continue;
+        }
+        try {
+            TokenStream tokenStream =
+              session->blob.tokenize(arena_.resource());
+            tokenStream.setResource(batchArena->resource());
+            parsed.push_back(
+              { batchArena, parser::parse(tokenStream), nullptr });
+        } catch (const std::exception&) {
+            parsed.push_back({ nullptr, nullptr, std::current_exception() });
+        }
+        arena_.reset();
+    }
+    if (parsed.empty()) {
+        return;
+    }
+    {
+        std::scoped_lock lock(session->mutex);
+        if (session->quit) {
+            return;
+        }
+        std::ranges::move(parsed, std::back_inserter(session->statements));
+        if (session->running) {
+            return;
+        }
+        session->running = true;
+    }
+    {
+        std::scoped_lock lock(queueMutex_);
+        runnable_.push_back(session);
+    }
+    queueCond_.notify_one();
+}
+
+void Server::_flush(Session& session) {
+    {
+        std::scoped_lock lock(session.mutex);
+        session.sending += session.output;
+        session.output.clear();
+    }
+    std::size_t sent = 0;
+    while (sent < session.sending.size()) {
+        ssize_t n = ::send(session.fd, session.sending.data() + sent,
+                           session.sending.size() - sent, MSG_NOSIGNAL);
+        if (n >= 0) {
+            sent += static_cast<std::size_t>(n);
+        } else if (errno != EINTR) {
+            if (errno != EAGAIN) {
+                // The client is gone; what it was sent no longer matters.
+                session.eof = true;
+                session.broken = true;
+                sent = session.sending.size();
+            }
+            break;
+        }
+    }
+    session.sending.erase(0, sent);
+    _watch(session);
+}
+
+void Server::_watch(Session& session) {
+    // Level-triggered, so a closed input must not be watched any more.
+    std::uint32_t events = 0;
+    if (!session.eof) {
+        events |= EPOLLIN | EPOLLRDHUP;
+    }
+    if (!session.sending.empty()) {
+        events |= EPOLLOUT;
+    }
+    if (events != session.watching) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = session.fd;
+        (void)::epoll_ctl(epollFd_, EPOLL_CTL_MOD, session.fd, &event);
+        session.watching = events;
+    }
+}
+
+void Server::_closeIfDone(Session& session) {
+    {
+        std::scoped_lock lock(session.mutex);
+        if (!(session.eof || session.quit) || session.running ||
+            !session.output.empty())
+        {
+            return;
+        }
+    }
+    if (!session.sending.empty() && !session.broken) {
+        return;
+    }
+    (void)::epoll_ctl(epollFd_, EPOLL_CTL_DEL, session.fd, nullptr);
+    sessions_.erase(session.fd);
+}
+
+void Server::_work() {
+    while (true) {
+        std::shared_ptr<Session> session;
+        {
+            std::unique_lock lock(queueMutex_);
+            queueCond_.wait(lock, [this]() {
+                return stopping_ || !runnable_.empty();
+            });
+            if (stopping_) {
+                return;
+            }
+            session = std::move(runnable_.front());
+            runnable_.pop_front();
+        }
+        _runStatements(session);
+    }
+}
+
+void Server::_vacuum(std::stop_token stopToken) {
+    std::mutex mutex;
+    std::condition_variable_any cond;
+    std::unique_lock lock(mutex);
+    while (!cond.wait_for(lock, stopToken, vacuumInterval, [&stopToken]() {
+        return stopToken.stop_requested();
+    }))
+    {
+        for (auto& database : pool_->getOpenDatabases()) {
+            // A database that fails is tried again next round, and the
+            // others go on meanwhile.
+            try {
+                database->reclaimVersions();
+                database->vacuum(std::nullopt, vacuumRowsPerRound);
+            } catch (const std::exception& e) {
+                err << std::format("vacuuming {} failed: {}\n",
+                                   database->getName(), e.what());
+            }
+        }
+    }
+}
+
+void Server::_writeBehind(std::stop_token stopToken) {
+    std::size_t blocksPerTick = std::max<std::size_t>(
+      writeBehind_.dirtyBlocksPerSecond * writeBehindTick.count() / 1000, 1);
+    auto nextCheckpoint =
+      std::chrono::steady_clock::now() + writeBehind_.checkpointInterval;
+    std::mutex mutex;
+    std::condition_variable_any cond;
+    std::unique_lock lock(mutex);
+    while (!cond.wait_for(lock, stopToken, writeBehindTick, [&stopToken]() {
+        return stopToken.stop_requested();
+    }))
+    {
+        bool checkpointDue = std::chrono::steady_clock::now() >= nextCheckpoint;
+        for (auto& database : pool_->getOpenDatabases()) {
+            // Whatever wasn't written is tried again on the next tick.
+            try {
+                if (checkpointDue) {
+                    database->checkpoint();
+                } else {
+                    database->writeDirtyBlocks(blocksPerTick);
+                }
+            } catch (const std::exception& e) {
+                err << std::format("writing {} back failed: {}\n",
+                                   database->getName(), e.what());
+            }
+        }
+        if (checkpointDue) {
+            nextCheckpoint = std::chrono::steady_clock::now() +
+                             writeBehind_.checkpointInterval;
+        }
+    }
+}
+
+void Server::_runStatements(const std::shared_ptr<Session>& session) {
+    std::ostringstream os;
+    os.setf(std::ios_base::left, std::ios_base::adjustfield);
+    auto handOver = [&](bool done) {
+        {
+            std::scoped_lock lock(session->mutex);
+            session->output += std::move(os).str();
+            if (done) {
+                session->running = false;
+            }
+        }
+        os.str({});
+        {
+            std::scoped_lock lock(queueMutex_);
+            withOutput_.push_back(session);
+        }
+        _wake();
+    };
+    while (!stopping_) {
+        ParsedStatement parsed;
+        {
+            std::scoped_lock lock(session->mutex);
+            if (session->statements.empty() || session->quit) {
+                session->statements.clear();
+                break;
+            }
+            parsed = std::move(session->statements.front());
+            session->statements.pop_front();
+        }
+        bool quit = false;
+        try {
+            if (parsed.error) {
+                std::rethrow_exception(parsed.error);
+            }
+            ExecuteResult result = parsed.pStmt->run(session->dbManager);
+            result.showView(os);
+            quit = result.quit();
+        } catch (const FatalError& fatalError) {
+            os << fatalError.what() << "\n\n";
+            quit = true;
+        } catch (const std::exception& e) {
+            os << e.what() << "\n\n";
+        }
+        if (quit) {
+            std::scoped_lock lock(session->mutex);
+            session->quit = true;
+        }
+        if (os.tellp() >= static_cast<std::streamoff>(outputBatchSize)) {
+            handOver(false);
+        }
+    }
+    handOver(true);
+}
+
+void Server::_wake() noexcept {
+    std::uint64_t one = 1;
+    (void)::write(wakeFd_, &one, sizeof(one));
+}
+
+}  // namespace ursql
@@ -37,4 +37,10 @@ InvalidCommand::InvalidCommand(std::string_view what)
 MisMatch::MisMatch(std::string_view what)
     : UserError(std::format("mismatch: {}", what)) {}
 
+LockTimeout::LockTimeout(std::string_view what)
+    : UserError(std::format("lock wait timeout: {}", what)) {}
+
+Deadlock::Deadlock(std::string_view what)
+    : UserError(std::format("deadlock: {}", what)) {}
+
 }  // namespace ursql
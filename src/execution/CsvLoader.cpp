@@ -0,0 +1,76 @@
+#include "execution/CsvLoader.hpp"
+
+#include <format>
+#include <future>
+#include <thread>
+
+#include "exception/UserError.hpp"
+
+namespace ursql {
+
+CsvLoader::CsvLoader(const fs::path& filePath, CsvParser parser,
+                     std::size_t threadCount)
+    : file_(filePath, std::ios_base::binary),
+      parser_(std::move(parser)),
+      threadCount_(std::max<std::size_t>(threadCount, 1)),
+      buffer_() {
+    URSQL_EXPECT(file_, DoesNotExist, filePath.native());
+}
+
+bool CsvLoader::next(std::vector<ValueRow>& rows) {
+    rows.clear();
+    std::vector<std::size_t> cuts;
+    while (true) {
+        _readChunk();
+        if (!file_ && !buffer_.empty() && !buffer_.ends_with('\n')) {
+            buffer_.push_back('\n');
+        }
+        cuts = CsvParser::splitRecords(buffer_, threadCount_);
+        if (cuts.back() > 0) {
+            break;
+        }
+        // A record longer than what has been read so far; read more of it.
+        if (!file_) {
+            URSQL_EXPECT(buffer_.empty(), MissingInput,
+                         "closing quote of a CSV field");
+            return false;
+        }
+    }
+
+    std::string_view text = buffer_;
+    std::vector<std::future<std::vector<ValueRow>>> pieces;
+    for (std::size_t i = 1; i < cuts.size(); ++i) {
+        std::string_view piece =
+          text.substr(cuts[i - 1], cuts[i] - cuts[i - 1]);
+        pieces.push_back(std::async(std::launch::async, [this, piece]() {
+            std::vector<ValueRow> pieceRows;
+            parser_.parse(piece, pieceRows);
+            return pieceRows;
+        }));
+    }
+    parser_.parse(text.substr(0, cuts.front()), rows);
+    for (auto& piece : pieces) {
+        std::vector<ValueRow> pieceRows = piece.get();
+        rows.insert(std::end(rows),
+                    std::make_move_iterator(std::begin(pieceRows)),
+                    std::make_move_iterator(std::end(pieceRows)));
+    }
+    buffer_.erase(0, cuts.back());
+    return true;
+}
+
+std::size_t CsvLoader::defaultThreadCount() {
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+void CsvLoader::_readChunk() {
+    if (!file_) {
+        return;
+    }
+    std::size_t oldSize = buffer_.size();
+    buffer_.resize(oldSize + chunkSize);
+    file_.read(buffer_.data() + oldSize, chunkSize);
+    buffer_.resize(oldSize + static_cast<std::size_t>(file_.gcount()));
+}
+
+}  // namespace ursql
@@ -0,0 +1,175 @@
+#include "execution/CsvParser.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <format>
+
+#include "common/Messaging.hpp"
+#include "exception/InternalError.hpp"
+#include "exception/UserError.hpp"
+
+namespace ursql {
+
+namespace {
+
+constexpr const char quote = '"';
+constexpr const char separator = ',';
+constexpr const char newline = '\n';
+constexpr const std::string_view nullMarker = "\\N";
+
+template<typename T>
+Value convertNumber(std::string_view field) {
+    T number{};
+    auto [ptr, ec] =
+      std::from_chars(field.data(), field.data() + field.size(), number);
+    URSQL_EXPECT(ec == std::errc() && ptr == field.data() + field.size(),
+                 MisMatch, std::format("'{}' as a number", field));
+    return Value(number);
+}
+
+bool equalsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+    return std::ranges::equal(lhs, rhs, [](char l, char r) {
+        return std::tolower(static_cast<unsigned char>(l)) ==
+               std::tolower(static_cast<unsigned char>(r));
+    });
+}
+
+Value convertBool(std::string_view field) {
+    if (field == "1" || equalsIgnoreCase(field, "true")) {
+        return Value(true);
+    }
+    URSQL_EXPECT(field == "0" || equalsIgnoreCase(field, "false"), MisMatch,
+                 std::format("'{}' as a boolean", field));
+    return Value(false);
+}
+
+Value convertField(std::string_view field, bool quoted, ValueType type) {
+    if (!quoted && (field.empty() || field == nullMarker)) {
+        return Value();
+    }
+    switch (type) {
+    case ValueType::int_type:
+        return convertNumber<Value::int_t>(field);
+    case ValueType::float_type:
+        return convertNumber<Value::float_t>(field);
+    case ValueType::bool_type:
+        return convertBool(field);
+    case ValueType::varchar_type:
+        return Value(field);
+    case ValueType::bigint_type:
+        return convertNumber<Value::bigint_t>(field);
+    default:
+        URSQL_UNREACHABLE(std::format("unknown column type {}", type));
+    }
+}
+
+}  // namespace
+
+CsvParser::CsvParser(std::vector<ValueType> columnTypes)
+    : columnTypes_(std::move(columnTypes)) {}
+
+void CsvParser::parse(std::string_view text,
+                      std::vector<ValueRow>& rows) const {
+    std::string unescaped;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        // Blank lines hold no record.
+        std::size_t lineEnd = text.find_first_not_of('\r', pos);
+        if (lineEnd == std::string_view::npos || text[lineEnd] == newline) {
+            pos = lineEnd == std::string_view::npos ? text.size()
+                                                    : lineEnd + 1;
+            continue;
+        }
+        ValueRow row;
+        row.reserve(columnTypes_.size());
+        while (true) {
+            std::string_view field;
+            bool quoted = pos < text.size() && text[pos] == quote;
+            if (quoted) {
+                unescaped.clear();
+                ++pos;
+                while (true) {
+                    std::size_t end = text.find(quote, pos);
+                    URSQL_EXPECT(end != std::string_view::npos, MissingInput,
+                                 "closing quote of a CSV field");
+                    unescaped.append(text.substr(pos, end - pos));
+                    pos = end + 1;
+                    if (pos >= text.size() || text[pos] != quote) {
+                        break;
+                    }
+                    unescaped.push_back(quote);
+                    ++pos;
+                }
+                field = unescaped;
+            } else {
+                std::size_t end = std::min(text.find_first_of(",\n", pos),
+                                           text.size());
+                field = text.substr(pos, end - pos);
+                pos = end;
+            }
+            if (pos < text.size() && text[pos] == '\r') {
+                ++pos;
+            } else if (!quoted && field.ends_with('\r')) {
+                field.remove_suffix(1);
+            }
+            URSQL_EXPECT(row.size() < columnTypes_.size(), MisMatch,
+                         "column count and CSV field count");
+            ValueType type = columnTypes_[row.size()];
+            row.push_back(convertField(field, quoted, type));
+            if (pos >= text.size() || text[pos] == newline) {
+                ++pos;
+                break;
+            }
+            URSQL_EXPECT(text[pos] == separator, UnexpectedInput,
+                         std::format("'{}' after a quoted CSV field",
+                                     text[pos]));
+            ++pos;
+        }
+        URSQL_EXPECT(row.size() == columnTypes_.size(), MisMatch,
+                     "column count and CSV field count");
+        rows.push_back(std::move(row));
+    }
+}
+
+std::vector<std::size_t> CsvParser::splitRecords(std::string_view text,
+                                                 std::size_t parts) {
+    URSQL_ASSERT(parts > 0, "splitting records into no parts");
+    std::size_t step = std::max<std::size_t>(text.size() / parts, 1);
+    std::vector<std::size_t> cuts;
+    std::size_t lastRecordEnd = 0;
+    // Like parse(), only a quote that starts a field quotes it; elsewhere
+    // in an unquoted field it's part of the text.
+    bool fieldStart = true;
+    bool inQuotes = false;
+    for (std::size_t pos = 0; pos < text.size(); ++pos) {
+        char ch = text[pos];
+        if (inQuotes) {
+            if (ch == quote) {
+                if (pos + 1 < text.size() && text[pos + 1] == quote) {
+                    ++pos;
+                } else {
+                    inQuotes = false;
+                }
+            }
+            continue;
+        }
+        if (ch == quote && fieldStart) {
+            inQuotes = true;
+        } else if (ch == newline) {
+            lastRecordEnd = pos + 1;
+            if (lastRecordEnd >= step * (cuts.size() + 1) &&
+                cuts.size() + 1 < parts)
+            {
+                cuts.push_back(lastRecordEnd);
+            }
+        }
+        fieldStart = ch == separator || ch == newline;
+    }
+    if (cuts.empty() || cuts.back() != lastRecordEnd) {
+        cuts.push_back(lastRecordEnd);
+    }
+    return cuts;
+}
+
+}  // namespace ursql
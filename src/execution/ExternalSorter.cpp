@@ -0,0 +1,278 @@
+#include "execution/ExternalSorter.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <optional>
+
+#include "exception/InternalError.hpp"
+#include "persistence/BufferStream.hpp"
+#include "persistence/Storage.hpp"
+
+namespace ursql {
+
+namespace {
+
+// Spill blocks start with the number of rows packed into them.
+using RowCountType = std::uint16_t;
+
+// Spill blocks are as large as blocks get, so that the rows of any table
+// fit.
+constexpr const std::size_t spillBlockSize = Block::maxSize;
+constexpr const std::size_t spillPayloadSize =
+  spillBlockSize - sizeof(BlockType) - sizeof(RowCountType);
+
+std::size_t encodedRowSize(const ValueRow& row) {
+    std::size_t size = sizeof(std::size_t);
+    for (auto& value : row) {
+        size += value.encodedSize();
+    }
+    return size;
+}
+
+fs::path makeSpillPath() {
+    static std::atomic<std::size_t> spillCount = 0;
+    return fs::temp_directory_path() /
+           std::format("ursql_spill_{}_{}.tmp", ::getpid(), spillCount++);
+}
+
+}  // namespace
+
+class ExternalSorter::SpillRun {
+public:
+    explicit SpillRun()
+        : path_(makeSpillPath()),
+          storage_(path_, CreateNewFile{ spillBlockSize }),
+          blockCount_(0) {}
+
+    ~SpillRun() {
+        std::error_code ec;
+        fs::remove(path_, ec);
+    }
+
+    URSQL_DISABLE_COPY(SpillRun);
+
+    void write(const std::vector<ValueRow>& rows) {
+        Block block(BlockType::row, spillBlockSize);
+        std::optional<BufferWriter> writer;
+        std::size_t used = 0;
+        RowCountType rowCount = 0;
+        for (auto& row : rows) {
+            std::size_t rowSize = encodedRowSize(row);
+            URSQL_ASSERT(
+              rowSize <= spillPayloadSize,
+              std::format("row of {} bytes can't be spilled", rowSize));
+            if (!writer || used + rowSize > spillPayloadSize) {
+                if (writer) {
+                    _writeBlock(block, rowCount);
+                }
+                writer.emplace(block.getData() + sizeof(RowCountType),
+                               spillPayloadSize);
+                used = 0;
+                rowCount = 0;
+            }
+            *writer << row.size();
+            for (auto& value : row) {
+                *writer << value;
+            }
+            used += rowSize;
+            ++rowCount;
+        }
+        if (writer) {
+            _writeBlock(block, rowCount);
+        }
+    }
+
+    [[nodiscard]] Storage& getStorage() {
+        return storage_;
+    }
+
+    [[nodiscard]] std::size_t getBlockCount() const {
+        return blockCount_;
+    }
+
+private:
+    const fs::path path_;
+    Storage storage_;
+    std::size_t blockCount_;
+
+    void _writeBlock(Block& block, RowCountType rowCount) {
+        BufferWriter(block.getData(), sizeof(RowCountType)) << rowCount;
+        storage_.writeBlock(block, blockCount_++);
+    }
+};
+
+namespace {
+
+class SpillRunCursor : public RowCursor {
+public:
+    explicit SpillRunCursor(ExternalSorter::SpillRun& run)
+        : RowCursor(),
+          run_(run),
+          block_(BlockType::row, spillBlockSize),
+          nextBlockNum_(0),
+          rowsLeftInBlock_(0) {}
+
+    ~SpillRunCursor() override = default;
+
+    bool next(ValueRow& row) override {
+        while (rowsLeftInBlock_ == 0) {
+            if (nextBlockNum_ >= run_.getBlockCount()) {
+                return false;
+            }
+            run_.getStorage().readBlock(block_, nextBlockNum_++);
+            rowsLeftInBlock_ = BufferReader(block_.getData(),
+                                            sizeof(RowCountType))
+                                 .read<RowCountType>();
+            reader_.emplace(block_.getData() + sizeof(RowCountType),
+                            spillPayloadSize);
+        }
+        --rowsLeftInBlock_;
+        auto valueCount = reader_->read<std::size_t>();
+        row.clear();
+        row.reserve(valueCount);
+        for (; valueCount > 0; --valueCount) {
+            row.push_back(reader_->read<Value>());
+        }
+        return true;
+    }
+
+private:
+    ExternalSorter::SpillRun& run_;
+    Block block_;
+    std::optional<BufferReader> reader_;
+    std::size_t nextBlockNum_;
+    RowCountType rowsLeftInBlock_;
+};
+
+class MergeCursor : public RowCursor {
+public:
+    MergeCursor(std::size_t keyIndex,
+                std::vector<std::unique_ptr<ExternalSorter::SpillRun>> runs,
+                std::vector<ValueRow> memoryRun)
+        : RowCursor(),
+          keyIndex_(keyIndex),
+          runs_(std::move(runs)) {
+        for (auto& run : runs_) {
+            sources_.push_back(std::make_unique<SpillRunCursor>(*run));
+        }
+        sources_.push_back(
+          std::make_unique<VectorRowCursor>(std::move(memoryRun)));
+        for (std::size_t i = 0; i < sources_.size(); ++i) {
+            HeapEntry entry{ {}, i };
+            if (sources_[i]->next(entry.row)) {
+                heap_.push_back(std::move(entry));
+            }
+        }
+        std::ranges::make_heap(heap_, _heapOrder());
+    }
+
+    ~MergeCursor() override = default;
+
+    bool next(ValueRow& row) override {
+        if (heap_.empty()) {
+            return false;
+        }
+        std::ranges::pop_heap(heap_, _heapOrder());
+        HeapEntry& top = heap_.back();
+        row = std::move(top.row);
+        if (sources_[top.source]->next(top.row)) {
+            std::ranges::push_heap(heap_, _heapOrder());
+        } else {
+            heap_.pop_back();
+        }
+        return true;
+    }
+
+private:
+    struct HeapEntry {
+        ValueRow row;
+        std::size_t source;
+    };
+
+    const std::size_t keyIndex_;
+    std::vector<std::unique_ptr<ExternalSorter::SpillRun>> runs_;
+    std::vector<std::unique_ptr<RowCursor>> sources_;
+    std::vector<HeapEntry> heap_;
+
+    // Min-heap on the key; ties go to the earlier run so the merge is stable.
+    struct HeapOrder {
+        std::size_t keyIndex;
+
+        bool operator()(const HeapEntry& lhs, const HeapEntry& rhs) const {
+            const Value& lhsKey = lhs.row[keyIndex];
+            const Value& rhsKey = rhs.row[keyIndex];
+            if (rhsKey < lhsKey) {
+                return true;
+            }
+            return !(lhsKey < rhsKey) && rhs.source < lhs.source;
+        }
+    };
+
+    [[nodiscard]] HeapOrder _heapOrder() const {
+        return { keyIndex_ };
+    }
+};
+
+}  // namespace
+
+ExternalSorter::ExternalSorter(std::size_t keyIndex, std::size_t memoryBudget)
+    : keyIndex_(keyIndex),
+      memoryBudget_(memoryBudget),
+      buffer_(),
+      bufferedBytes_(0),
+      bufferSorted_(true),
+      runs_() {}
+
+ExternalSorter::~ExternalSorter() = default;
+
+void ExternalSorter::add(ValueRow row) {
+    URSQL_ASSERT(keyIndex_ < row.size(), "sort key index out of range");
+    if (bufferSorted_ && !buffer_.empty() &&
+        row[keyIndex_] < buffer_.back()[keyIndex_])
+    {
+        bufferSorted_ = false;
+    }
+    bufferedBytes_ += encodedRowSize(row);
+    buffer_.push_back(std::move(row));
+    if (bufferedBytes_ >= memoryBudget_) {
+        _spill();
+    }
+}
+
+std::unique_ptr<RowCursor> ExternalSorter::finish() {
+    _sortBuffer();
+    if (runs_.empty()) {
+        return std::make_unique<VectorRowCursor>(std::move(buffer_));
+    }
+    return std::make_unique<MergeCursor>(keyIndex_, std::move(runs_),
+                                         std::move(buffer_));
+}
+
+std::size_t ExternalSorter::getRunCount() const {
+    return runs_.size();
+}
+
+void ExternalSorter::_sortBuffer() {
+    // Input that already arrives in key order, e.g. a table scanned along
+    // its insertion order, skips the sort entirely.
+    if (!bufferSorted_) {
+        std::ranges::stable_sort(buffer_, [this](auto& lhs, auto& rhs) {
+            return lhs[keyIndex_] < rhs[keyIndex_];
+        });
+        bufferSorted_ = true;
+    }
+}
+
+void ExternalSorter::_spill() {
+    _sortBuffer();
+    auto run = std::make_unique<SpillRun>();
+    run->write(buffer_);
+    runs_.push_back(std::move(run));
+    buffer_.clear();
+    bufferedBytes_ = 0;
+}
+
+}  // namespace ursql
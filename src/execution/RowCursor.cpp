@@ -0,0 +1,18 @@
+#include "execution/RowCursor.hpp"
+
+namespace ursql {
+
+VectorRowCursor::VectorRowCursor(std::vector<ValueRow> rows)
+    : RowCursor(),
+      rows_(std::move(rows)),
+      i_(0) {}
+
+bool VectorRowCursor::next(ValueRow& row) {
+    if (i_ >= rows_.size()) {
+        return false;
+    }
+    row = std::move(rows_[i_++]);
+    return true;
+}
+
+}  // namespace ursql
@@ -0,0 +1,90 @@
+#include "execution/SortMergeJoin.hpp"
+
+#include "exception/InternalError.hpp"
+
+namespace ursql {
+
+SortMergeJoin::SortMergeJoin(std::unique_ptr<RowCursor> left,
+                             std::size_t leftKeyIndex,
+                             std::unique_ptr<RowCursor> right,
+                             std::size_t rightKeyIndex)
+    : RowCursor(),
+      left_(std::move(left)),
+      right_(std::move(right)),
+      leftKeyIndex_(leftKeyIndex),
+      rightKeyIndex_(rightKeyIndex),
+      leftRow_(),
+      rightRow_(),
+      leftValid_(false),
+      rightValid_(false),
+      rightRun_(),
+      runPos_(0),
+      inRun_(false) {
+    _advanceLeft();
+    _advanceRight();
+}
+
+bool SortMergeJoin::next(ValueRow& row) {
+    while (true) {
+        if (inRun_) {
+            if (runPos_ < rightRun_.size()) {
+                auto& rightRow = rightRun_[runPos_++];
+                row.clear();
+                row.reserve(leftRow_.size() + rightRow.size());
+                row.insert(std::end(row), std::begin(leftRow_),
+                           std::end(leftRow_));
+                row.insert(std::end(row), std::begin(rightRow),
+                           std::end(rightRow));
+                return true;
+            }
+            // The next left row joins the same buffered run if its key is
+            // unchanged, otherwise the run is done.
+            Value runKey = std::move(leftRow_[leftKeyIndex_]);
+            _advanceLeft();
+            if (leftValid_ && leftRow_[leftKeyIndex_] == runKey) {
+                runPos_ = 0;
+            } else {
+                inRun_ = false;
+                rightRun_.clear();
+            }
+            continue;
+        }
+        if (!leftValid_ || !rightValid_) {
+            return false;
+        }
+        const Value& leftKey = leftRow_[leftKeyIndex_];
+        const Value& rightKey = rightRow_[rightKeyIndex_];
+        if (leftKey.isNull() || leftKey < rightKey) {
+            _advanceLeft();
+        } else if (rightKey.isNull() || rightKey < leftKey) {
+            _advanceRight();
+        } else {
+            _collectRightRun();
+        }
+    }
+}
+
+void SortMergeJoin::_advanceLeft() {
+    leftValid_ = left_->next(leftRow_);
+    URSQL_ASSERT(!leftValid_ || leftKeyIndex_ < leftRow_.size(),
+                 "left join key index out of range");
+}
+
+void SortMergeJoin::_advanceRight() {
+    rightValid_ = right_->next(rightRow_);
+    URSQL_ASSERT(!rightValid_ || rightKeyIndex_ < rightRow_.size(),
+                 "right join key index out of range");
+}
+
+void SortMergeJoin::_collectRightRun() {
+    rightRun_.clear();
+    Value runKey = rightRow_[rightKeyIndex_];
+    do {
+        rightRun_.push_back(std::move(rightRow_));
+        _advanceRight();
+    } while (rightValid_ && rightRow_[rightKeyIndex_] == runKey);
+    runPos_ = 0;
+    inRun_ = true;
+}
+
+}  // namespace ursql
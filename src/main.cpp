@@ -1,13 +1,23 @@
+#include <fcntl.h>
 #include <readline/readline.h>
+#include <unistd.h>
 
+#include <csignal>
+#include <cstring>
+#include <format>
+#include <future>
 #include <iostream>
 #include <sstream>
 
+#include "common/Arena.hpp"
 #include "common/Finally.hpp"
 #include "controller/DBManager.hpp"
+#include "controller/Server.hpp"
 #include "exception/InternalError.hpp"
+#include "parser/Lexer.hpp"
 #include "parser/Parser.hpp"
 #include "parser/SQLBlob.hpp"
+#include "parser/ScriptReader.hpp"
 #include "parser/TokenStream.hpp"
 #include "statement/Statement.hpp"
 
@@ -18,13 +28,47 @@ std::ostream& err = std::cerr;
 
 }  // namespace ursql
 
-int main(int argc, char* argv[]) {
-    using namespace ursql;
+namespace {
 
-    out.setf(std::ios_base::left, std::ios_base::adjustfield);
-    DBManager dbManager(fs::temp_directory_path(), ".db");
+using namespace ursql;
+
+enum class Outcome {
+    done,
+    failed,
+    quit,
+    fatal
+};
 
+void reportError(const std::exception& e) {
+    err << e.what() << '\n';
+    const boost::stacktrace::stacktrace* st = boost::get_error_info<Traced>(e);
+    if (st) {
+        err << *st << '\n';
+    }
+    err << '\n';
+}
+
+// Runs the statement produce() returns and shows its result. Errors from
+// either step are reported here instead of being propagated.
+template<typename F>
+Outcome runStatement(DBManager& dbManager, F&& produce) {
+    try {
+        ResourcePtr<Statement> pStmt = produce();
+        ExecuteResult result = pStmt->run(dbManager);
+        result.showView(out);
+        return result.quit() ? Outcome::quit : Outcome::done;
+    } catch (const FatalError& fatalError) {
+        reportError(fatalError);
+        return Outcome::fatal;
+    } catch (const std::exception& e) {
+        reportError(e);
+        return Outcome::failed;
+    }
+}
+
+void runInteractive(DBManager& dbManager) {
     SQLBlob blob;
+    Arena arena;
     bool quit = false;
     do {
         char* line = readline("ursql> ");
@@ -36,32 +80,158 @@ int main(int argc, char* argv[]) {
         });
         std::istringstream input(line);
         while (!quit && input >> blob) {
-            try {
-                try {
-                    if (blob.ready()) {
-                        TokenStream tokenStream = blob.tokenize();
-                        auto pStmt = parser::parse(tokenStream);
-                        ExecuteResult result = pStmt->run(dbManager);
-                        result.showView(out);
-                        quit = result.quit();
+            if (blob.ready()) {
+                Outcome outcome = runStatement(dbManager, [&]() {
+                    TokenStream tokenStream = blob.tokenize(arena.resource());
+                    return parser::parse(tokenStream);
+                });
+                arena.reset();
+                quit = outcome == Outcome::quit || outcome == Outcome::fatal;
+            }
+        }
+    } while (!quit);
+}
+
+// A statement parsed ahead of its execution, or the error parsing it.
+struct ParsedStatement {
+    ResourcePtr<Statement> pStmt;
+    std::exception_ptr error;
+};
+
+// The statements of a batch are allocated from its arena.
+struct ParsedBatch {
+    std::unique_ptr<Arena> arena = std::make_unique<Arena>();
+    std::vector<ParsedStatement> statements;
+};
+
+constexpr const std::size_t parseBatchSize = 1024;
+
+ParsedBatch parseBatch(ScriptReader& reader) {
+    ParsedBatch batch;
+    std::string_view text;
+    Arena scratch;
+    while (batch.statements.size() < parseBatchSize && reader.next(text)) {
+        try {
+            // Parsed statements own their data, so the tokens may view the
+            // reader's text, which only lives until the next statement, and
+            // be allocated from an arena that is reset as soon as it's done.
+            TokenStream tokenStream(Lexer(text).lex(scratch.resource()));
+            tokenStream.setResource(batch.arena->resource());
+            batch.statements.push_back({ parser::parse(tokenStream), nullptr });
+        } catch (const std::exception&) {
+            batch.statements.push_back({ nullptr, std::current_exception() });
+        }
+        scratch.reset();
+    }
+    return batch;
+}
+
+// Replays a script. The next batch of statements is lexed and parsed on
+// another thread while the current one executes, which parsing can't
+// affect. Statements after a failed one still run, like in the prompt.
+int runScript(DBManager& dbManager, int fd) {
+    bool failed = false;
+    try {
+        ScriptReader reader(fd);
+        auto parseAhead = [&reader]() {
+            return std::async(std::launch::async, parseBatch,
+                              std::ref(reader));
+        };
+        for (auto pending = parseAhead();;) {
+            ParsedBatch batch = pending.get();
+            if (batch.statements.empty()) {
+                break;
+            }
+            pending = parseAhead();
+            for (auto& parsed : batch.statements) {
+                Outcome outcome = runStatement(dbManager, [&parsed]() {
+                    if (parsed.error) {
+                        std::rethrow_exception(parsed.error);
                     }
-                } catch (const FatalError& fatalError) {
-                    quit = true;
-                    throw;
-                } catch (const std::exception&) {
-                    throw;
+                    return std::move(parsed.pStmt);
+                });
+                failed |= outcome == Outcome::failed;
+                if (outcome == Outcome::quit) {
+                    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
                 }
-            } catch (const std::exception& e) {
-                err << e.what() << '\n';
-                const boost::stacktrace::stacktrace* st =
-                  boost::get_error_info<Traced>(e);
-                if (st) {
-                    err << *st << '\n';
+                if (outcome == Outcome::fatal) {
+                    return EXIT_FAILURE;
                 }
-                err << '\n';
             }
         }
-    } while (!quit);
+    } catch (const std::exception& e) {
+        reportError(e);
+        return EXIT_FAILURE;
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+Server* serving = nullptr;
+
+// Serves clients on a Unix domain socket until interrupted.
+int runServer(const char* socketPath) {
+    try {
+        Server server(socketPath,
+                      std::make_shared<DatabasePool>(
+                        fs::temp_directory_path(), ".db"),
+                      Server::defaultWorkerCount());
+        serving = &server;
+        auto onSignal = [](int) {
+            serving->stop();
+        };
+        std::signal(SIGINT, onSignal);
+        std::signal(SIGTERM, onSignal);
+        server.run();
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+        serving = nullptr;
+    } catch (const std::exception& e) {
+        reportError(e);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    using namespace ursql;
+
+    out.setf(std::ios_base::left, std::ios_base::adjustfield);
+    if (argc == 3 && std::strcmp(argv[1], "--serve") == 0) {
+        return runServer(argv[2]);
+    }
+    DBManager dbManager(fs::temp_directory_path(), ".db");
 
-    return 0;
+    if (argc == 1) {
+        if (::isatty(STDIN_FILENO)) {
+            runInteractive(dbManager);
+            return EXIT_SUCCESS;
+        }
+        return runScript(dbManager, STDIN_FILENO);
+    }
+    const char* scriptPath = nullptr;
+    if (argc == 2 && std::strcmp(argv[1], "-f") != 0) {
+        scriptPath = argv[1];
+    } else if (argc == 3 && std::strcmp(argv[1], "-f") == 0) {
+        scriptPath = argv[2];
+    }
+    if (scriptPath) {
+        if (std::strcmp(scriptPath, "-") == 0) {
+            return runScript(dbManager, STDIN_FILENO);
+        }
+        int fd = ::open(scriptPath, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            err << std::format("can't open {}: {}\n", scriptPath,
+                               std::strerror(errno));
+            return EXIT_FAILURE;
+        }
+        Finally cleanup([fd]() {
+            ::close(fd);
+        });
+        return runScript(dbManager, fd);
+    }
+    err << std::format("usage: {} [[-f] script.sql | --serve socket]\n",
+                       argv[0]);
+    return EXIT_FAILURE;
 }
@@ -67,7 +67,13 @@ bool Attribute::isAutoInc() const {
 }
 
 bool Attribute::mustBeSpecified() const {
-    return !isNullable() && getDefaultValue().isNull();
+    return !isAutoInc() && !isNullable() && getDefaultValue().isNull();
+}
+
+std::size_t Attribute::encodedSize() const {
+    return sizeof(std::size_t) + name_.length() + sizeof(valueType_) +
+           defaultValue_.encodedSize() + sizeof(isNullable_) +
+           sizeof(isPrimary_) + sizeof(isAutoInc_);
 }
 
 namespace {
@@ -77,6 +83,8 @@ ValueType parseNextValueType(TokenStream& ts) {
         switch (ts.next().get<TokenType::keyword>()) {
         case Keyword::integer_kw:
             return ValueType::int_type;
+        case Keyword::bigint_kw:
+            return ValueType::bigint_type;
         case Keyword::float_kw:
             return ValueType::float_type;
         case Keyword::boolean_kw:
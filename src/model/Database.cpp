@@ -1,16 +1,40 @@
 #include "model/Database.hpp"
 
+#include <atomic>
 #include <format>
 #include <numeric>
+#include <span>
+#include <unordered_set>
 
+#include "common/Finally.hpp"
+#include "common/Messaging.hpp"
+#include "exception/InternalError.hpp"
 #include "exception/UserError.hpp"
+#include "execution/CsvLoader.hpp"
+#include "execution/ExternalSorter.hpp"
+#include "execution/SortMergeJoin.hpp"
 #include "model/Entity.hpp"
 #include "model/Row.hpp"
+#include "model/Transaction.hpp"
+#include "statement/Filter.hpp"
 
 namespace ursql {
 
 namespace {
 
+// As long as a writer waits for a lock before giving up, like InnoDB.
+constexpr const std::chrono::seconds lockTimeout(50);
+// The file grows by this many blocks at a time, which a table then fills
+// before its rows go anywhere else.
+constexpr const std::size_t extentBlockCount = 64;
+// A scan reads up to this many bytes of adjacent row blocks at once.
+constexpr const std::size_t scanRunBytes = 256 << 10;
+
+std::uint64_t nextSchemaStamp() {
+    static std::atomic<std::uint64_t> lastSchemaStamp = 0;
+    return ++lastSchemaStamp;
+}
+
 std::vector<bool> validateSpecifiedAttributes(
   const std::vector<Attribute>& attributes,
   const std::vector<std::size_t>& attrIndexes) {
@@ -24,45 +48,205 @@ std::vector<bool> validateSpecifiedAttributes(
     return attrSpecified;
 }
 
-void validateInsertValueLists(const std::vector<std::vector<Value>>& valueLists,
-                              const std::vector<Attribute>& attributes,
-                              const std::vector<std::size_t>& attrIndexes) {
-    for (auto& valueList : valueLists) {
-        URSQL_EXPECT(valueList.size() == attrIndexes.size(), MisMatch,
-                     "column count and value count");
-        for (std::size_t i = 0; i < valueList.size(); ++i) {
-            if (valueList[i].isNull()) {
-                auto& attribute = attributes[attrIndexes[i]];
-                URSQL_EXPECT(
-                  attribute.isNullable(), InvalidCommand,
-                  std::format("'{}' can't be null", attribute.getName()));
+// The transactions started up to `last`, except the running ones other
+// than `own`.
+Snapshot snapshotOf(TxnId last, const std::set<TxnId>& running, TxnId own) {
+    Snapshot snapshot{ last, {} };
+    snapshot.running.reserve(running.size());
+    std::ranges::copy_if(running, std::back_inserter(snapshot.running),
+                         [own](TxnId txn) {
+                             return txn != own;
+                         });
+    return snapshot;
+}
+
+// Reads the row versions a snapshot sees. The versions are a copy, so the
+// table isn't latched while it's scanned.
+class TableScanCursor : public RowCursor {
+public:
+    TableScanCursor(Storage& storage, std::vector<RowVersion> rowVersions,
+                    const Snapshot& snapshot)
+        : RowCursor(),
+          storage_(storage),
+          rowVersions_(std::move(rowVersions)),
+          snapshot_(snapshot),
+          i_(0),
+          runLength_(
+            std::max<std::size_t>(scanRunBytes / storage.getBlockSize(), 1)),
+          run_(),
+          runBlockNum_(0),
+          runSize_(0),
+          runPos_(0) {}
+
+    ~TableScanCursor() override = default;
+
+    bool next(ValueRow& row) override {
+        if (runPos_ == runSize_ && !_readRun()) {
+            return false;
+        }
+        Row dbRow(runBlockNum_ + runPos_);
+        dbRow.decode(run_[runPos_++]);
+        row = dbRow.releaseValues();
+        return true;
+    }
+
+private:
+    Storage& storage_;
+    const std::vector<RowVersion> rowVersions_;
+    const Snapshot& snapshot_;
+    std::size_t i_;
+    const std::size_t runLength_;
+    // The next visible rows, held in adjacent blocks.
+    std::vector<Block> run_;
+    std::size_t runBlockNum_;
+    std::size_t runSize_;
+    std::size_t runPos_;
+
+    // Rows kept in the order they were written mostly lie in adjacent
+    // blocks, which are then read in one go.
+    bool _readRun() {
+        runSize_ = 0;
+        runPos_ = 0;
+        while (i_ < rowVersions_.size() && runSize_ < runLength_) {
+            const RowVersion& version = rowVersions_[i_];
+            if (!version.visibleTo(snapshot_)) {
+                ++i_;
+                continue;
             }
+            if (runSize_ == 0) {
+                runBlockNum_ = version.blockNum;
+            } else if (version.blockNum != runBlockNum_ + runSize_) {
+                break;
+            }
+            ++runSize_;
+            ++i_;
+        }
+        if (runSize_ == 0) {
+            return false;
+        }
+        while (run_.size() < runSize_) {
+            run_.emplace_back(BlockType::row, storage_.getBlockSize());
         }
+        storage_.readBlocks(runBlockNum_,
+                            std::span(run_.data(), runSize_));
+        return true;
     }
+};
+
+std::vector<std::vector<Value>> project(
+  RowCursor& cursor, const std::optional<std::vector<std::size_t>>& indexes,
+  const Filter::RowPredicate& pred = nullptr) {
+    std::vector<std::vector<Value>> valueRows;
+    for (ValueRow row; cursor.next(row);) {
+        if (pred && !pred(row)) {
+            continue;
+        }
+        if (!indexes.has_value()) {
+            valueRows.push_back(std::move(row));
+            continue;
+        }
+        std::vector<Value> valueRow;
+        valueRow.reserve(indexes->size());
+        for (std::size_t index : indexes.value()) {
+            valueRow.push_back(std::move(row[index]));
+        }
+        valueRows.push_back(std::move(valueRow));
+    }
+    return valueRows;
+}
+
+// Maps "column" or "table.column" to its position in a joined row, which
+// holds all left columns followed by all right columns.
+std::size_t joinedAttributeIndex(std::string_view attrName,
+                                 std::string_view leftName, const Entity& left,
+                                 std::string_view rightName,
+                                 const Entity& right) {
+    std::size_t leftWidth = left.getAttributes().size();
+    if (auto dot = attrName.find('.'); dot != std::string_view::npos) {
+        std::string_view tableName = attrName.substr(0, dot);
+        std::string_view columnName = attrName.substr(dot + 1);
+        if (tableName == leftName) {
+            return left.attributeIndex(columnName);
+        }
+        URSQL_EXPECT(tableName == rightName, DoesNotExist, tableName);
+        return leftWidth + right.attributeIndex(columnName);
+    }
+    bool inLeft = left.attributeExists(attrName);
+    URSQL_EXPECT(!inLeft || !right.attributeExists(attrName), InvalidCommand,
+                 std::format("column '{}' is ambiguous", attrName));
+    return inLeft ? left.attributeIndex(attrName) :
+                    leftWidth + right.attributeIndex(attrName);
 }
 
 }  // namespace
 
-Database::Database(std::string name, const fs::path& filePath, CreateNewFile)
+Database::Table::Table(std::string name, Entity entity)
+    : name(std::move(name)),
+      entity(std::move(entity)),
+      latch() {}
+
+Database::Database(std::string name, const fs::path& filePath,
+                   CreateNewFile createNewFile)
     : name_(std::move(name)),
-      storage_(filePath, CreateNewFile{}),
-      toc_(),
-      entityCache_() {
+      storage_(filePath, createNewFile),
+      toc_(storage_.getBlockSize()),
+      entityCache_(),
+      schemaStamp_(nextSchemaStamp()),
+      catalogLatch_(),
+      entityCacheLatch_(),
+      allocationLatch_(),
+      txnLatch_(),
+      txnCond_(),
+      lastTxnId_(0),
+      runningTxns_(),
+      snapshotHorizons_(),
+      inPlaceWriters_(0),
+      lockManager_(lockTimeout),
+      pendingFreeBlockNums_(),
+      extents_(),
+      reservedBlockNums_() {
     storage_.save(toc_);
 }
 
 Database::Database(std::string name, const fs::path& filePath, OpenExistingFile)
     : name_(std::move(name)),
       storage_(filePath, OpenExistingFile{}),
-      toc_(),
-      entityCache_() {
+      toc_(storage_.getBlockSize()),
+      entityCache_(),
+      schemaStamp_(nextSchemaStamp()),
+      catalogLatch_(),
+      entityCacheLatch_(),
+      allocationLatch_(),
+      txnLatch_(),
+      txnCond_(),
+      lastTxnId_(0),
+      runningTxns_(),
+      snapshotHorizons_(),
+      inPlaceWriters_(0),
+      lockManager_(lockTimeout),
+      pendingFreeBlockNums_(),
+      extents_(),
+      reservedBlockNums_() {
     storage_.load(toc_);
 }
 
 Database::~Database() {
-    storage_.save(toc_);
-    for (auto& [_, entity] : entityCache_) {
-        storage_.save(entity);
+    // Nothing reads any more, so only the live versions are kept.
+    for (auto& [_, table] : entityCache_) {
+        _releaseLater(table.entity.pruneRowVersions(lastTxnId_ + 1));
+    }
+    // A destructor can't throw; checkpoint() reports the same failures to
+    // callers that need to know.
+    try {
+        // Directory blocks the tables no longer need are released with the
+        // rest.
+        for (auto& [_, table] : entityCache_) {
+            _saveEntity(table.entity);
+        }
+        _releasePending();
+        storage_.save(toc_);
+    } catch (const std::exception& e) {
+        err << std::format("can't save database {}: {}\n", name_, e.what());
     }
 }
 
@@ -70,43 +254,137 @@ const std::string& Database::getName() const {
     return name_;
 }
 
+std::uint64_t Database::getSchemaStamp() const {
+    return schemaStamp_;
+}
+
 std::vector<BlockType> Database::getBlockTypes() {
-    std::size_t blockCnt = storage_.getBlockCount();
-    std::vector<BlockType> blockTypes;
-    blockTypes.reserve(blockCnt);
-    for (std::size_t i = 0; i < blockCnt; ++i) {
-        blockTypes.push_back(storage_.getBlockType(i));
+    std::shared_lock catalog(catalogLatch_);
+    std::scoped_lock allocation(allocationLatch_);
+    std::vector<BlockType> blockTypes = storage_.getBlockTypes();
+    for (auto& blockNums : pendingFreeBlockNums_) {
+        for (std::size_t blockNum : blockNums) {
+            blockTypes[blockNum] = BlockType::free;
+        }
     }
     return blockTypes;
 }
 
-std::vector<std::string> Database::getAllEntityNames() const {
+std::vector<std::string> Database::getAllEntityNames() {
+    std::shared_lock catalog(catalogLatch_);
     return toc_.getAllEntityNames();
 }
 
+std::vector<std::string> Database::getAttributeNames(
+  const std::string& entityName) {
+    // Attributes only change with the catalog.
+    std::shared_lock catalog(catalogLatch_);
+    std::vector<std::string> attrNames;
+    for (auto& attribute : _getTable(entityName).entity.getAttributes()) {
+        attrNames.push_back(attribute.getName());
+    }
+    return attrNames;
+}
+
 void Database::createTable(const std::string& entityName,
                            const std::vector<Attribute>& attributes) {
+    std::unique_lock catalog(catalogLatch_);
     URSQL_EXPECT(!toc_.entityExists(entityName), AlreadyExists, entityName);
-    std::size_t blockNum = _findFreeBlockNumber();
+    std::scoped_lock allocation(allocationLatch_);
+    std::size_t blockNum = _allocateBlockNumbers(1, nullptr).front();
     Entity entity(blockNum);
     entity.setAttributes(attributes);
     _addEntity(entityName, entity);
+    // Saved right away, so that a committed transaction never refers to a
+    // table missing from the file.
+    storage_.save(toc_);
+    schemaStamp_ = nextSchemaStamp();
 }
 
 void Database::dropTables(const std::vector<std::string>& entityNames) {
+    // The writers of the tables finish first, and no latch is held while
+    // waiting for them.
+    TxnId txn = _beginWrite(nullptr);
+    Finally end([this, txn]() {
+        _endWrite(txn, nullptr);
+    });
+    for (auto& entityName : entityNames) {
+        lockManager_.lock(txn, LockTarget::ofTable(entityName),
+                          LockMode::exclusive);
+    }
+    std::unique_lock catalog(catalogLatch_);
+    std::scoped_lock allocation(allocationLatch_);
     for (auto& entityName : entityNames) {
         URSQL_EXPECT(toc_.entityExists(entityName), DoesNotExist, entityName);
     }
     for (auto& entityName : entityNames) {
         _dropEntity(entityName);
     }
+    storage_.save(toc_);
 }
 
 void Database::insertIntoTable(
   const std::string& entityName,
-  const std::optional<std::vector<std::string>>& attrNamesOpt,
-  const std::vector<std::vector<Value>>& valueLists) {
-    Entity& entity = _getEntityByName(entityName);
+  const std::optional<std::vector<std::string>>& attrNames,
+  const std::pmr::vector<ValueList>& valueLists,
+  Transaction* transaction) {
+    TxnId txn = _beginWrite(transaction);
+    Finally end([this, txn, transaction]() {
+        _endWrite(txn, transaction);
+    });
+    std::pmr::vector<ValueList> ownValueLists(valueLists);
+    while (true) {
+        std::optional<LockRequest> blocked;
+        {
+            // Planned under the same catalog latch, so the plan can't go
+            // stale.
+            std::shared_lock catalog(catalogLatch_);
+            blocked = _insertRows(_planInsert(entityName, attrNames),
+                                  ownValueLists, txn, transaction);
+        }
+        if (!blocked.has_value()) {
+            return;
+        }
+        _waitForLock(txn, blocked.value(), transaction);
+    }
+}
+
+Database::InsertPlan Database::planInsert(
+  const std::string& entityName,
+  const std::optional<std::vector<std::string>>& attrNames) {
+    std::shared_lock catalog(catalogLatch_);
+    return _planInsert(entityName, attrNames);
+}
+
+void Database::insertRows(const InsertPlan& plan,
+                          std::pmr::vector<ValueList> valueLists,
+                          Transaction* transaction) {
+    TxnId txn = _beginWrite(transaction);
+    Finally end([this, txn, transaction]() {
+        _endWrite(txn, transaction);
+    });
+    while (true) {
+        std::optional<LockRequest> blocked;
+        {
+            std::shared_lock catalog(catalogLatch_);
+            // Another session may have changed the schema since the plan
+            // was made.
+            URSQL_EXPECT(plan.schemaStamp == schemaStamp_, InvalidCommand,
+                         "tables changed while inserting, please retry");
+            blocked = _insertRows(plan, valueLists, txn, transaction);
+        }
+        if (!blocked.has_value()) {
+            return;
+        }
+        _waitForLock(txn, blocked.value(), transaction);
+    }
+}
+
+Database::InsertPlan Database::_planInsert(
+  const std::string& entityName,
+  const std::optional<std::vector<std::string>>& attrNamesOpt) {
+    Table& table = _getTable(entityName);
+    Entity& entity = table.entity;
     std::vector<std::size_t> attrIndexes;
     if (attrNamesOpt.has_value()) {
         auto& attrNames = attrNamesOpt.value();
@@ -119,17 +397,652 @@ void Database::insertIntoTable(
         attrIndexes.resize(attributes.size());
         std::iota(std::begin(attrIndexes), std::end(attrIndexes), 0);
     }
-    _insertIntoTableInternal(entity, attrIndexes, valueLists);
+    auto& attributes = entity.getAttributes();
+    std::vector<bool> attrSpecified =
+      validateSpecifiedAttributes(attributes, attrIndexes);
+    for (std::size_t i = 0; i < attributes.size(); ++i) {
+        URSQL_EXPECT(
+          attrSpecified[i] || !attributes[i].mustBeSpecified(), InvalidCommand,
+          std::format("'{}' must be specified", attributes[i].getName()));
+    }
+    return { schemaStamp_, &table, std::move(attrIndexes),
+             std::move(attrSpecified) };
+}
+
+std::optional<Database::LockRequest> Database::_insertRows(
+  const InsertPlan& plan, std::pmr::vector<ValueList>& valueLists,
+  TxnId txn, Transaction* transaction) {
+    std::unique_lock tableLatch(plan.table->latch);
+    // New rows are invisible to other writers until they commit, so only
+    // the table is locked.
+    std::optional<LockRequest> blocked = _tryLockForWrite(
+      txn, *plan.table, LockMode::intention_exclusive, {}, transaction);
+    if (blocked.has_value()) {
+        return blocked;
+    }
+    Entity& entity = plan.table->entity;
+    auto& attributes = entity.getAttributes();
+    for (auto& valueList : valueLists) {
+        URSQL_EXPECT(valueList.size() == plan.attrIndexes.size(), MisMatch,
+                     "column count and value count");
+    }
+    // Column by column, so that each attribute is looked up once. Values
+    // that already have the column's type are kept as they are.
+    for (std::size_t i = 0; i < plan.attrIndexes.size(); ++i) {
+        auto& attribute = attributes[plan.attrIndexes[i]];
+        ValueType type = attribute.getType();
+        for (auto& valueList : valueLists) {
+            Value& value = valueList[i];
+            if (value.isNull()) {
+                URSQL_EXPECT(
+                  attribute.isNullable(), InvalidCommand,
+                  std::format("'{}' can't be null", attribute.getName()));
+                continue;
+            }
+            if (value.getType() != type) {
+                value = value.cast(type);
+            }
+            if (attribute.isAutoInc()) {
+                entity.updateAutoInc(value.toInteger());
+            }
+        }
+    }
+    std::vector<std::vector<Value>> valueRows(valueLists.size());
+    for (std::size_t row = 0; row < valueLists.size(); ++row) {
+        std::vector<Value>& valueRow = valueRows[row];
+        valueRow.resize(attributes.size());
+        for (std::size_t i = 0; i < attributes.size(); ++i) {
+            if (!plan.attrSpecified[i]) {
+                auto& attribute = attributes[i];
+                valueRow[i] = attribute.isAutoInc() ?
+                                Value::fromInteger(entity.getNextAutoInc())
+                                  .cast(attribute.getType()) :
+                                attribute.getDefaultValue();
+            }
+        }
+        for (std::size_t i = 0; i < plan.attrIndexes.size(); ++i) {
+            valueRow[plan.attrIndexes[i]] = std::move(valueLists[row][i]);
+        }
+    }
+    entity.appendRowVersions(_writeRows(*plan.table, std::move(valueRows)),
+                             txn);
+    return std::nullopt;
+}
+
+std::vector<std::vector<Value>> Database::selectFromTable(
+  const std::string& entityName,
+  const std::optional<std::vector<std::string>>& attrNamesOpt,
+  const Filter* filter, const Transaction* transaction) {
+    std::shared_lock catalog(catalogLatch_);
+    Table& table = _getTable(entityName);
+    Entity& entity = table.entity;
+    std::optional<std::vector<std::size_t>> attrIndexes;
+    if (attrNamesOpt.has_value()) {
+        attrIndexes.emplace();
+        for (auto& attrName : attrNamesOpt.value()) {
+            attrIndexes->push_back(entity.attributeIndex(attrName));
+        }
+    }
+    std::optional<Snapshot> ownSnapshot;
+    const Snapshot& snapshot = transaction ?
+                                 transaction->getSnapshot() :
+                                 ownSnapshot.emplace(_takeSnapshot());
+    Finally release([this, &ownSnapshot]() {
+        if (ownSnapshot.has_value()) {
+            _releaseSnapshot(ownSnapshot.value());
+        }
+    });
+    return project(*_scanTable(table, snapshot), attrIndexes,
+                   filter ? filter->bind(entity) : nullptr);
+}
+
+std::vector<std::vector<Value>> Database::joinTables(
+  const std::string& leftEntityName, const std::string& rightEntityName,
+  const std::string& leftAttrName, const std::string& rightAttrName,
+  const std::optional<std::vector<std::string>>& attrNamesOpt,
+  const Transaction* transaction) {
+    std::shared_lock catalog(catalogLatch_);
+    Table& leftTable = _getTable(leftEntityName);
+    Table& rightTable = _getTable(rightEntityName);
+    Entity& left = leftTable.entity;
+    Entity& right = rightTable.entity;
+    auto attrIndex = [&](const std::string& attrName) {
+        return joinedAttributeIndex(attrName, leftEntityName, left,
+                                    rightEntityName, right);
+    };
+    std::size_t leftWidth = left.getAttributes().size();
+    std::size_t leftKeyIndex = attrIndex(leftAttrName);
+    std::size_t rightKeyIndex = attrIndex(rightAttrName);
+    if (leftKeyIndex >= leftWidth) {
+        std::swap(leftKeyIndex, rightKeyIndex);
+    }
+    URSQL_EXPECT(leftKeyIndex < leftWidth && rightKeyIndex >= leftWidth,
+                 InvalidCommand,
+                 "join condition should compare a column of each table");
+    rightKeyIndex -= leftWidth;
+
+    std::optional<std::vector<std::size_t>> attrIndexes;
+    if (attrNamesOpt.has_value()) {
+        attrIndexes.emplace();
+        for (auto& attrName : attrNamesOpt.value()) {
+            attrIndexes->push_back(attrIndex(attrName));
+        }
+    }
+    // Both sides are read on one snapshot.
+    std::optional<Snapshot> ownSnapshot;
+    const Snapshot& snapshot = transaction ?
+                                 transaction->getSnapshot() :
+                                 ownSnapshot.emplace(_takeSnapshot());
+    Finally release([this, &ownSnapshot]() {
+        if (ownSnapshot.has_value()) {
+            _releaseSnapshot(ownSnapshot.value());
+        }
+    });
+    SortMergeJoin join(_sortedScan(leftTable, snapshot, leftKeyIndex),
+                       leftKeyIndex,
+                       _sortedScan(rightTable, snapshot, rightKeyIndex),
+                       rightKeyIndex);
+    return project(join, attrIndexes);
+}
+
+std::size_t Database::loadIntoTable(const std::string& entityName,
+                                   const fs::path& filePath,
+                                   Transaction* transaction) {
+    TxnId txn = _beginWrite(transaction);
+    Finally end([this, txn, transaction]() {
+        _endWrite(txn, transaction);
+    });
+    std::shared_lock catalog(catalogLatch_);
+    Table* tablePtr = &_getTable(entityName);
+    std::unique_lock tableLatch(tablePtr->latch);
+    while (std::optional<LockRequest> blocked = _tryLockForWrite(
+             txn, *tablePtr, LockMode::intention_exclusive, {}, transaction))
+    {
+        tableLatch.unlock();
+        catalog.unlock();
+        _waitForLock(txn, blocked.value(), transaction);
+        catalog.lock();
+        tablePtr = &_getTable(entityName);
+        tableLatch = std::unique_lock(tablePtr->latch);
+    }
+    Table& table = *tablePtr;
+    Entity& entity = table.entity;
+    auto& attributes = entity.getAttributes();
+    std::vector<ValueType> columnTypes;
+    columnTypes.reserve(attributes.size());
+    for (auto& attribute : attributes) {
+        columnTypes.push_back(attribute.getType());
+    }
+    CsvLoader loader(filePath, CsvParser(std::move(columnTypes)));
+    std::size_t rowCount = 0;
+    try {
+        for (std::vector<ValueRow> rows; loader.next(rows);) {
+            // The whole chunk is checked before any of it is written.
+            for (auto& row : rows) {
+                for (std::size_t i = 0; i < attributes.size(); ++i) {
+                    auto& attribute = attributes[i];
+                    URSQL_EXPECT(
+                      !row[i].isNull() || attribute.isNullable() ||
+                        attribute.isAutoInc(),
+                      InvalidCommand,
+                      std::format("'{}' can't be null", attribute.getName()));
+                }
+            }
+            for (auto& row : rows) {
+                for (std::size_t i = 0; i < attributes.size(); ++i) {
+                    auto& attribute = attributes[i];
+                    if (!attribute.isAutoInc()) {
+                        continue;
+                    }
+                    if (row[i].isNull()) {
+                        row[i] = Value::fromInteger(entity.getNextAutoInc())
+                                   .cast(attribute.getType());
+                    } else {
+                        entity.updateAutoInc(row[i].toInteger());
+                    }
+                }
+            }
+            // Each chunk fills runs of adjacent blocks, written in one go.
+            rowCount += rows.size();
+            entity.appendRowVersions(_writeRows(table, std::move(rows)), txn);
+        }
+    } catch (...) {
+        // The chunks loaded so far are undone too, so that a load is all
+        // or nothing.
+        if (transaction) {
+            // Like a deadlock victim, the transaction is rolled back whole,
+            // as its earlier changes to the table can't be told apart.
+            tableLatch.unlock();
+            catalog.unlock();
+            rollback(*transaction);
+        } else {
+            std::vector<std::size_t> blockNums =
+              entity.rollbackRowVersions(txn);
+            std::scoped_lock allocation(allocationLatch_);
+            _releaseLater(std::move(blockNums));
+        }
+        throw;
+    }
+    storage_.flush();
+    return rowCount;
+}
+
+std::size_t Database::deleteFromTable(const std::string& entityName,
+                                     const Filter* filter,
+                                     Transaction* transaction) {
+    TxnId txn = _beginWrite(transaction);
+    Finally end([this, txn, transaction]() {
+        _endWrite(txn, transaction);
+    });
+    while (true) {
+        std::optional<LockRequest> blocked;
+        {
+            std::shared_lock catalog(catalogLatch_);
+            Table& table = _getTable(entityName);
+            std::unique_lock tableLatch(table.latch);
+            Entity& entity = table.entity;
+            Filter::RowPredicate pred =
+              filter ? filter->bind(entity) : nullptr;
+            // Rows deleted by running transactions are still current, so
+            // their locks are waited for.
+            Snapshot current = _currentSnapshot(txn);
+            std::vector<std::size_t> victims;
+            for (auto& version : entity.getRowVersions()) {
+                if (!version.visibleTo(current)) {
+                    continue;
+                }
+                if (pred) {
+                    Row row(version.blockNum);
+                    storage_.load(row);
+                    if (!pred(row.getValues())) {
+                        continue;
+                    }
+                }
+                victims.push_back(version.blockNum);
+            }
+            blocked = _tryLockForWrite(
+              txn, table, LockMode::intention_exclusive, victims, transaction);
+            if (!blocked.has_value()) {
+                // The rows stay readable by snapshots taken before the
+                // deletion, and their blocks are reclaimed once none of
+                // those is left.
+                entity.deleteRowVersions(victims, txn);
+                _endWrite(txn, transaction);
+                _pruneRowVersions(entity);
+                return victims.size();
+            }
+        }
+        _waitForLock(txn, blocked.value(), transaction);
+    }
+}
+
+std::size_t Database::truncateTable(const std::string& entityName,
+                                   Transaction* transaction) {
+    TxnId txn = _beginWrite(transaction);
+    Finally end([this, txn, transaction]() {
+        _endWrite(txn, transaction);
+    });
+    while (true) {
+        std::optional<LockRequest> blocked;
+        {
+            std::shared_lock catalog(catalogLatch_);
+            Table& table = _getTable(entityName);
+            std::unique_lock tableLatch(table.latch);
+            // Locking the whole table keeps out writers of any of its rows,
+            // so every live version is committed or the transaction's own.
+            blocked = _tryLockForWrite(txn, table, LockMode::exclusive, {},
+                                       transaction);
+            if (!blocked.has_value()) {
+                std::size_t rowCount = table.entity.deleteAllRowVersions(txn);
+                _endWrite(txn, transaction);
+                _pruneRowVersions(table.entity);
+                return rowCount;
+            }
+        }
+        _waitForLock(txn, blocked.value(), transaction);
+    }
+}
+
+std::size_t Database::updateTable(
+  const std::string& entityName,
+  const std::vector<std::pair<std::string, Value>>& assignments,
+  const Filter* filter, Transaction* transaction) {
+    TxnId txn = _beginWrite(transaction);
+    Finally end([this, txn, transaction]() {
+        _endWrite(txn, transaction);
+    });
+    while (true) {
+        std::optional<LockRequest> blocked;
+        {
+            std::shared_lock catalog(catalogLatch_);
+            Table& table = _getTable(entityName);
+            std::unique_lock tableLatch(table.latch);
+            Entity& entity = table.entity;
+            auto& attributes = entity.getAttributes();
+            std::vector<std::size_t> attrIndexes;
+            attrIndexes.reserve(assignments.size());
+            std::vector<std::pair<std::size_t, Value>> updates;
+            updates.reserve(assignments.size());
+            for (auto& [attrName, value] : assignments) {
+                std::size_t attrIndex = entity.attributeIndex(attrName);
+                auto& attribute = attributes[attrIndex];
+                URSQL_EXPECT(!value.isNull() || attribute.isNullable(),
+                             InvalidCommand,
+                             std::format("'{}' can't be null", attrName));
+                attrIndexes.push_back(attrIndex);
+                updates.emplace_back(attrIndex,
+                                     value.cast(attribute.getType()));
+            }
+            validateSpecifiedAttributes(attributes, attrIndexes);
+
+            Filter::RowPredicate pred =
+              filter ? filter->bind(entity) : nullptr;
+            std::size_t rowCount = 0;
+            // Changes made in place couldn't be rolled back. Open
+            // transactions hold snapshots, so none has uncommitted changes
+            // here and the rows need no locks.
+            if (!transaction && _enterInPlace()) {
+                Finally leave([this]() {
+                    _leaveInPlace();
+                });
+                blocked = _tryLockForWrite(
+                  txn, table, LockMode::intention_exclusive, {}, nullptr);
+                if (!blocked.has_value()) {
+                    // Every row is checked to fit its block before any is
+                    // written, so that one outgrowing it leaves them all
+                    // unchanged.
+                    std::size_t payloadSize =
+                      storage_.getBlockSize() - sizeof(BlockType);
+                    std::vector<std::size_t> blockNums;
+                    for (auto& version : entity.getRowVersions()) {
+                        if (!version.isLive()) {
+                            continue;
+                        }
+                        Row row(version.blockNum);
+                        storage_.load(row);
+                        if (pred && !pred(row.getValues())) {
+                            continue;
+                        }
+                        URSQL_EXPECT(row.getEncodedSize(updates) <=
+                                       payloadSize,
+                                     InvalidCommand,
+                                     "updated row doesn't fit its block");
+                        blockNums.push_back(version.blockNum);
+                    }
+                    // Fields which keep their encoded size are patched in
+                    // the cached block; the others re-encode their row.
+                    for (std::size_t blockNum : blockNums) {
+                        storage_.updateBlock(
+                          blockNum, [&](Block& block, std::size_t) {
+                              Row row(blockNum);
+                              row.decode(block);
+                              row.updateInBlock(block, updates);
+                              return true;
+                          });
+                    }
+                    rowCount = blockNums.size();
+                    _endWrite(txn, nullptr);
+                }
+            } else {
+                // Snapshots are being read, so the rows get new versions
+                // instead.
+                Snapshot current = _currentSnapshot(txn);
+                std::vector<std::size_t> oldBlockNums;
+                std::vector<std::vector<Value>> valueRows;
+                for (auto& version : entity.getRowVersions()) {
+                    if (!version.visibleTo(current)) {
+                        continue;
+                    }
+                    Row row(version.blockNum);
+                    storage_.load(row);
+                    if (pred && !pred(row.getValues())) {
+                        continue;
+                    }
+                    std::vector<Value> values = row.releaseValues();
+                    for (auto& [attrIndex, value] : updates) {
+                        values[attrIndex] = value;
+                    }
+                    oldBlockNums.push_back(version.blockNum);
+                    valueRows.push_back(std::move(values));
+                }
+                blocked = _tryLockForWrite(txn, table,
+                                           LockMode::intention_exclusive,
+                                           oldBlockNums, transaction);
+                if (!blocked.has_value()) {
+                    entity.replaceRowVersions(
+                      oldBlockNums, _writeRows(table, std::move(valueRows)),
+                      txn);
+                    rowCount = oldBlockNums.size();
+                    _endWrite(txn, transaction);
+                }
+            }
+            if (!blocked.has_value()) {
+                _pruneRowVersions(entity);
+                if (rowCount > 0) {
+                    for (auto& [attrIndex, value] : updates) {
+                        if (attributes[attrIndex].isAutoInc()) {
+                            entity.updateAutoInc(value.toInteger());
+                        }
+                    }
+                }
+                storage_.flush();
+                return rowCount;
+            }
+        }
+        _waitForLock(txn, blocked.value(), transaction);
+    }
+}
+
+std::unique_ptr<Transaction> Database::beginTransaction() {
+    TxnId txn = _beginTxn();
+    return std::make_unique<Transaction>(txn, _takeSnapshot(txn));
+}
+
+void Database::commit(Transaction& transaction) {
+    std::shared_lock catalog(catalogLatch_);
+    // New snapshots see every change of the transaction from here on.
+    _endTxn(transaction.getId());
+    _releaseSnapshot(transaction.getSnapshot());
+    for (auto& entityName : transaction.getChangedTables()) {
+        Table& table = _getTable(entityName);
+        std::unique_lock tableLatch(table.latch);
+        _pruneRowVersions(table.entity);
+        // Other transactions may have uncommitted versions in the table, so
+        // only what has committed is saved.
+        _saveEntityAsOf(table.entity, _currentSnapshot(0));
+    }
+    storage_.flush();
+    lockManager_.unlockAll(transaction.getId());
+    transaction.end();
+}
+
+void Database::rollback(Transaction& transaction) {
+    std::shared_lock catalog(catalogLatch_);
+    for (auto& entityName : transaction.getChangedTables()) {
+        Table& table = _getTable(entityName);
+        std::unique_lock tableLatch(table.latch);
+        // No snapshot sees the new versions, so their blocks are free now.
+        std::vector<std::size_t> blockNums =
+          table.entity.rollbackRowVersions(transaction.getId());
+        std::scoped_lock allocation(allocationLatch_);
+        _releaseLater(std::move(blockNums));
+    }
+    _endTxn(transaction.getId());
+    _releaseSnapshot(transaction.getSnapshot());
+    lockManager_.unlockAll(transaction.getId());
+    transaction.end();
+}
+
+std::size_t Database::reclaimVersions() {
+    std::shared_lock catalog(catalogLatch_);
+    std::vector<Table*> tables;
+    {
+        std::scoped_lock cache(entityCacheLatch_);
+        tables.reserve(entityCache_.size());
+        for (auto& [_, table] : entityCache_) {
+            tables.push_back(&table);
+        }
+    }
+    std::size_t reclaimed = 0;
+    for (Table* table : tables) {
+        // Tables being written are pruned by their writer.
+        std::unique_lock tableLatch(table->latch, std::try_to_lock);
+        if (tableLatch.owns_lock()) {
+            reclaimed += _pruneRowVersions(table->entity);
+        }
+    }
+    return reclaimed;
+}
+
+std::size_t Database::vacuum(const std::optional<std::string>& entityName,
+                             std::size_t maxRows) {
+    std::shared_lock catalog(catalogLatch_);
+    std::vector<std::string> entityNames = entityName.has_value()
+                                             ? std::vector { *entityName }
+                                             : toc_.getAllEntityNames();
+    std::size_t moved = 0;
+    for (auto& name : entityNames) {
+        if (moved == maxRows) {
+            break;
+        }
+        moved += _compactTable(_getTable(name), maxRows - moved);
+    }
+    if (moved == 0) {
+        std::scoped_lock allocation(allocationLatch_);
+        std::size_t blockCnt = storage_.getBlockCount();
+        if (pendingFreeBlockNums_.empty() &&
+            (blockCnt == 0 ||
+             storage_.getBlockType(blockCnt - 1) != BlockType::free ||
+             reservedBlockNums_.contains(blockCnt - 1)))
+        {
+            return 0;
+        }
+    }
+    // Pruned rows may still be in the saved row directories, so they are
+    // saved before the blocks are cut off.
+    _saveTables();
+    std::scoped_lock allocation(allocationLatch_);
+    _releasePending();
+    // The extents of the tables left alone stay in the file.
+    std::size_t minBlockCount = 0;
+    for (std::size_t blockNum : reservedBlockNums_) {
+        minBlockCount = std::max(minBlockCount, blockNum + 1);
+    }
+    storage_.truncateFreeTail(minBlockCount);
+    return moved;
+}
+
+std::size_t Database::writeDirtyBlocks(std::size_t maxBlocks) {
+    return storage_.writeBackCold(maxBlocks);
+}
+
+void Database::checkpoint() {
+    std::shared_lock catalog(catalogLatch_);
+    _saveTables();
+}
+
+void Database::_saveTables() {
+    std::vector<Table*> tables;
+    {
+        std::scoped_lock cache(entityCacheLatch_);
+        tables.reserve(entityCache_.size());
+        for (auto& [_, table] : entityCache_) {
+            tables.push_back(&table);
+        }
+    }
+    for (Table* table : tables) {
+        std::unique_lock tableLatch(table->latch);
+        Entity& entity = table->entity;
+        if (!entity.isDirty()) {
+            continue;
+        }
+        Snapshot current = _currentSnapshot(0);
+        _saveEntityAsOf(entity, current);
+        // The entity stays dirty while it has uncommitted versions, so that
+        // they are saved once committed.
+        bool allCommitted = std::ranges::all_of(
+          entity.getRowVersions(), [&current](const RowVersion& version) {
+              return current.sees(version.xmin) &&
+                     (version.isLive() || current.sees(version.xmax));
+          });
+        if (allCommitted) {
+            entity.makeDirty(false);
+        }
+    }
+    storage_.flush();
 }
 
-std::size_t Database::_findFreeBlockNumber() {
-    std::size_t blockCnt = storage_.getBlockCount();
-    for (std::size_t i = 0; i < blockCnt; ++i) {
-        if (storage_.getBlockType(i) == BlockType::free) {
-            return i;
+// The rest of the table's extent goes first, then blocks left behind by
+// dropped or truncated tables, then free blocks found by one scan of the
+// file, then a new extent at its end, whose rest is kept for the table. The
+// numbers are sorted so that consecutive rows fill runs of adjacent blocks.
+std::vector<std::size_t> Database::_allocateBlockNumbers(std::size_t count,
+                                                         const Table* table) {
+    std::vector<std::size_t> blockNums;
+    blockNums.reserve(count);
+    if (table) {
+        if (auto it = extents_.find(table->name); it != std::end(extents_)) {
+            std::vector<std::size_t>& extent = it->second;
+            // They stay reserved until the scan below is done, as they are
+            // still free until written.
+            while (!extent.empty() && blockNums.size() < count) {
+                blockNums.push_back(extent.back());
+                extent.pop_back();
+            }
+            if (extent.empty()) {
+                extents_.erase(it);
+            }
+        }
+    }
+    while (blockNums.size() < count) {
+        std::optional<std::size_t> blockNum = _takePendingFreeBlock();
+        if (!blockNum.has_value()) {
+            break;
         }
+        blockNums.push_back(blockNum.value());
+    }
+    if (blockNums.size() < count) {
+        std::vector<BlockType> blockTypes = storage_.getBlockTypes();
+        for (std::size_t i = 0;
+             i < blockTypes.size() && blockNums.size() < count; ++i)
+        {
+            if (blockTypes[i] == BlockType::free &&
+                !reservedBlockNums_.contains(i))
+            {
+                blockNums.push_back(i);
+            }
+        }
+    }
+    for (std::size_t blockNum : blockNums) {
+        reservedBlockNums_.erase(blockNum);
+    }
+    if (std::size_t missing = count - blockNums.size(); missing > 0) {
+        std::size_t extentSize =
+          (missing + extentBlockCount - 1) / extentBlockCount *
+          extentBlockCount;
+        std::size_t first = storage_.appendFreeBlocks(extentSize);
+        for (std::size_t i = 0; i < missing; ++i) {
+            blockNums.push_back(first + i);
+        }
+        if (table && missing < extentSize) {
+            std::vector<std::size_t>& extent = extents_[table->name];
+            for (std::size_t i = extentSize; i > missing; --i) {
+                extent.push_back(first + i - 1);
+                reservedBlockNums_.insert(first + i - 1);
+            }
+        }
+    }
+    std::ranges::sort(blockNums);
+    return blockNums;
+}
+
+void Database::_releaseExtent(const std::string& entityName) {
+    if (auto it = extents_.find(entityName); it != std::end(extents_)) {
+        for (std::size_t blockNum : it->second) {
+            reservedBlockNums_.erase(blockNum);
+        }
+        extents_.erase(it);
     }
-    return blockCnt;
 }
 
 // StatusResult Database::dropTable(const std::string& anEntityName,
@@ -234,178 +1147,362 @@ std::size_t Database::_findFreeBlockNumber() {
 //     return theResult;
 // }
 //
-// StatusResult Database::deleteFromTable(const std::string& anEntityName,
-//                                        const Filter* aFilter) {
-//     StatusResult theResult(Error::no_error);
-//     if (_entityExists(anEntityName)) {
-//         Entity* theEntity = getEntityByName(anEntityName, theResult);
-//         if (theResult && aFilter) {
-//             theResult = aFilter->validate(*theEntity);
-//         }
-//         if (theResult) {
-//             std::vector<blocknum_t> theBlocknums;
-//             theResult = m_storage.visitBlocks(
-//               [aFilter, &theBlocknums](Block& aBlock, blocknum_t aBlocknum) {
-//                   if (aFilter) {
-//                       Row theRow(aBlocknum);
-//                       theRow.decode(aBlock);
-//                       if (aFilter->match(theRow)) {
-//                           theBlocknums.push_back(aBlocknum);
-//                       }
-//                   }
-//                   return StatusResult(Error::no_error);
-//               },
-//               theEntity->getRowPos());
-//
-//             if (theResult) {
-//                 theResult = m_storage.releaseBlocks(theBlocknums);
-//                 if (theResult) {
-//                     for (blocknum_t theBlocknum : theBlocknums) {
-//                         theEntity->dropRowPosition(theBlocknum);
-//                     }
-//                     theResult.setMessage("Query ok, " +
-//                                          std::to_string(theBlocknums.size())
-//                                          + " row(s) affected");
-//                 }
-//             }
-//         }
-//     } else {
-//         theResult.setError(Error::unknown_entity, '\'' + anEntityName +
-//         '\'');
-//     }
-//     return theResult;
-// }
-//
-// StatusResult Database::updateTable(const std::string& anEntityName,
-//                                    const Row::DataMap& aFieldValues,
-//                                    const Filter* aFilter) {
-//     StatusResult theResult(Error::no_error);
-//     if (_entityExists(anEntityName)) {
-//         Entity* theEntity = getEntityByName(anEntityName, theResult);
-//         for (auto iter = aFieldValues.cbegin();
-//              theResult && iter != aFieldValues.cend(); ++iter)
-//         {
-//             const std::string& theAttributeName = iter->first;
-//             if (theEntity->attributeExistsByName(theAttributeName)) {
-//                 const Attribute& theAttribute =
-//                   theEntity->getAttributeByName(theAttributeName);
-//                 if (theAttribute.getType() != iter->second.type()) {
-//                     theResult.setError(Error::keyValue_mismatch,
-//                                        '\'' + theAttributeName + '\'');
-//                 }
-//             } else {
-//                 theResult.setError(Error::unknown_attribute,
-//                                    '\'' + theAttributeName + '\'');
-//             }
-//         }
-//
-//         if (theResult && aFilter) {
-//             theResult = aFilter->validate(*theEntity);
-//         }
-//
-//         if (theResult) {
-//             size_type theRowCount = 0;
-//             theResult = m_storage.visitBlocks(
-//               [this, aFilter, &aFieldValues, &theRowCount](
-//                 Block& aBlock, blocknum_t aBlocknum) {
-//                   StatusResult theSubResult(Error::no_error);
-//                   Row theRow(aBlocknum);
-//                   theRow.decode(aBlock);
-//                   if (!aFilter || aFilter->match(theRow)) {
-//                       for (const auto& theKVPair : aFieldValues) {
-//                           theRow.updateField(theKVPair.first,
-//                           theKVPair.second);
-//                       }
-//                       theSubResult = m_storage.saveMonoStorable(theRow);
-//                       if (theSubResult) {
-//                           ++theRowCount;
-//                       }
-//                   }
-//                   return theSubResult;
-//               },
-//               theEntity->getRowPos());
-//
-//             if (theResult) {
-//                 theResult.setMessage("Query ok, " +
-//                                      std::to_string(theRowCount) +
-//                                      " row(s) affected");
-//             }
-//         }
-//         return theResult;
-//     } else {
-//         theResult.setError(Error::unknown_entity, '\'' + anEntityName +
-//         '\'');
-//     }
-//     return theResult;
-// }
-//
-Entity& Database::_getEntityByName(const std::string& entityName) {
+Database::Table& Database::_getTable(const std::string& entityName) {
+    std::scoped_lock cache(entityCacheLatch_);
     auto it = entityCache_.find(entityName);
     if (it == std::end(entityCache_)) {
         std::size_t blockNum = toc_.getEntityPosByName(entityName);
         Entity entity(blockNum);
         storage_.load(entity);
-        it = entityCache_.emplace(entityName, std::move(entity)).first;
+        Block block(BlockType::free, storage_.getBlockSize());
+        while (auto next = entity.getUndecodedDirectoryBlockNum()) {
+            storage_.readBlock(block, next.value());
+            entity.decodeDirectoryBlock(block);
+        }
+        it = entityCache_
+               .try_emplace(entityName, entityName, std::move(entity))
+               .first;
     }
     return it->second;
 }
 
 void Database::_addEntity(const std::string& entityName, Entity& entity) {
-    storage_.save(entity);
+    _saveEntity(entity);
     toc_.addEntity(entityName, entity.getBlockNum());
-    entityCache_.emplace(entityName, std::move(entity));
+    std::scoped_lock cache(entityCacheLatch_);
+    entityCache_.try_emplace(entityName, entityName, std::move(entity));
 }
 
-void Database::_dropEntity(const std::string& entityName) {
-    Entity& entity = _getEntityByName(entityName);
-    for (std::size_t rowBlockNum : entity.getRowBlockNums()) {
-        storage_.releaseBlock(rowBlockNum);
+std::optional<std::size_t> Database::_takePendingFreeBlock() {
+    while (!pendingFreeBlockNums_.empty()) {
+        auto& blockNums = pendingFreeBlockNums_.back();
+        if (!blockNums.empty()) {
+            std::size_t blockNum = blockNums.back();
+            blockNums.pop_back();
+            return blockNum;
+        }
+        pendingFreeBlockNums_.pop_back();
+    }
+    return std::nullopt;
+}
+
+void Database::_releaseLater(std::vector<std::size_t> blockNums) {
+    if (!blockNums.empty()) {
+        pendingFreeBlockNums_.push_back(std::move(blockNums));
+    }
+}
+
+void Database::_releasePending() {
+    std::vector<std::size_t> blockNums;
+    for (auto& pending : pendingFreeBlockNums_) {
+        blockNums.insert(std::end(blockNums), std::begin(pending),
+                         std::end(pending));
     }
+    storage_.releaseBlocks(std::move(blockNums));
+    pendingFreeBlockNums_.clear();
+}
+
+void Database::_dropEntity(const std::string& entityName) {
+    Entity& entity = _getTable(entityName).entity;
+    _releaseLater(entity.releaseRowBlockNums());
+    _releaseExtent(entityName);
+    storage_.releaseBlocks(entity.getDirectoryBlockNums());
     storage_.releaseBlock(entity.getBlockNum());
     toc_.dropEntity(entityName);
+    std::scoped_lock cache(entityCacheLatch_);
     entityCache_.erase(entityName);
+    schemaStamp_ = nextSchemaStamp();
 }
 
-void Database::_insertIntoTableInternal(
-  Entity& entity, const std::vector<std::size_t>& attrIndexes,
-  const std::vector<std::vector<Value>>& valueLists) {
-    auto& attributes = entity.getAttributes();
-    std::vector<bool> attrSpecified =
-      validateSpecifiedAttributes(attributes, attrIndexes);
-    validateInsertValueLists(valueLists, attributes, attrIndexes);
-    std::vector<std::vector<Value>> valueRows;
-    valueRows.reserve(valueLists.size());
-    for (auto& valueList : valueLists) {
-        std::vector<Value> valueRow(attributes.size());
-        for (std::size_t i = 0; i < attributes.size(); ++i) {
-            if (!attrSpecified[i]) {
-                auto& attribute = attributes[i];
-                URSQL_EXPECT(
-                  !attribute.mustBeSpecified(), InvalidCommand,
-                  std::format("'{}' must be specified", attribute.getName()));
-                valueRow[i] =
-                  attribute.isAutoInc() ?
-                    Value(static_cast<Value::int_t>(entity.getNextAutoInc())) :
-                    attribute.getDefaultValue();
+void Database::_saveEntity(Entity& entity) {
+    if (!entity.isDirty()) {
+        return;
+    }
+    std::vector<std::size_t> blockNums = entity.getDirectoryBlockNums();
+    std::size_t blockCount =
+      entity.getDirectoryBlockCount(storage_.getBlockSize() -
+                                    sizeof(BlockType));
+    if (blockCount != blockNums.size()) {
+        std::scoped_lock allocation(allocationLatch_);
+        if (blockCount > blockNums.size()) {
+            std::vector<std::size_t> more =
+              _allocateBlockNumbers(blockCount - blockNums.size(), nullptr);
+            blockNums.insert(std::end(blockNums), std::begin(more),
+                             std::end(more));
+        } else {
+            _releaseLater(std::vector(std::begin(blockNums) + blockCount,
+                                      std::end(blockNums)));
+            blockNums.resize(blockCount);
+        }
+        entity.setDirectoryBlockNums(std::move(blockNums));
+    }
+    auto write = [this](const Block& block, std::size_t blockNum) {
+        storage_.writeBlock(block, blockNum);
+    };
+    entity.encodeDirectoryBlocks(storage_.getBlockSize(), write);
+    storage_.save(entity);
+}
+
+void Database::_saveEntityAsOf(Entity& entity, const Snapshot& snapshot) {
+    Entity saved = entity.copyAsOf(snapshot);
+    _saveEntity(saved);
+    entity.setDirectoryBlockNums(saved.getDirectoryBlockNums());
+}
+
+std::vector<std::size_t> Database::_writeRows(
+  const Table& table, std::vector<std::vector<Value>> valueRows) {
+    // Blocks are taken until they are written.
+    std::scoped_lock allocation(allocationLatch_);
+    std::vector<std::size_t> blockNums =
+      _allocateBlockNumbers(valueRows.size(), &table);
+    try {
+        _writeRowsTo(blockNums, std::move(valueRows));
+    } catch (...) {
+        // Nothing refers to the blocks, some of which may have been waiting
+        // to be released, so they go back there.
+        _releaseLater(blockNums);
+        throw;
+    }
+    return blockNums;
+}
+
+void Database::_writeRowsTo(const std::vector<std::size_t>& blockNums,
+                            std::vector<std::vector<Value>> valueRows) {
+    std::vector<Block> blocks;
+    blocks.reserve(valueRows.size());
+    for (std::size_t row = 0; row < valueRows.size(); ++row) {
+        Row(blockNums[row], std::move(valueRows[row]))
+          .encode(blocks.emplace_back(BlockType::row,
+                                      storage_.getBlockSize()));
+    }
+    // One write per run of adjacent blocks.
+    std::span<const Block> pending(blocks);
+    for (std::size_t row = 0; row < blockNums.size();) {
+        std::size_t end = row + 1;
+        while (end < blockNums.size() &&
+               blockNums[end] == blockNums[end - 1] + 1)
+        {
+            ++end;
+        }
+        storage_.writeBlocks(blockNums[row],
+                             pending.subspan(row, end - row));
+        row = end;
+    }
+}
+
+std::size_t Database::_compactTable(Table& table, std::size_t maxRows) {
+    TxnId txn = _beginWrite(nullptr);
+    Finally end([this, txn]() {
+        _endWrite(txn, nullptr);
+    });
+    std::unique_lock tableLatch(table.latch);
+    // Moving rows doesn't change them, so there's no point in waiting.
+    if (_tryLockForWrite(txn, table, LockMode::exclusive, {}, nullptr)) {
+        return 0;
+    }
+    Entity& entity = table.entity;
+    // Rows moved by an earlier pass may have been kept for a snapshot.
+    _pruneRowVersions(entity);
+    // With the table locked, its live versions are all committed.
+    std::vector<std::size_t> rowBlockNums;
+    for (auto& version : entity.getRowVersions()) {
+        if (version.isLive()) {
+            rowBlockNums.push_back(version.blockNum);
+        }
+    }
+    std::ranges::sort(rowBlockNums, std::greater());
+
+    std::vector<std::size_t> holes;
+    {
+        std::scoped_lock allocation(allocationLatch_);
+        _releasePending();
+        // The rows are packed, so the table has no use for its extent.
+        _releaseExtent(table.name);
+        std::vector<BlockType> blockTypes = storage_.getBlockTypes();
+        // The rows at the end of the file go to the holes at its start, for
+        // as long as that moves them down.
+        std::size_t hole = 0;
+        for (std::size_t blockNum : rowBlockNums) {
+            while (hole < blockNum &&
+                   (blockTypes[hole] != BlockType::free ||
+                    reservedBlockNums_.contains(hole)))
+            {
+                ++hole;
             }
+            if (hole >= blockNum || holes.size() == maxRows) {
+                break;
+            }
+            holes.push_back(hole++);
         }
-        for (std::size_t i = 0; i < attrIndexes.size(); ++i) {
-            std::size_t attrIndex = attrIndexes[i];
-            auto& attribute = attributes[attrIndex];
-            valueRow[attrIndex] = valueList[i].cast(attribute.getType());
-            if (attribute.isAutoInc()) {
-                entity.updateAutoInc(
-                  valueRow[attrIndex].raw<ValueType::int_type>());
+        if (holes.empty()) {
+            return 0;
+        }
+        // Every hole is below every moved row, so the moved rows can take
+        // the holes in the order of the table.
+        std::unordered_set<std::size_t> moving(
+          std::begin(rowBlockNums),
+          std::begin(rowBlockNums) + holes.size());
+        std::vector<std::size_t> oldBlockNums;
+        std::vector<std::vector<Value>> valueRows;
+        for (auto& version : entity.getRowVersions()) {
+            if (version.isLive() && moving.contains(version.blockNum)) {
+                Row row(version.blockNum);
+                storage_.load(row);
+                oldBlockNums.push_back(version.blockNum);
+                valueRows.push_back(row.releaseValues());
             }
         }
-        valueRows.push_back(std::move(valueRow));
+        _writeRowsTo(holes, std::move(valueRows));
+        entity.replaceRowVersions(oldBlockNums, holes, txn);
     }
-    for (auto& valueRow : valueRows) {
-        std::size_t blockNum = _findFreeBlockNumber();
-        Row row(blockNum, std::move(valueRow));
-        storage_.save(row);
-        entity.addRowPosition(blockNum);
+    _endWrite(txn, nullptr);
+    _pruneRowVersions(entity);
+    // The file refers to the new blocks before the old ones can be cut off.
+    _saveEntityAsOf(entity, _currentSnapshot(0));
+    storage_.flush();
+    return holes.size();
+}
+
+TxnId Database::_beginWrite(Transaction* transaction) {
+    return transaction ? transaction->getId() : _beginTxn();
+}
+
+void Database::_endWrite(TxnId txn, const Transaction* transaction) {
+    if (!transaction) {
+        _endTxn(txn);
+        lockManager_.unlockAll(txn);
+    }
+}
+
+std::optional<Database::LockRequest> Database::_tryLockForWrite(
+  TxnId txn, const Table& table, LockMode tableMode,
+  const std::vector<std::size_t>& blockNums, Transaction* transaction) {
+    LockRequest request{ LockTarget::ofTable(table.name), tableMode };
+    if (!lockManager_.tryLock(txn, request.target, request.mode)) {
+        return request;
+    }
+    request.mode = LockMode::exclusive;
+    for (std::size_t blockNum : blockNums) {
+        request.target = LockTarget::ofRow(table.name, blockNum);
+        if (!lockManager_.tryLock(txn, request.target, request.mode)) {
+            return request;
+        }
+    }
+    if (transaction) {
+        transaction->addChangedTable(table.name);
+    }
+    return std::nullopt;
+}
+
+void Database::_waitForLock(TxnId txn, const LockRequest& request,
+                            Transaction* transaction) {
+    try {
+        lockManager_.lock(txn, request.target, request.mode);
+    } catch (const Deadlock&) {
+        // Its locks are given up so that the others can go on.
+        if (transaction) {
+            rollback(*transaction);
+        }
+        throw;
+    }
+}
+
+TxnId Database::_beginTxn() {
+    std::scoped_lock txnLatch(txnLatch_);
+    runningTxns_.insert(++lastTxnId_);
+    return lastTxnId_;
+}
+
+void Database::_endTxn(TxnId txn) {
+    std::scoped_lock txnLatch(txnLatch_);
+    runningTxns_.erase(txn);
+}
+
+Snapshot Database::_takeSnapshot(TxnId own) {
+    std::unique_lock txnLatch(txnLatch_);
+    auto take = [this, own]() {
+        Snapshot snapshot = snapshotOf(lastTxnId_, runningTxns_, own);
+        snapshotHorizons_.insert(snapshot.horizon());
+        return snapshot;
+    };
+    if (inPlaceWriters_ == 0) {
+        return take();
+    }
+    // Registered while waiting so that no new writer goes in place, then
+    // retaken once the blocks are settled.
+    Snapshot waiting = take();
+    txnCond_.wait(txnLatch, [this]() {
+        return inPlaceWriters_ == 0;
+    });
+    Snapshot snapshot = take();
+    snapshotHorizons_.erase(snapshotHorizons_.find(waiting.horizon()));
+    return snapshot;
+}
+
+void Database::_releaseSnapshot(const Snapshot& snapshot) {
+    std::scoped_lock txnLatch(txnLatch_);
+    snapshotHorizons_.erase(snapshotHorizons_.find(snapshot.horizon()));
+}
+
+Snapshot Database::_currentSnapshot(TxnId own) {
+    std::scoped_lock txnLatch(txnLatch_);
+    return snapshotOf(lastTxnId_, runningTxns_, own);
+}
+
+bool Database::_enterInPlace() {
+    std::scoped_lock txnLatch(txnLatch_);
+    if (!snapshotHorizons_.empty()) {
+        return false;
+    }
+    ++inPlaceWriters_;
+    return true;
+}
+
+void Database::_leaveInPlace() {
+    {
+        std::scoped_lock txnLatch(txnLatch_);
+        --inPlaceWriters_;
+    }
+    txnCond_.notify_all();
+}
+
+std::size_t Database::_pruneRowVersions(Entity& entity) {
+    // Versions deleted by running transactions are kept too, in case they
+    // roll back.
+    TxnId horizon;
+    {
+        std::scoped_lock txnLatch(txnLatch_);
+        horizon = lastTxnId_ + 1;
+        if (!snapshotHorizons_.empty()) {
+            horizon = std::min(horizon, *std::begin(snapshotHorizons_));
+        }
+        if (!runningTxns_.empty()) {
+            horizon = std::min(horizon, *std::begin(runningTxns_));
+        }
+    }
+    std::vector<std::size_t> blockNums = entity.pruneRowVersions(horizon);
+    std::size_t pruned = blockNums.size();
+    std::scoped_lock allocation(allocationLatch_);
+    _releaseLater(std::move(blockNums));
+    return pruned;
+}
+
+std::unique_ptr<RowCursor> Database::_scanTable(Table& table,
+                                                const Snapshot& snapshot) {
+    std::shared_lock tableLatch(table.latch);
+    return std::make_unique<TableScanCursor>(
+      storage_, table.entity.getRowVersions(), snapshot);
+}
+
+std::unique_ptr<RowCursor> Database::_sortedScan(Table& table,
+                                                 const Snapshot& snapshot,
+                                                 std::size_t keyIndex) {
+    ExternalSorter sorter(keyIndex);
+    std::unique_ptr<RowCursor> scan = _scanTable(table, snapshot);
+    for (ValueRow row; scan->next(row);) {
+        sorter.add(std::move(row));
     }
+    return sorter.finish();
 }
 
 //
@@ -1,18 +1,34 @@
 #include "model/Entity.hpp"
 
 #include <format>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
+#include "common/Messaging.hpp"
 #include "exception/InternalError.hpp"
 #include "exception/UserError.hpp"
 #include "persistence/BufferStream.hpp"
 
 namespace ursql {
 
+namespace {
+
+// How many block numbers a directory block has room for, besides their
+// count and the number of the next directory block.
+std::size_t getDirectoryBlockCapacity(std::size_t payloadSize) {
+    return (payloadSize - 2 * sizeof(std::size_t)) / sizeof(std::size_t);
+}
+
+}  // namespace
+
 Entity::Entity(std::size_t blockNum)
     : MonoStorable(blockNum),
       attributes_(),
       autoInc_(0),
-      rowBlockNums_() {}
+      rowVersions_(),
+      directoryBlockNums_(),
+      undecodedDirectoryBlockNum_(npos) {}
 
 BlockType Entity::expectedBlockType() const {
     return BlockType::entity;
@@ -24,9 +40,20 @@ void Entity::serialize(BufferWriter& writer) const {
         writer << attribute;
     }
     writer << autoInc_;
-    writer << rowBlockNums_.size();
-    for (std::size_t blockNum : rowBlockNums_) {
-        writer << blockNum;
+    std::vector<std::size_t> blockNums = _getLiveBlockNums();
+    writer << blockNums.size();
+    // A directory that fits is laid out as before there were directory
+    // blocks. One that doesn't ends with the first directory block.
+    std::size_t capacity = writer.getRemaining() / sizeof(std::size_t);
+    bool continued = blockNums.size() > capacity;
+    URSQL_ASSERT(!continued || !directoryBlockNums_.empty(),
+                 "saving a row directory without its directory blocks");
+    std::size_t count = continued ? capacity - 1 : blockNums.size();
+    for (std::size_t i = 0; i < count; ++i) {
+        writer << blockNums[i];
+    }
+    if (continued) {
+        writer << directoryBlockNums_.front();
     }
 }
 
@@ -37,9 +64,14 @@ void Entity::deserialize(BufferReader& reader) {
         attributes_.emplace_back(reader.read<Attribute>());
     }
     reader >> autoInc_;
-    for (auto rowCount = reader.read<std::size_t>(); rowCount > 0; --rowCount) {
-        rowBlockNums_.push_back(reader.read<std::size_t>());
+    auto rowCount = reader.read<std::size_t>();
+    std::size_t capacity = reader.getRemaining() / sizeof(std::size_t);
+    bool continued = rowCount > capacity;
+    for (std::size_t i = continued ? capacity - 1 : rowCount; i > 0; --i) {
+        rowVersions_.push_back({ reader.read<std::size_t>(), 0, 0 });
     }
+    undecodedDirectoryBlockNum_ =
+      continued ? reader.read<std::size_t>() : npos;
 }
 
 void Entity::setAttributes(std::vector<Attribute> attributes) {
@@ -51,6 +83,12 @@ const std::vector<Attribute>& Entity::getAttributes() const {
     return attributes_;
 }
 
+bool Entity::attributeExists(std::string_view name) const {
+    return std::ranges::any_of(attributes_, [name](auto& attribute) {
+        return attribute.getName() == name;
+    });
+}
+
 std::size_t Entity::attributeIndex(std::string_view name) const {
     auto it = std::ranges::find_if(attributes_, [name](auto& attribute) {
         return attribute.getName() == name;
@@ -76,26 +114,234 @@ void Entity::updateAutoInc(std::size_t i) {
     }
 }
 
-void Entity::addRowPosition(std::size_t blockNum) {
-    auto it =
-      std::find(std::begin(rowBlockNums_), std::end(rowBlockNums_), blockNum);
-    URSQL_ASSERT(it == std::end(rowBlockNums_),
-                 std::format("block num {} already exists", blockNum));
-    rowBlockNums_.push_back(blockNum);
+void Entity::appendRowVersions(const std::vector<std::size_t>& blockNums,
+                               TxnId xmin) {
+    rowVersions_.reserve(rowVersions_.size() + blockNums.size());
+    for (std::size_t blockNum : blockNums) {
+        rowVersions_.push_back({ blockNum, xmin, 0 });
+    }
+    makeDirty(true);
+}
+
+void Entity::deleteRowVersions(const std::vector<std::size_t>& blockNums,
+                               TxnId xmax) {
+    if (blockNums.empty()) {
+        return;
+    }
+    std::unordered_set<std::size_t> deleted(std::begin(blockNums),
+                                            std::end(blockNums));
+    std::size_t marked = 0;
+    for (auto& version : rowVersions_) {
+        if (version.isLive() && deleted.contains(version.blockNum)) {
+            version.xmax = xmax;
+            ++marked;
+        }
+    }
+    URSQL_ASSERT(marked == deleted.size(),
+                 std::format("{} of {} row versions aren't live",
+                             deleted.size() - marked, deleted.size()));
+    makeDirty(true);
+}
+
+void Entity::replaceRowVersions(const std::vector<std::size_t>& oldBlockNums,
+                                const std::vector<std::size_t>& newBlockNums,
+                                TxnId txn) {
+    URSQL_ASSERT(oldBlockNums.size() == newBlockNums.size(),
+                 "every replaced row version needs a new one");
+    if (oldBlockNums.empty()) {
+        return;
+    }
+    std::unordered_map<std::size_t, std::size_t> replacements;
+    for (std::size_t i = 0; i < oldBlockNums.size(); ++i) {
+        replacements.emplace(oldBlockNums[i], newBlockNums[i]);
+    }
+    std::vector<RowVersion> rowVersions;
+    rowVersions.reserve(rowVersions_.size() + newBlockNums.size());
+    std::size_t replaced = 0;
+    for (auto& version : rowVersions_) {
+        rowVersions.push_back(version);
+        auto it = replacements.find(version.blockNum);
+        if (version.isLive() && it != std::end(replacements)) {
+            rowVersions.back().xmax = txn;
+            rowVersions.push_back({ it->second, txn, 0 });
+            ++replaced;
+        }
+    }
+    URSQL_ASSERT(replaced == replacements.size(),
+                 std::format("{} of {} row versions aren't live",
+                             replacements.size() - replaced,
+                             replacements.size()));
+    rowVersions_ = std::move(rowVersions);
+    makeDirty(true);
+}
+
+std::size_t Entity::deleteAllRowVersions(TxnId xmax) {
+    std::size_t marked = 0;
+    for (auto& version : rowVersions_) {
+        if (version.isLive()) {
+            version.xmax = xmax;
+            ++marked;
+        }
+    }
     makeDirty(true);
+    return marked;
 }
 
-void Entity::dropRowPosition(std::size_t blockNum) {
-    auto it =
-      std::find(std::begin(rowBlockNums_), std::end(rowBlockNums_), blockNum);
-    URSQL_ASSERT(it != std::end(rowBlockNums_),
-                 std::format("block num {} doesn't exist", blockNum));
-    rowBlockNums_.erase(it);
+std::vector<std::size_t> Entity::rollbackRowVersions(TxnId txn) {
+    std::vector<std::size_t> blockNums;
+    std::erase_if(rowVersions_, [&](const RowVersion& version) {
+        if (version.xmin != txn) {
+            return false;
+        }
+        blockNums.push_back(version.blockNum);
+        return true;
+    });
+    for (auto& version : rowVersions_) {
+        if (version.xmax == txn) {
+            version.xmax = 0;
+        }
+    }
     makeDirty(true);
+    return blockNums;
+}
+
+std::vector<std::size_t> Entity::pruneRowVersions(TxnId horizon) {
+    std::vector<std::size_t> blockNums;
+    std::erase_if(rowVersions_, [&](const RowVersion& version) {
+        if (version.isLive() || version.xmax >= horizon) {
+            return false;
+        }
+        blockNums.push_back(version.blockNum);
+        return true;
+    });
+    return blockNums;
 }
 
-const std::vector<std::size_t>& Entity::getRowBlockNums() const {
-    return rowBlockNums_;
+std::vector<std::size_t> Entity::releaseRowBlockNums() {
+    std::vector<std::size_t> blockNums;
+    blockNums.reserve(rowVersions_.size());
+    for (auto& version : rowVersions_) {
+        blockNums.push_back(version.blockNum);
+    }
+    rowVersions_.clear();
+    makeDirty(true);
+    return blockNums;
+}
+
+const std::vector<RowVersion>& Entity::getRowVersions() const {
+    return rowVersions_;
+}
+
+std::size_t Entity::getDirectoryBlockCount(std::size_t payloadSize) const {
+    std::size_t rowCount =
+      std::ranges::count_if(rowVersions_, &RowVersion::isLive);
+    std::size_t capacity = _getEntityBlockCapacity(payloadSize);
+    if (rowCount <= capacity) {
+        return 0;
+    }
+    URSQL_ASSERT(capacity > 0, "no room in the entity block for the number "
+                               "of the first directory block");
+    std::size_t rest = rowCount - (capacity - 1);
+    std::size_t blockCapacity = getDirectoryBlockCapacity(payloadSize);
+    return (rest + blockCapacity - 1) / blockCapacity;
+}
+
+const std::vector<std::size_t>& Entity::getDirectoryBlockNums() const {
+    return directoryBlockNums_;
+}
+
+void Entity::setDirectoryBlockNums(std::vector<std::size_t> blockNums) {
+    directoryBlockNums_ = std::move(blockNums);
+}
+
+void Entity::encodeDirectoryBlocks(std::size_t blockSize,
+                                   const DirectoryBlockWriter& write) const {
+    if (directoryBlockNums_.empty()) {
+        return;
+    }
+    std::vector<std::size_t> blockNums = _getLiveBlockNums();
+    Block block(BlockType::entity, blockSize);
+    std::size_t payloadSize = block.getPayloadSize();
+    std::size_t blockCapacity = getDirectoryBlockCapacity(payloadSize);
+    // Where the entity block leaves off.
+    std::size_t row = _getEntityBlockCapacity(payloadSize) - 1;
+    for (std::size_t i = 0; i < directoryBlockNums_.size(); ++i) {
+        std::size_t count = std::min(blockCapacity, blockNums.size() - row);
+        BufferWriter writer(block.getData(), payloadSize);
+        writer << count;
+        for (std::size_t end = row + count; row < end; ++row) {
+            writer << blockNums[row];
+        }
+        writer << (i + 1 < directoryBlockNums_.size() ?
+                     directoryBlockNums_[i + 1] :
+                     npos);
+        write(block, directoryBlockNums_[i]);
+    }
+    URSQL_ASSERT(row == blockNums.size(),
+                 std::format("{} directory blocks for {} rows",
+                             directoryBlockNums_.size(), blockNums.size()));
+}
+
+std::optional<std::size_t> Entity::getUndecodedDirectoryBlockNum() const {
+    if (undecodedDirectoryBlockNum_ == npos) {
+        return std::nullopt;
+    }
+    return undecodedDirectoryBlockNum_;
+}
+
+void Entity::decodeDirectoryBlock(const Block& block) {
+    URSQL_ASSERT(undecodedDirectoryBlockNum_ != npos,
+                 "the row directory is already complete");
+    URSQL_ASSERT(block.getType() == BlockType::entity,
+                 std::format("expected block type={}, actual={}",
+                             BlockType::entity, block.getType()));
+    directoryBlockNums_.push_back(undecodedDirectoryBlockNum_);
+    BufferReader reader(block.getData(), block.getPayloadSize());
+    for (auto count = reader.read<std::size_t>(); count > 0; --count) {
+        rowVersions_.push_back({ reader.read<std::size_t>(), 0, 0 });
+    }
+    reader >> undecodedDirectoryBlockNum_;
+}
+
+Entity Entity::copyAsOf(const Snapshot& snapshot) const {
+    Entity entity(getBlockNum());
+    entity.attributes_.reserve(attributes_.size());
+    for (auto& attribute : attributes_) {
+        entity.attributes_.push_back(attribute);
+    }
+    entity.autoInc_ = autoInc_;
+    for (auto& version : rowVersions_) {
+        if (version.visibleTo(snapshot)) {
+            entity.rowVersions_.push_back({ version.blockNum, 0, 0 });
+        }
+    }
+    entity.directoryBlockNums_ = directoryBlockNums_;
+    entity.makeDirty(true);
+    return entity;
+}
+
+std::vector<std::size_t> Entity::_getLiveBlockNums() const {
+    std::vector<std::size_t> blockNums;
+    blockNums.reserve(rowVersions_.size());
+    for (auto& version : rowVersions_) {
+        if (version.isLive()) {
+            blockNums.push_back(version.blockNum);
+        }
+    }
+    return blockNums;
+}
+
+std::size_t Entity::_getEntityBlockCapacity(std::size_t payloadSize) const {
+    // The attribute count, the attributes, the auto increment and the row
+    // count come before the block numbers.
+    std::size_t headerSize = sizeof(std::size_t) + sizeof(autoInc_) +
+                             sizeof(std::size_t);
+    for (auto& attribute : attributes_) {
+        headerSize += attribute.encodedSize();
+    }
+    return payloadSize > headerSize ?
+             (payloadSize - headerSize) / sizeof(std::size_t) :
+             0;
 }
 
 // StatusResult Entity::generateNewRow(Row& aRow, const StringList& aFieldNames,
@@ -0,0 +1,217 @@
+#include "model/LockManager.hpp"
+
+#include <algorithm>
+#include <format>
+#include <functional>
+#include <unordered_set>
+
+#include "exception/UserError.hpp"
+
+namespace ursql {
+
+namespace {
+
+bool compatible(LockMode held, LockMode wanted) {
+    switch (held) {
+    case LockMode::intention_shared:
+        return wanted != LockMode::exclusive;
+    case LockMode::intention_exclusive:
+        return wanted == LockMode::intention_shared ||
+               wanted == LockMode::intention_exclusive;
+    case LockMode::shared:
+        return wanted == LockMode::intention_shared ||
+               wanted == LockMode::shared;
+    case LockMode::exclusive:
+        return false;
+    }
+    return false;
+}
+
+bool covers(LockMode mode, LockMode other) {
+    return mode == other || mode == LockMode::exclusive ||
+           (other == LockMode::intention_shared &&
+            mode != LockMode::intention_shared);
+}
+
+// The weakest mode covering both; shared and intention exclusive together
+// take exclusive.
+LockMode combine(LockMode mode, LockMode other) {
+    if (covers(mode, other)) {
+        return mode;
+    }
+    if (covers(other, mode)) {
+        return other;
+    }
+    return LockMode::exclusive;
+}
+
+std::string describe(const LockTarget& target) {
+    if (target.blockNum == LockTarget::noRow) {
+        return std::format("table '{}'", target.entityName);
+    }
+    return std::format("row {} of table '{}'", target.blockNum,
+                       target.entityName);
+}
+
+}  // namespace
+
+LockTarget LockTarget::ofTable(std::string entityName) {
+    return { std::move(entityName), noRow };
+}
+
+LockTarget LockTarget::ofRow(std::string entityName, std::size_t blockNum) {
+    return { std::move(entityName), blockNum };
+}
+
+std::size_t LockManager::TargetHash::operator()(
+  const LockTarget& target) const {
+    return std::hash<std::string>()(target.entityName) ^
+           (std::hash<std::size_t>()(target.blockNum) * 0x9e3779b97f4a7c15);
+}
+
+LockManager::LockManager(std::chrono::milliseconds timeout)
+    : timeout_(timeout),
+      shards_(),
+      heldShards_(),
+      waitsForMutex_(),
+      waitsFor_() {}
+
+void LockManager::lock(TxnId txn, const LockTarget& target, LockMode mode) {
+    Shard& shard = _shardOf(target);
+    std::unique_lock lock(shard.mutex);
+    auto deadline = std::chrono::steady_clock::now() + timeout_;
+    bool waited = false;
+    while (true) {
+        std::vector<TxnId> blockers = _grant(shard, txn, target, mode);
+        if (blockers.empty()) {
+            if (waited) {
+                _stopWaiting(txn);
+            }
+            return;
+        }
+        _startWaiting(txn, std::move(blockers), target);
+        waited = true;
+        if (shard.cond.wait_until(lock, deadline) == std::cv_status::timeout &&
+            !_grant(shard, txn, target, mode).empty())
+        {
+            _stopWaiting(txn);
+            URSQL_THROW_NORMAL(LockTimeout, describe(target));
+        }
+    }
+}
+
+bool LockManager::tryLock(TxnId txn, const LockTarget& target,
+                          LockMode mode) {
+    Shard& shard = _shardOf(target);
+    std::scoped_lock lock(shard.mutex);
+    return _grant(shard, txn, target, mode).empty();
+}
+
+void LockManager::unlockAll(TxnId txn) {
+    std::vector<LockTarget> targets;
+    {
+        HeldShard& held = heldShards_[txn % shardCount];
+        std::scoped_lock lock(held.mutex);
+        auto it = held.targets.find(txn);
+        if (it == std::end(held.targets)) {
+            return;
+        }
+        targets = std::move(it->second);
+        held.targets.erase(it);
+    }
+    for (auto& target : targets) {
+        Shard& shard = _shardOf(target);
+        {
+            std::scoped_lock lock(shard.mutex);
+            auto it = shard.holders.find(target);
+            std::erase_if(it->second, [txn](const Holder& holder) {
+                return holder.txn == txn;
+            });
+            if (it->second.empty()) {
+                shard.holders.erase(it);
+            }
+        }
+        shard.cond.notify_all();
+    }
+}
+
+std::size_t LockManager::getLockedTargetCount() {
+    std::size_t count = 0;
+    for (auto& shard : shards_) {
+        std::scoped_lock lock(shard.mutex);
+        count += shard.holders.size();
+    }
+    return count;
+}
+
+LockManager::Shard& LockManager::_shardOf(const LockTarget& target) {
+    return shards_[TargetHash()(target) % shardCount];
+}
+
+std::vector<TxnId> LockManager::_grant(Shard& shard, TxnId txn,
+                                       const LockTarget& target,
+                                       LockMode mode) {
+    std::vector<TxnId> blockers;
+    // Targets only have an entry while someone holds them, so that failed
+    // attempts leave nothing behind.
+    auto it = shard.holders.find(target);
+    if (it != std::end(shard.holders)) {
+        std::vector<Holder>& holders = it->second;
+        auto own = std::ranges::find(holders, txn, &Holder::txn);
+        LockMode wanted =
+          own == std::end(holders) ? mode : combine(own->mode, mode);
+        for (auto& holder : holders) {
+            if (holder.txn != txn && !compatible(holder.mode, wanted)) {
+                blockers.push_back(holder.txn);
+            }
+        }
+        if (!blockers.empty()) {
+            return blockers;
+        }
+        if (own != std::end(holders)) {
+            own->mode = wanted;
+            return blockers;
+        }
+        holders.push_back({ txn, wanted });
+    } else {
+        shard.holders.emplace(target, std::vector<Holder>{ { txn, mode } });
+    }
+    HeldShard& held = heldShards_[txn % shardCount];
+    std::scoped_lock lock(held.mutex);
+    held.targets[txn].push_back(target);
+    return blockers;
+}
+
+void LockManager::_startWaiting(TxnId txn, std::vector<TxnId> blockers,
+                                const LockTarget& target) {
+    std::scoped_lock lock(waitsForMutex_);
+    // Whoever closes a cycle gives up, which breaks it.
+    std::vector<TxnId> pending = blockers;
+    std::unordered_set<TxnId> visited;
+    while (!pending.empty()) {
+        TxnId waiter = pending.back();
+        pending.pop_back();
+        if (waiter == txn) {
+            waitsFor_.erase(txn);
+            URSQL_THROW_NORMAL(
+              Deadlock, std::format("waiting for {} would never end, please "
+                                    "retry the transaction",
+                                    describe(target)));
+        }
+        if (!visited.insert(waiter).second) {
+            continue;
+        }
+        if (auto it = waitsFor_.find(waiter); it != std::end(waitsFor_)) {
+            pending.insert(std::end(pending), std::begin(it->second),
+                           std::end(it->second));
+        }
+    }
+    waitsFor_.insert_or_assign(txn, std::move(blockers));
+}
+
+void LockManager::_stopWaiting(TxnId txn) {
+    std::scoped_lock lock(waitsForMutex_);
+    waitsFor_.erase(txn);
+}
+
+}  // namespace ursql
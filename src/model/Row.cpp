@@ -1,5 +1,8 @@
 #include "model/Row.hpp"
 
+#include <algorithm>
+
+#include "exception/InternalError.hpp"
 #include "persistence/BufferStream.hpp"
 
 namespace ursql {
@@ -23,8 +26,60 @@ void Row::serialize(BufferWriter& writer) const {
 
 void Row::deserialize(BufferReader& reader) {
     auto sz = reader.read<std::size_t>();
+    values_.clear();
+    values_.reserve(sz);
     for (std::size_t i = 0; i < sz; ++i) {
-        values_[i] = reader.read<Value>();
+        values_.push_back(reader.read<Value>());
+    }
+}
+
+const std::vector<Value>& Row::getValues() const {
+    return values_;
+}
+
+std::vector<Value> Row::releaseValues() {
+    return std::move(values_);
+}
+
+std::size_t Row::getEncodedSize(
+  const std::vector<std::pair<std::size_t, Value>>& updates) const {
+    std::size_t size = sizeof(std::size_t);
+    for (auto& value : values_) {
+        size += value.encodedSize();
+    }
+    for (auto& [index, value] : updates) {
+        size = size - values_.at(index).encodedSize() + value.encodedSize();
+    }
+    return size;
+}
+
+void Row::updateInBlock(Block& block,
+                        std::vector<std::pair<std::size_t, Value>> updates) {
+    URSQL_ASSERT(block.getType() == expectedBlockType(),
+                 "updating a row in a block of another type");
+    bool sameLayout = std::ranges::all_of(updates, [this](auto& update) {
+        return values_.at(update.first).encodedSize() ==
+               update.second.encodedSize();
+    });
+    if (!sameLayout) {
+        for (auto& [index, value] : updates) {
+            values_[index] = std::move(value);
+        }
+        encode(block);
+        return;
+    }
+    // Fields are laid out back to back after the field count.
+    std::ranges::sort(updates, {}, &std::pair<std::size_t, Value>::first);
+    std::size_t offset = sizeof(std::size_t);
+    std::size_t index = 0;
+    for (auto& [updateIndex, value] : updates) {
+        for (; index < updateIndex; ++index) {
+            offset += values_[index].encodedSize();
+        }
+        std::size_t size = value.encodedSize();
+        BufferWriter writer(block.getData() + offset, size);
+        writer << value;
+        values_[updateIndex] = std::move(value);
     }
 }
 
@@ -19,7 +19,7 @@ std::size_t MonoStorable::getBlockNum() const {
 
 void MonoStorable::encode(Block& block) const {
     block.setType(expectedBlockType());
-    BufferWriter writer(block.getData(), Block::size);
+    BufferWriter writer(block.getData(), block.getPayloadSize());
     serialize(writer);
 }
 
@@ -29,7 +29,7 @@ void MonoStorable::decode(const Block& block) {
     URSQL_ASSERT(
       expected == actual,
       std::format("expected block type={}, actual={}", expected, actual));
-    BufferReader reader(block.getData(), Block::size);
+    BufferReader reader(block.getData(), block.getPayloadSize());
     deserialize(reader);
 }
 
@@ -7,21 +7,32 @@
 
 namespace ursql {
 
-TOC::TOC() : MonoStorable(0), entityPosMap_() {}
+TOC::TOC(std::size_t blockSize)
+    : MonoStorable(0),
+      blockSize_(blockSize),
+      entityPosMap_() {}
 
 BlockType TOC::expectedBlockType() const {
     return BlockType::toc;
 }
 
 void TOC::serialize(BufferWriter& writer) const {
-    writer << entityPosMap_.size();
+    writer << blockSize_ << entityPosMap_.size();
     for (auto& [entityName, blockNum] : entityPosMap_) {
         writer << entityName << blockNum;
     }
 }
 
 void TOC::deserialize(BufferReader& reader) {
+    // An old TOC, without the block size, starts with the table count,
+    // which a block of the least size has no room to make a valid size.
     auto mapSize = reader.read<std::size_t>();
+    if (Block::isValidSize(mapSize)) {
+        blockSize_ = mapSize;
+        reader >> mapSize;
+    } else {
+        blockSize_ = Block::minSize;
+    }
     for (; mapSize > 0; --mapSize) {
         auto entityName = reader.read<std::string>();
         auto blockNum = reader.read<std::size_t>();
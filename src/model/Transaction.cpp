@@ -0,0 +1,37 @@
+#include "model/Transaction.hpp"
+
+#include <utility>
+
+namespace ursql {
+
+Transaction::Transaction(TxnId id, Snapshot snapshot)
+    : id_(id),
+      snapshot_(std::move(snapshot)),
+      changedTables_(),
+      ended_(false) {}
+
+TxnId Transaction::getId() const {
+    return id_;
+}
+
+const Snapshot& Transaction::getSnapshot() const {
+    return snapshot_;
+}
+
+void Transaction::addChangedTable(const std::string& entityName) {
+    changedTables_.insert(entityName);
+}
+
+const std::set<std::string>& Transaction::getChangedTables() const {
+    return changedTables_;
+}
+
+void Transaction::end() {
+    ended_ = true;
+}
+
+bool Transaction::hasEnded() const {
+    return ended_;
+}
+
+}  // namespace ursql
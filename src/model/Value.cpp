@@ -1,6 +1,8 @@
 #include "model/Value.hpp"
 
 #include <format>
+#include <limits>
+#include <utility>
 
 #include "common/Messaging.hpp"
 #include "exception/InternalError.hpp"
@@ -20,37 +22,166 @@ struct overloaded : T... {
 template<typename... T>
 overloaded(T...) -> overloaded<T...>;
 
+// Calls f with the payload of val, as its null_t, int_t, float_t, bool_t,
+// varchar_t or bigint_t.
+template<typename F>
+decltype(auto) visitValue(const Value& val, F&& f) {
+    switch (val.getType()) {
+    case ValueType::null_type:
+        return f(val.raw<ValueType::null_type>());
+    case ValueType::int_type:
+        return f(val.raw<ValueType::int_type>());
+    case ValueType::float_type:
+        return f(val.raw<ValueType::float_type>());
+    case ValueType::bool_type:
+        return f(val.raw<ValueType::bool_type>());
+    case ValueType::varchar_type:
+        return f(val.raw<ValueType::varchar_type>());
+    case ValueType::bigint_type:
+        return f(val.raw<ValueType::bigint_type>());
+    default:
+        URSQL_UNREACHABLE(std::format("unknown value type {}", val.getType()));
+    }
+}
+
+bool isNumeric(ValueType type) {
+    return type == ValueType::int_type || type == ValueType::float_type ||
+           type == ValueType::bigint_type;
+}
+
+// Converts a number to an integer type, rejecting numbers that type can't
+// hold instead of wrapping them around.
+template<typename IntT, typename NumberT>
+IntT toIntegral(NumberT number) {
+    if constexpr (std::is_floating_point_v<NumberT>) {
+        // The minimum of a two's complement type is exact in floating point,
+        // and its negation is one past the maximum.
+        constexpr auto lowest =
+          static_cast<NumberT>(std::numeric_limits<IntT>::min());
+        URSQL_EXPECT(number >= lowest && number < -lowest, MisMatch,
+                     std::format("{} out of column type range", number));
+    } else {
+        URSQL_EXPECT(std::in_range<IntT>(number), MisMatch,
+                     std::format("{} out of column type range", number));
+    }
+    return static_cast<IntT>(number);
+}
+
+template<typename NumberT>
+Value castNumber(NumberT number, ValueType type) {
+    switch (type) {
+    case ValueType::int_type:
+        return Value(toIntegral<Value::int_t>(number));
+    case ValueType::float_type:
+        return Value(static_cast<Value::float_t>(number));
+    case ValueType::bigint_type:
+        return Value(toIntegral<Value::bigint_t>(number));
+    default:
+        URSQL_THROW_NORMAL(MisMatch, "column type and value type");
+    }
+}
+
 }  // namespace
 
-Value::Value(int_t intVal) noexcept(
-  std::is_nothrow_constructible_v<
-    Var, std::in_place_index_t<val_type_ordinal_v<ValueType::int_type>>, int_t>)
-    : var_(std::in_place_index<val_type_ordinal_v<ValueType::int_type>>,
-           intVal) {}
-
-Value::Value(float_t floatVal) noexcept(
-  std::is_nothrow_constructible_v<
-    Var, std::in_place_index_t<val_type_ordinal_v<ValueType::float_type>>,
-    float_t>)
-    : var_(std::in_place_index<val_type_ordinal_v<ValueType::float_type>>,
-           floatVal) {}
-
-Value::Value(bool_t boolVal) noexcept(
-  std::is_nothrow_constructible_v<
-    Var, std::in_place_index_t<val_type_ordinal_v<ValueType::bool_type>>,
-    bool_t>)
-    : var_(std::in_place_index<val_type_ordinal_v<ValueType::bool_type>>,
-           boolVal) {}
-
-Value::Value(varchar_t varcharVal) noexcept(
-  std::is_nothrow_constructible_v<
-    Var, std::in_place_index_t<val_type_ordinal_v<ValueType::varchar_type>>,
-    std::add_rvalue_reference_t<varchar_t>>)
-    : var_(std::in_place_index<val_type_ordinal_v<ValueType::varchar_type>>,
-           std::move(varcharVal)) {}
+Value::Value() noexcept {
+    _set<ValueType::null_type>({});
+}
+
+Value::Value(int_t intVal) noexcept {
+    _set<ValueType::int_type>(intVal);
+}
+
+Value::Value(float_t floatVal) noexcept {
+    _set<ValueType::float_type>(floatVal);
+}
+
+Value::Value(bool_t boolVal) noexcept {
+    _set<ValueType::bool_type>(boolVal);
+}
+
+Value::Value(varchar_t varcharVal) {
+    _setVarchar(varcharVal);
+}
+
+Value::Value(bigint_t bigintVal) noexcept {
+    _set<ValueType::bigint_type>(bigintVal);
+}
+
+Value::~Value() {
+    _release();
+}
+
+Value::Value(const Value& rhs) {
+    if (rhs._onHeap()) {
+        _setVarchar(rhs._varchar());
+    } else {
+        std::memcpy(bytes_, rhs.bytes_, sizeof(bytes_));
+    }
+}
+
+Value::Value(Value&& rhs) noexcept {
+    std::memcpy(bytes_, rhs.bytes_, sizeof(bytes_));
+    rhs._set<ValueType::null_type>({});
+}
+
+Value& Value::operator=(const Value& rhs) {
+    if (this != &rhs) {
+        Value copy(rhs);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+Value& Value::operator=(Value&& rhs) noexcept {
+    if (this != &rhs) {
+        _release();
+        std::memcpy(bytes_, rhs.bytes_, sizeof(bytes_));
+        rhs._set<ValueType::null_type>({});
+    }
+    return *this;
+}
+
+bool Value::_onHeap() const noexcept {
+    return getType() == ValueType::varchar_type &&
+           bytes_[lengthByte] == heapMark;
+}
+
+Value::varchar_t Value::_varchar() const noexcept {
+    if (!_onHeap()) {
+        return { reinterpret_cast<const char*>(bytes_), bytes_[lengthByte] };
+    }
+    const char* data;
+    std::uint32_t size;
+    std::memcpy(&data, bytes_, sizeof(data));
+    std::memcpy(&size, bytes_ + sizeof(data), sizeof(size));
+    return { data, size };
+}
+
+void Value::_setVarchar(varchar_t varcharVal) {
+    bytes_[typeByte] = static_cast<unsigned char>(ValueType::varchar_type);
+    if (varcharVal.size() <= inlineCapacity) {
+        std::memcpy(bytes_, varcharVal.data(), varcharVal.size());
+        bytes_[lengthByte] = static_cast<unsigned char>(varcharVal.size());
+        return;
+    }
+    URSQL_EXPECT(std::in_range<std::uint32_t>(varcharVal.size()), MisMatch,
+                 "varchar too long");
+    auto size = static_cast<std::uint32_t>(varcharVal.size());
+    char* data = new char[size];
+    std::memcpy(data, varcharVal.data(), size);
+    std::memcpy(bytes_, &data, sizeof(data));
+    std::memcpy(bytes_ + sizeof(data), &size, sizeof(size));
+    bytes_[lengthByte] = heapMark;
+}
+
+void Value::_release() noexcept {
+    if (_onHeap()) {
+        delete[] _varchar().data();
+    }
+}
 
 ValueType Value::getType() const {
-    return static_cast<ValueType>(var_.index());
+    return static_cast<ValueType>(bytes_[typeByte]);
 }
 
 bool Value::isNull() const {
@@ -63,7 +194,8 @@ bool Value::castableTo(ValueType type) const {
         return true;
     case ValueType::int_type:
     case ValueType::float_type:
-        return type == ValueType::int_type || type == ValueType::float_type;
+    case ValueType::bigint_type:
+        return isNumeric(type);
     case ValueType::bool_type:
         return type == ValueType::bool_type;
     case ValueType::varchar_type:
@@ -74,110 +206,120 @@ bool Value::castableTo(ValueType type) const {
 }
 
 Value Value::cast(ValueType type) const {
-    return std::visit(
+    return visitValue(
+      *this,
       overloaded{
         [](null_t) {
             return Value();
         },
         [type](int_t intVal) {
-            switch (type) {
-            case ValueType::int_type:
-                return Value(intVal);
-            case ValueType::float_type:
-                return Value(static_cast<float_t>(intVal));
-            default:
-                URSQL_THROW_NORMAL(MisMatch, "column type and value type");
-            }
+            return castNumber(intVal, type);
         },
         [type](float_t floatVal) {
-            switch (type) {
-            case ValueType::int_type:
-                return Value(static_cast<int_t>(floatVal));
-            case ValueType::float_type:
-                return Value(floatVal);
-            default:
-                URSQL_THROW_NORMAL(MisMatch, "column type and value type");
-            }
+            return castNumber(floatVal, type);
+        },
+        [type](bigint_t bigintVal) {
+            return castNumber(bigintVal, type);
         },
         [type](bool_t boolVal) {
             URSQL_EXPECT(type == ValueType::bool_type, MisMatch,
                          "column type and value type");
             return Value(boolVal);
         },
-        [type](const varchar_t& varcharVal) {
+        [type](varchar_t varcharVal) {
             URSQL_EXPECT(type == ValueType::varchar_type, MisMatch,
                          "column type and value type");
             return Value(varcharVal);
-        } },
-      var_);
+        } });
+}
+
+Value::bigint_t Value::toInteger() const {
+    switch (getType()) {
+    case ValueType::int_type:
+        return raw<ValueType::int_type>();
+    case ValueType::bigint_type:
+        return raw<ValueType::bigint_type>();
+    default:
+        URSQL_UNREACHABLE(std::format("{} is not an integer", toString()));
+    }
 }
 
 std::string Value::toString() const {
-    return std::visit(overloaded{ [](auto&& val) {
-                                     return std::to_string(val);
-                                 },
-                                  [](null_t) -> std::string {
-                                      return "NULL";
-                                  },
-                                  [](bool_t boolVal) -> std::string {
-                                      return boolVal ? "t" : "f";
-                                  },
-                                  [](const varchar_t& varcharVal) {
-                                      return varcharVal;
-                                  } },
-                      var_);
+    return visitValue(*this, overloaded{ [](auto val) {
+                                            return std::to_string(val);
+                                        },
+                                         [](null_t) -> std::string {
+                                             return "NULL";
+                                         },
+                                         [](bool_t boolVal) -> std::string {
+                                             return boolVal ? "t" : "f";
+                                         },
+                                         [](varchar_t varcharVal) {
+                                             return std::string(varcharVal);
+                                         } });
 }
 
 std::size_t Value::displayWidth() const {
+    if (getType() == ValueType::varchar_type) {
+        return _varchar().length();
+    }
     return toString().length();
 }
 
+std::size_t Value::encodedSize() const {
+    return sizeof(ValueType) +
+           visitValue(*this, overloaded{ [](auto val) {
+                                            return sizeof(val);
+                                        },
+                                         [](null_t) -> std::size_t {
+                                             return 0;
+                                         },
+                                         [](varchar_t varcharVal) {
+                                             return sizeof(std::size_t) +
+                                                    varcharVal.length();
+                                         } });
+}
+
 void Value::show(std::ostream& os) const {
-    std::visit(overloaded{ [&](auto&& val) {
-                              os << val;
-                          },
-                           [&](std::monostate) {
-                               os << "NULL";
-                           },
-                           [&](bool_t boolVal) {
-                               os << (boolVal ? 't' : 'f');
-                           },
-                           [&](const varchar_t&& varcharVal) {
-                               os << varcharVal;
-                           } },
-               var_);
+    visitValue(*this, overloaded{ [&](auto val) {
+                                     os << val;
+                                 },
+                                  [&](null_t) {
+                                      os << "NULL";
+                                  },
+                                  [&](bool_t boolVal) {
+                                      os << (boolVal ? 't' : 'f');
+                                  } });
 }
 
 void Value::serialize(BufferWriter& writer) const {
     writer << getType();
-    std::visit(overloaded{ [&](auto&& val) {
-                              writer << val;
-                          },
-                           [](null_t) {} },
-               var_);
+    visitValue(*this, overloaded{ [&](auto val) {
+                                     writer << val;
+                                 },
+                                  [](null_t) {} });
 }
 
 void Value::deserialize(BufferReader& reader) {
     auto type = reader.read<ValueType>();
     switch (type) {
     case ValueType::null_type:
-        var_.emplace<val_type_ordinal_v<ValueType::null_type>>();
+        *this = Value();
         break;
     case ValueType::int_type:
-        var_.emplace<val_type_ordinal_v<ValueType::int_type>>(
-          reader.read<int_t>());
+        *this = Value(reader.read<int_t>());
         break;
     case ValueType::float_type:
-        var_.emplace<val_type_ordinal_v<ValueType::float_type>>(
-          reader.read<float_t>());
+        *this = Value(reader.read<float_t>());
         break;
     case ValueType::bool_type:
-        var_.emplace<val_type_ordinal_v<ValueType::bool_type>>(
-          reader.read<bool_t>());
+        *this = Value(reader.read<bool_t>());
         break;
     case ValueType::varchar_type:
-        var_.emplace<val_type_ordinal_v<ValueType::varchar_type>>(
-          reader.read<varchar_t>());
+        *this = Value(reader.read<varchar_t>());
+        break;
+    case ValueType::bigint_type:
+        *this = Value(reader.read<bigint_t>());
         break;
     default:
         URSQL_UNREACHABLE(std::format("unknown value type: {}", type));
@@ -186,6 +328,11 @@ void Value::deserialize(BufferReader& reader) {
 
 namespace {
 
+// Literals are lexed without their sign, and the least bigint has one more
+// in magnitude than the greatest.
+constexpr const std::uint64_t maxNegativeMagnitude =
+  static_cast<std::uint64_t>(std::numeric_limits<Value::bigint_t>::max()) + 1;
+
 Value parseKeywordValue(Keyword keyword) {
     switch (keyword) {
     case Keyword::null_kw:
@@ -204,12 +351,35 @@ Value parseKeywordValue(Keyword keyword) {
 }  // namespace
 
 Value Value::parse(TokenStream& ts) {
+    URSQL_EXPECT(ts.hasNext(), MissingInput, "value");
+    if (ts.skipIf(Punctuation::question)) {
+        return ts.nextParam();
+    }
+    if (ts.skipIf(Operator::minus)) {
+        URSQL_EXPECT(ts.hasNext(), MissingInput, "number after '-'");
+        auto& token = ts.next();
+        if (auto pInteger = token.getIf<TokenType::integer>()) {
+            URSQL_EXPECT(*pInteger <= maxNegativeMagnitude, SyntaxError,
+                         std::format("-{} is out of range", *pInteger));
+            // Negated as unsigned, which wraps to the int64 value.
+            return fromInteger(static_cast<bigint_t>(0 - *pInteger));
+        }
+        auto pDecimal = token.getIf<TokenType::decimal>();
+        URSQL_EXPECT(pDecimal, MissingInput, "number after '-'");
+        return Value(-*pDecimal);
+    }
     auto& token = ts.next();
     switch (token.getType()) {
     case TokenType::keyword:
         return parseKeywordValue(token.get<TokenType::keyword>());
-    case TokenType::number:
-        return Value(token.get<TokenType::number>());
+    case TokenType::integer: {
+        std::uint64_t integer = token.get<TokenType::integer>();
+        URSQL_EXPECT(std::in_range<bigint_t>(integer), SyntaxError,
+                     std::format("{} is out of range", integer));
+        return fromInteger(static_cast<bigint_t>(integer));
+    }
+    case TokenType::decimal:
+        return Value(token.get<TokenType::decimal>());
     case TokenType::text:
         return Value(token.get<TokenType::text>());
     default:
@@ -219,6 +389,76 @@ Value Value::parse(TokenStream& ts) {
     }
 }
 
+Value Value::fromInteger(bigint_t integer) {
+    if (std::in_range<int_t>(integer)) {
+        return Value(static_cast<int_t>(integer));
+    }
+    return Value(integer);
+}
+
+namespace {
+
+// Orders values the way rows are sorted and compared: NULL first, numbers
+// compared numerically across int/bigint/float, everything else by type
+// ordinal so that mixed columns still get a strict weak ordering. Integers
+// are compared as integers, which a double can't do exactly past 2^53.
+int compareValues(const Value& lhs, const Value& rhs) {
+    auto three_way = [](auto&& a, auto&& b) {
+        return a < b ? -1 : (b < a ? 1 : 0);
+    };
+    return visitValue(lhs, [&](auto a) {
+        return visitValue(rhs, [&](auto b) -> int {
+            using A = decltype(a);
+            using B = decltype(b);
+            if constexpr (std::is_same_v<A, B>) {
+                if constexpr (std::is_same_v<A, Value::null_t>) {
+                    return 0;
+                } else {
+                    return three_way(a, b);
+                }
+            } else if constexpr (std::is_integral_v<A> &&
+                                 std::is_integral_v<B> &&
+                                 !std::is_same_v<A, Value::bool_t> &&
+                                 !std::is_same_v<B, Value::bool_t>)
+            {
+                return three_way(static_cast<Value::bigint_t>(a),
+                                 static_cast<Value::bigint_t>(b));
+            } else if constexpr (std::is_arithmetic_v<A> &&
+                                 std::is_arithmetic_v<B> &&
+                                 !std::is_same_v<A, Value::bool_t> &&
+                                 !std::is_same_v<B, Value::bool_t>)
+            {
+                return three_way(static_cast<double>(a),
+                                 static_cast<double>(b));
+            } else {
+                return three_way(lhs.getType(), rhs.getType());
+            }
+        });
+    });
+}
+
+}  // namespace
+
+bool operator<(const Value& lhs, const Value& rhs) {
+    return compareValues(lhs, rhs) < 0;
+}
+
+bool operator==(const Value& lhs, const Value& rhs) {
+    return compareValues(lhs, rhs) == 0;
+}
+
+bool operator>(const Value& lhs, const Value& rhs) {
+    return rhs < lhs;
+}
+
+bool operator<=(const Value& lhs, const Value& rhs) {
+    return !(rhs < lhs);
+}
+
+bool operator>=(const Value& lhs, const Value& rhs) {
+    return !(lhs < rhs);
+}
+
 std::ostream& operator<<(std::ostream& os, const Value& val) {
     val.show(os);
     return os;
@@ -0,0 +1,172 @@
+#include "parser/Lexer.hpp"
+
+#include <array>
+#include <charconv>
+#include <format>
+
+#include "exception/UserError.hpp"
+
+namespace ursql {
+
+namespace {
+
+constexpr const char singleQuote = '\'';
+
+enum CharClass : std::uint8_t {
+    space_cc = 1 << 0,
+    alpha_cc = 1 << 1,
+    digit_cc = 1 << 2,
+    punctuation_cc = 1 << 3,
+    comparator_cc = 1 << 4,
+    operator_cc = 1 << 5,
+    quote_cc = 1 << 6
+};
+
+constexpr const std::uint8_t separator_cc =
+  space_cc | punctuation_cc | comparator_cc | quote_cc;
+
+constexpr std::array<std::uint8_t, 256> makeCharClasses() {
+    std::array<std::uint8_t, 256> classes{};
+    auto mark = [&classes](std::string_view chars, std::uint8_t cc) {
+        for (char ch : chars) {
+            classes[static_cast<unsigned char>(ch)] |= cc;
+        }
+    };
+    mark(" \t\n\v\f\r", space_cc);
+    mark("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ", alpha_cc);
+    mark("0123456789", digit_cc);
+    mark(",()?", punctuation_cc);
+    mark("!<=>", comparator_cc);
+    mark("+-*/", operator_cc);
+    mark("\"'", quote_cc);
+    return classes;
+}
+
+constexpr const std::array<std::uint8_t, 256> charClasses = makeCharClasses();
+
+bool is(char ch, std::uint8_t cc) {
+    return (charClasses[static_cast<unsigned char>(ch)] & cc) != 0;
+}
+
+// Digits with an optional fraction, e.g. "12" or "3.25".
+bool isNumber(std::string_view str) {
+    auto digitsEnd = [&str](std::size_t pos) {
+        while (pos < str.size() && is(str[pos], digit_cc)) {
+            ++pos;
+        }
+        return pos;
+    };
+    std::size_t intEnd = digitsEnd(0);
+    if (intEnd == 0) {
+        return false;
+    }
+    if (intEnd == str.size()) {
+        return true;
+    }
+    return str[intEnd] == '.' && intEnd + 1 < str.size() &&
+           digitsEnd(intEnd + 1) == str.size();
+}
+
+// Literals without a fraction become unsigned 64-bit integers so that they
+// keep every digit, and a leading '-' can still make the least int64 of
+// them; the rest become floats.
+Token toNumber(std::string_view str) {
+    URSQL_EXPECT(isNumber(str), SyntaxError,
+                 std::format("{} is not a number", str));
+    const char* first = str.data();
+    const char* last = str.data() + str.size();
+    if (str.find('.') == std::string_view::npos) {
+        std::uint64_t integer = 0;
+        auto [ptr, ec] = std::from_chars(first, last, integer);
+        URSQL_EXPECT(ec == std::errc(), SyntaxError,
+                     std::format("{} is out of range", str));
+        return Token(token_type_index<TokenType::integer>, integer);
+    }
+    float decimal = 0;
+    auto [ptr, ec] =
+      std::from_chars(first, last, decimal, std::chars_format::fixed);
+    URSQL_EXPECT(ec == std::errc(), SyntaxError,
+                 std::format("{} is out of range", str));
+    return Token(token_type_index<TokenType::decimal>, decimal);
+}
+
+}  // namespace
+
+Lexer::Lexer(std::string_view text)
+    : cur_(text.data()),
+      end_(text.data() + text.size()) {}
+
+TokenList Lexer::lex(std::pmr::memory_resource* resource) {
+    TokenList tokens(resource);
+    while (cur_ != end_) {
+        char ch = *cur_;
+        if (is(ch, space_cc)) {
+            ++cur_;
+        } else if (is(ch, alpha_cc)) {
+            std::string_view str = _readUntilSeparator();
+            if (std::optional<Keyword> keyword = findKeyword(str)) {
+                tokens.emplace_back(token_type_index<TokenType::keyword>,
+                                    keyword.value());
+            } else {
+                tokens.emplace_back(token_type_index<TokenType::identifier>,
+                                    str);
+            }
+        } else if (is(ch, punctuation_cc)) {
+            tokens.emplace_back(token_type_index<TokenType::punctuation>,
+                                toPunctuation(ch));
+            ++cur_;
+        } else if (is(ch, comparator_cc)) {
+            std::string_view str = _readComparator();
+            URSQL_EXPECT(strIsComparator(str), SyntaxError,
+                         std::format("{} is not a comparator", str));
+            tokens.emplace_back(token_type_index<TokenType::comparator>,
+                                toComparator(str));
+        } else if (is(ch, digit_cc)) {
+            tokens.push_back(toNumber(_readUntilSeparator()));
+        } else if (is(ch, operator_cc)) {
+            tokens.emplace_back(token_type_index<TokenType::op>,
+                                toOperator(ch));
+            ++cur_;
+        } else if (is(ch, quote_cc)) {
+            std::string_view str = _readQuoted(ch);
+            if (ch == singleQuote) {
+                tokens.emplace_back(token_type_index<TokenType::text>, str);
+            } else {
+                tokens.emplace_back(token_type_index<TokenType::identifier>,
+                                    str);
+            }
+        } else {
+            URSQL_THROW_NORMAL(SyntaxError,
+                               std::format("unknown character {}", ch));
+        }
+    }
+    return tokens;
+}
+
+std::string_view Lexer::_readUntilSeparator() {
+    const char* begin = cur_;
+    while (cur_ != end_ && !is(*cur_, separator_cc)) {
+        ++cur_;
+    }
+    return { begin, cur_ };
+}
+
+std::string_view Lexer::_readComparator() {
+    const char* begin = cur_;
+    while (cur_ != end_ && is(*cur_, comparator_cc)) {
+        ++cur_;
+    }
+    return { begin, cur_ };
+}
+
+std::string_view Lexer::_readQuoted(char quote) {
+    const char* begin = ++cur_;
+    while (cur_ != end_ && *cur_ != quote) {
+        ++cur_;
+    }
+    URSQL_EXPECT(cur_ != end_, SyntaxError,
+                 std::format("a closing quote {} is missing", quote));
+    return { begin, cur_++ };
+}
+
+}  // namespace ursql
@@ -4,27 +4,48 @@
 #include "parser/TokenStream.hpp"
 #include "statement/CreateTableStatement.hpp"
 #include "statement/DBStatement.hpp"
+#include "statement/DeleteFromTableStatement.hpp"
 #include "statement/DropTableStatement.hpp"
 #include "statement/InsertIntoTableStatement.hpp"
+#include "statement/LoadDataStatement.hpp"
+#include "statement/PreparedStatement.hpp"
+#include "statement/SelectStatement.hpp"
+#include "statement/TransactionStatement.hpp"
+#include "statement/TruncateTableStatement.hpp"
+#include "statement/UpdateTableStatement.hpp"
+#include "statement/VacuumStatement.hpp"
 
 namespace ursql::parser {
 
 namespace {
 
-std::unique_ptr<Statement> parseKeywordStatement(TokenStream& ts) {
+ResourcePtr<Statement> parseKeywordStatement(TokenStream& ts) {
     if (ts.skipIf(Keyword::help_kw)) {
-        return std::make_unique<HelpStatement>();
+        return allocateUnique<HelpStatement>(ts.getResource());
     }
     if (ts.skipIf(Keyword::version_kw)) {
-        return std::make_unique<VersionStatement>();
+        return allocateUnique<VersionStatement>(ts.getResource());
     }
     if (ts.skipIf(Keyword::quit_kw)) {
-        return std::make_unique<QuitStatement>();
+        return allocateUnique<QuitStatement>(ts.getResource());
+    }
+    if (ts.skipIf(Keyword::begin_kw)) {
+        return allocateUnique<BeginStatement>(ts.getResource());
+    }
+    if (ts.skipIf(Keyword::commit_kw)) {
+        return allocateUnique<CommitStatement>(ts.getResource());
+    }
+    if (ts.skipIf(Keyword::rollback_kw)) {
+        return allocateUnique<RollbackStatement>(ts.getResource());
+    }
+    if (ts.skipIf(Keyword::vacuum_kw)) {
+        return allocateUnique<VacuumStatement>(ts.getResource(),
+                                               std::nullopt);
     }
     URSQL_THROW_NORMAL(UnknownCommand, ts);
 }
 
-std::unique_ptr<Statement> parseCreateStatement(TokenStream& ts) {
+ResourcePtr<Statement> parseCreateStatement(TokenStream& ts) {
     if (ts.skipIf(Keyword::database_kw)) {
         return CreateDBStatement::parse(ts);
     }
@@ -34,7 +55,7 @@ std::unique_ptr<Statement> parseCreateStatement(TokenStream& ts) {
     URSQL_THROW_NORMAL(UnknownCommand, ts);
 }
 
-std::unique_ptr<Statement> parseDropStatement(TokenStream& ts) {
+ResourcePtr<Statement> parseDropStatement(TokenStream& ts) {
     if (ts.skipIf(Keyword::database_kw)) {
         return DropDBStatement::parse(ts);
     }
@@ -44,7 +65,7 @@ std::unique_ptr<Statement> parseDropStatement(TokenStream& ts) {
     URSQL_THROW_NORMAL(UnknownCommand, ts);
 }
 
-std::unique_ptr<Statement> parseShowStatement(TokenStream& ts) {
+ResourcePtr<Statement> parseShowStatement(TokenStream& ts) {
     if (ts.skipIf(Keyword::databases_kw)) {
         return ShowDBStatement::parse(ts);
     }
@@ -54,7 +75,7 @@ std::unique_ptr<Statement> parseShowStatement(TokenStream& ts) {
     URSQL_THROW_NORMAL(UnknownCommand, ts);
 }
 
-std::unique_ptr<Statement> parseDescStatement(TokenStream& ts) {
+ResourcePtr<Statement> parseDescStatement(TokenStream& ts) {
     if (ts.skipIf(Keyword::database_kw)) {
         return DescDBStatement::parse(ts);
     }
@@ -63,9 +84,9 @@ std::unique_ptr<Statement> parseDescStatement(TokenStream& ts) {
 
 }  // namespace
 
-std::unique_ptr<Statement> parse(TokenStream& ts) {
+ResourcePtr<Statement> parse(TokenStream& ts) {
     if (!ts.hasNext()) {
-        return std::make_unique<NopStatement>();
+        return allocateUnique<NopStatement>(ts.getResource());
     }
     if (ts.remaining() == 1) {
         return parseKeywordStatement(ts);
@@ -88,6 +109,33 @@ std::unique_ptr<Statement> parse(TokenStream& ts) {
     if (ts.skipIf(Keyword::insert_kw)) {
         return InsertIntoTableStatement::parse(ts);
     }
+    if (ts.skipIf(Keyword::select_kw)) {
+        return SelectStatement::parse(ts);
+    }
+    if (ts.skipIf(Keyword::delete_kw)) {
+        return DeleteFromTableStatement::parse(ts);
+    }
+    if (ts.skipIf(Keyword::update_kw)) {
+        return UpdateTableStatement::parse(ts);
+    }
+    if (ts.skipIf(Keyword::truncate_kw)) {
+        return TruncateTableStatement::parse(ts);
+    }
+    if (ts.skipIf(Keyword::load_kw)) {
+        return LoadDataStatement::parse(ts);
+    }
+    if (ts.skipIf(Keyword::vacuum_kw)) {
+        return VacuumStatement::parse(ts);
+    }
+    if (ts.skipIf(Keyword::prepare_kw)) {
+        return PrepareStatement::parse(ts);
+    }
+    if (ts.skipIf(Keyword::execute_kw)) {
+        return ExecuteStatement::parse(ts);
+    }
+    if (ts.skipIf(Keyword::deallocate_kw)) {
+        return DeallocateStatement::parse(ts);
+    }
     URSQL_THROW_NORMAL(UnknownCommand, ts);
 }
 
@@ -97,7 +145,7 @@ std::string parseNextIdentifier(TokenStream& ts) {
     URSQL_EXPECT(token.getType() == TokenType::identifier, UnexpectedInput,
                  std::format("token type should be identifier but was {}",
                              token.getType()));
-    return token.get<TokenType::identifier>();
+    return std::string(token.get<TokenType::identifier>());
 }
 
 std::string parseNextIdentifierAsLast(TokenStream& ts) {
@@ -0,0 +1,119 @@
+#include "parser/ScriptReader.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <utility>
+
+#include "exception/InternalError.hpp"
+
+namespace ursql {
+
+namespace {
+
+constexpr const std::string_view blank = " \t\n\v\f\r";
+constexpr const std::string_view delimOrQuote = ";'\"";
+
+}  // namespace
+
+ScriptReader::ScriptReader(int fd)
+    : fd_(fd),
+      mapping_(nullptr),
+      mappingSize_(0),
+      buffer_(),
+      text_(),
+      exhausted_(false) {
+    struct stat st {};
+    if (::fstat(fd_, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0 ||
+        ::lseek(fd_, 0, SEEK_CUR) != 0)
+    {
+        return;
+    }
+    auto size = static_cast<std::size_t>(st.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (mapping == MAP_FAILED) {
+        // Falls back to reading blocks.
+        return;
+    }
+    ::madvise(mapping, size, MADV_SEQUENTIAL);
+    mapping_ = mapping;
+    mappingSize_ = size;
+    text_ = std::string_view(static_cast<const char*>(mapping), size);
+    exhausted_ = true;
+}
+
+ScriptReader::~ScriptReader() {
+    if (mapping_) {
+        ::munmap(mapping_, mappingSize_);
+    }
+}
+
+bool ScriptReader::next(std::string_view& statement) {
+    while (true) {
+        std::size_t pos = 0;
+        char quote = '\0';
+        while (true) {
+            pos = quote ? text_.find(quote, pos) :
+                          text_.find_first_of(delimOrQuote, pos);
+            if (pos == std::string_view::npos) {
+                // Rescans only what the next block adds.
+                pos = text_.size();
+                if (_readBlock()) {
+                    continue;
+                }
+                statement = std::exchange(text_, {});
+                break;
+            }
+            if (quote) {
+                quote = '\0';
+            } else if (text_[pos] == ';') {
+                statement = text_.substr(0, pos);
+                text_.remove_prefix(pos + 1);
+                break;
+            } else {
+                quote = text_[pos];
+            }
+            ++pos;
+        }
+        if (statement.find_first_not_of(blank) != std::string_view::npos) {
+            return true;
+        }
+        if (text_.empty() && exhausted_) {
+            return false;
+        }
+    }
+}
+
+bool ScriptReader::_readBlock() {
+    if (exhausted_) {
+        return false;
+    }
+    // The unconsumed text is always the tail of the buffer; it moves to the
+    // front so that a statement spanning two blocks stays contiguous.
+    std::size_t keep = text_.size();
+    buffer_.erase(0, buffer_.size() - keep);
+    buffer_.resize(keep + blockSize);
+    std::size_t got = 0;
+    while (got < blockSize) {
+        ssize_t n = ::read(fd_, buffer_.data() + keep + got, blockSize - got);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        URSQL_EXPECT(n >= 0, FileAccessError,
+                     std::format("read error: {}", std::strerror(errno)));
+        if (n == 0) {
+            break;
+        }
+        got += static_cast<std::size_t>(n);
+    }
+    buffer_.resize(keep + got);
+    text_ = buffer_;
+    exhausted_ = got < blockSize;
+    return got > 0;
+}
+
+}  // namespace ursql
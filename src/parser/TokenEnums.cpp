@@ -1,5 +1,8 @@
 #include "parser/TokenEnums.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <cstring>
 #include <format>
 #include <unordered_map>
@@ -15,73 +18,92 @@ namespace {
 constexpr const char leftParen = '(';
 constexpr const char rightParen = ')';
 constexpr const char comma = ',';
+constexpr const char questionMark = '?';
 
-const std::unordered_map<std::string_view, Keyword> str2Keyword{
-    { "add", Keyword::add_kw },
-    { "and", Keyword::and_kw },
-    { "asc", Keyword::asc_kw },
-    { "auto_increment", Keyword::auto_increment_kw },
-    { "boolean", Keyword::boolean_kw },
-    { "by", Keyword::by_kw },
-    { "char", Keyword::char_kw },
-    { "create", Keyword::create_kw },
-    { "database", Keyword::database_kw },
-    { "databases", Keyword::databases_kw },
-    { "default", Keyword::default_kw },
-    { "delete", Keyword::delete_kw },
-    { "desc", Keyword::desc_kw },
-    { "describe", Keyword::describe_kw },
-    { "double", Keyword::double_kw },
-    { "drop", Keyword::drop_kw },
-    { "false", Keyword::false_kw },
-    { "float", Keyword::float_kw },
-    { "from", Keyword::from_kw },
-    { "group", Keyword::group_kw },
-    { "help", Keyword::help_kw },
-    { "in", Keyword::in_kw },
-    { "insert", Keyword::insert_kw },
-    { "int", Keyword::integer_kw },
-    { "integer", Keyword::integer_kw },
-    { "into", Keyword::into_kw },
-    { "is", Keyword::is_kw },
-    { "key", Keyword::key_kw },
-    { "not", Keyword::not_kw },
-    { "null", Keyword::null_kw },
-    { "or", Keyword::or_kw },
-    { "order", Keyword::order_kw },
-    { "primary", Keyword::primary_kw },
-    { "quit", Keyword::quit_kw },
-    { "select", Keyword::select_kw },
-    { "set", Keyword::set_kw },
-    { "show", Keyword::show_kw },
-    { "table", Keyword::table_kw },
-    { "tables", Keyword::tables_kw },
-    { "true", Keyword::true_kw },
-    { "truncate", Keyword::truncate_kw },
-    { "unique", Keyword::unique_kw },
-    { "update", Keyword::update_kw },
-    { "use", Keyword::use_kw },
-    { "values", Keyword::values_kw },
-    { "varchar", Keyword::varchar_kw },
-    { "version", Keyword::version_kw },
-    { "where", Keyword::where_kw }
+struct KeywordEntry {
+    std::string_view str;
+    Keyword keyword;
 };
 
-const std::unordered_map<std::string_view, Comparator> str2Comparator{
-    { "=", Comparator::eq },  { "!=", Comparator::ne }, { "<", Comparator::lt },
-    { "<=", Comparator::le }, { ">", Comparator::gt },  { ">=", Comparator::ge }
+// Spellings that map to the same keyword as another one.
+constexpr const std::array keywordAliases{
+    KeywordEntry{ "int", Keyword::integer_kw },
+};
+
+constexpr const std::array keywordEntries = []() {
+    std::array entries{
+#define URSQL_KEYWORD_ENTRY(enumerator, str) \
+    KeywordEntry{ str, Keyword::enumerator },
+        URSQL_KEYWORDS(URSQL_KEYWORD_ENTRY)
+#undef URSQL_KEYWORD_ENTRY
+    };
+    std::array<KeywordEntry, entries.size() + keywordAliases.size()> all{};
+    std::ranges::copy(keywordAliases,
+                      std::ranges::copy(entries, std::begin(all)).out);
+    return all;
+}();
+
+constexpr const std::array keywordNames{
+#define URSQL_KEYWORD_NAME(enumerator, str) std::string_view(str),
+    URSQL_KEYWORDS(URSQL_KEYWORD_NAME)
+#undef URSQL_KEYWORD_NAME
 };
 
-std::string tolower(std::string_view str) {
-    std::string lowerStr;
-    lowerStr.reserve(str.length());
+constexpr char toLowerAscii(char ch) {
+    return ch >= 'A' && ch <= 'Z' ? static_cast<char>(ch - 'A' + 'a') : ch;
+}
+
+constexpr std::size_t maxKeywordLength =
+  std::ranges::max(keywordEntries, {}, [](auto& entry) {
+      return entry.str.length();
+  }).str.length();
+
+// A perfect hash over the keyword spellings: the seed is searched at compile
+// time so that no two keywords share a slot. Hashing lower-cases each
+// character so lookups are case-insensitive without a copy.
+constexpr const std::size_t keywordSlotCount = 512;
+constexpr const std::uint8_t emptyKeywordSlot = 0xff;
+
+static_assert(keywordEntries.size() < emptyKeywordSlot,
+              "keyword indexes should fit in a slot");
+
+constexpr std::size_t keywordSlot(std::string_view str, std::uint32_t seed) {
+    std::uint32_t hash = seed ^ static_cast<std::uint32_t>(str.length());
     for (char ch : str) {
-        lowerStr += std::char_traits<char>::to_char_type(
-          std::tolower(std::char_traits<char>::to_int_type(ch)));
+        hash = (hash ^ static_cast<unsigned char>(toLowerAscii(ch))) *
+               16777619u;
+    }
+    return (hash ^ (hash >> 15)) % keywordSlotCount;
+}
+
+struct KeywordTable {
+    std::uint32_t seed;
+    std::array<std::uint8_t, keywordSlotCount> slots;
+};
+
+constexpr KeywordTable makeKeywordTable() {
+    for (std::uint32_t seed = 2166136261u;; ++seed) {
+        KeywordTable table{ seed, {} };
+        std::ranges::fill(table.slots, emptyKeywordSlot);
+        bool collided = false;
+        for (std::size_t i = 0; i < keywordEntries.size() && !collided; ++i) {
+            auto& slot = table.slots[keywordSlot(keywordEntries[i].str, seed)];
+            collided = slot != emptyKeywordSlot;
+            slot = static_cast<std::uint8_t>(i);
+        }
+        if (!collided) {
+            return table;
+        }
     }
-    return lowerStr;
 }
 
+constexpr const KeywordTable keywordTable = makeKeywordTable();
+
+const std::unordered_map<std::string_view, Comparator> str2Comparator{
+    { "=", Comparator::eq },  { "!=", Comparator::ne }, { "<", Comparator::lt },
+    { "<=", Comparator::le }, { ">", Comparator::gt },  { ">=", Comparator::ge }
+};
+
 }  // namespace
 
 bool strIsComparator(std::string_view str) {
@@ -100,16 +122,36 @@ bool charIsComparator(char c) {
 }
 
 bool isKeyword(std::string_view str) {
-    std::string lowerStr = tolower(str);
-    return str2Keyword.find(lowerStr) != std::end(str2Keyword);
+    return findKeyword(str).has_value();
 }
 
 Keyword toKeyword(std::string_view str) {
-    std::string lowerStr = tolower(str);
-    auto it = str2Keyword.find(lowerStr);
-    URSQL_ASSERT(it != std::end(str2Keyword),
-                 std::format("{} is not a keyword", str));
-    return it->second;
+    std::optional<Keyword> keyword = findKeyword(str);
+    URSQL_ASSERT(keyword.has_value(), std::format("{} is not a keyword", str));
+    return keyword.value();
+}
+
+std::optional<Keyword> findKeyword(std::string_view str) {
+    if (str.empty() || str.length() > maxKeywordLength) {
+        return std::nullopt;
+    }
+    std::uint8_t index =
+      keywordTable.slots[keywordSlot(str, keywordTable.seed)];
+    if (index == emptyKeywordSlot) {
+        return std::nullopt;
+    }
+    auto& entry = keywordEntries[index];
+    if (!std::ranges::equal(str, entry.str, {}, toLowerAscii)) {
+        return std::nullopt;
+    }
+    return entry.keyword;
+}
+
+std::string_view toString(Keyword keyword) {
+    auto index = static_cast<std::size_t>(keyword);
+    URSQL_ASSERT(index < keywordNames.size(),
+                 std::format("unknown keyword {}", index));
+    return keywordNames[index];
 }
 
 bool isOperator(char c) {
@@ -132,7 +174,7 @@ Operator toOperator(char c) {
 }
 
 bool isPunctuation(char c) {
-    return strchr(",()", c) != nullptr;
+    return strchr(",()?", c) != nullptr;
 }
 
 Punctuation toPunctuation(char c) {
@@ -143,6 +185,8 @@ Punctuation toPunctuation(char c) {
         return Punctuation::lparen;
     case rightParen:
         return Punctuation::rparen;
+    case questionMark:
+        return Punctuation::question;
     default:
         URSQL_UNREACHABLE(std::format("{} is not a punctuation", c));
     }
@@ -1,10 +1,19 @@
 #include "parser/TokenStream.hpp"
 
+#include "exception/InternalError.hpp"
+#include "exception/UserError.hpp"
+#include "model/Value.hpp"
+
 namespace ursql {
 
-TokenStream::TokenStream(std::vector<Token>&& tokens)
-    : tokens_(std::move(tokens)),
-      i_(0) {}
+TokenStream::TokenStream(TokenList&& tokens,
+                         std::shared_ptr<const std::string> source)
+    : source_(std::move(source)),
+      tokens_(std::move(tokens)),
+      i_(0),
+      params_(nullptr),
+      paramIndex_(0),
+      resource_(tokens_.get_allocator().resource()) {}
 
 bool TokenStream::hasNext() const noexcept {
     return remaining() > 0;
@@ -50,6 +59,39 @@ bool TokenStream::skipIf(Punctuation punctuation) {
     });
 }
 
+bool TokenStream::skipIf(Comparator comparator) {
+    return skipIf([comparator](const Token& token) {
+        return token.is<TokenType::comparator>(comparator);
+    });
+}
+
+bool TokenStream::skipIf(Operator op) {
+    return skipIf([op](const Token& token) {
+        return token.is<TokenType::op>(op);
+    });
+}
+
+void TokenStream::bindParams(const ValueList& params) {
+    params_ = &params;
+    paramIndex_ = 0;
+}
+
+const Value& TokenStream::nextParam() {
+    URSQL_EXPECT(params_, UnexpectedInput,
+                 "'?' outside of a prepared statement");
+    URSQL_ASSERT(paramIndex_ < params_->size(),
+                 "more placeholders than bound parameters");
+    return (*params_)[paramIndex_++];
+}
+
+std::pmr::memory_resource* TokenStream::getResource() const noexcept {
+    return resource_;
+}
+
+void TokenStream::setResource(std::pmr::memory_resource* resource) noexcept {
+    resource_ = resource;
+}
+
 std::string TokenStream::_toString(std::size_t i) const {
     if (i >= tokens_.size()) {
         return {};
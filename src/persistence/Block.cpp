@@ -1,30 +1,53 @@
 #include "persistence/Block.hpp"
 
-#include "model/Storable.hpp"
-#include "persistence/BufferStream.hpp"
+#include <bit>
+#include <format>
 
-namespace ursql {
+#include "exception/InternalError.hpp"
 
-Block::Block(BlockType type) : type_(type), nullState_{} {}
+namespace ursql {
 
-Block::Block(const MonoStorable& aMonoStorable) : Block(BlockType::free) {
-    aMonoStorable.encode(*this);
+Block::Block(BlockType type, std::size_t size)
+    : size_(size),
+      bytes_(std::make_unique<char[]>(size)) {
+    URSQL_ASSERT(isValidSize(size), std::format("invalid block size {}", size));
+    setType(type);
 }
 
 BlockType Block::getType() const {
-    return type_;
+    return static_cast<BlockType>(bytes_[0]);
 }
 
 void Block::setType(BlockType type) {
-    type_ = type;
+    bytes_[0] = static_cast<char>(type);
 }
 
 const char* Block::getData() const {
-    return data_;
+    return bytes_.get() + sizeof(BlockType);
 }
 
 char* Block::getData() {
-    return data_;
+    return bytes_.get() + sizeof(BlockType);
+}
+
+std::size_t Block::getSize() const {
+    return size_;
+}
+
+std::size_t Block::getPayloadSize() const {
+    return size_ - sizeof(BlockType);
+}
+
+const char* Block::getBytes() const {
+    return bytes_.get();
+}
+
+char* Block::getBytes() {
+    return bytes_.get();
+}
+
+bool Block::isValidSize(std::size_t size) {
+    return size >= minSize && size <= maxSize && std::has_single_bit(size);
 }
 
 }  // namespace ursql
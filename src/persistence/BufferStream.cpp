@@ -5,6 +5,7 @@
 #include "common/Messaging.hpp"
 #include "exception/InternalError.hpp"
 #include "model/Storable.hpp"
+#include "model/Value.hpp"
 
 namespace ursql {
 
@@ -24,25 +25,48 @@ char* BufferData::getAndAdvance(std::size_t offset) {
     return p;
 }
 
+std::size_t BufferData::getRemaining() const {
+    return end_ - cbuf_;
+}
+
 }  // namespace detail
 
 BufferReader::BufferReader(const char* cbuf, std::size_t size)
     : bufData_(cbuf, size) {}
 
+std::size_t BufferReader::getRemaining() const {
+    return bufData_.getRemaining();
+}
+
 BufferReader& BufferReader::operator>>(std::string& str) {
     auto len = read<std::size_t>();
     str.assign(bufData_.getAndAdvance(len), len);
     return *this;
 }
 
+BufferReader& BufferReader::operator>>(std::string_view& str) {
+    auto len = read<std::size_t>();
+    str = std::string_view(bufData_.getAndAdvance(len), len);
+    return *this;
+}
+
 BufferReader& BufferReader::operator>>(ursql::Storable& storable) {
     storable.deserialize(*this);
     return *this;
 }
 
+BufferReader& BufferReader::operator>>(Value& value) {
+    value.deserialize(*this);
+    return *this;
+}
+
 BufferWriter::BufferWriter(char* buf, std::size_t size) : bufData_(buf, size) {}
 
-BufferWriter& BufferWriter::operator<<(const std::string& str) {
+std::size_t BufferWriter::getRemaining() const {
+    return bufData_.getRemaining();
+}
+
+BufferWriter& BufferWriter::operator<<(std::string_view str) {
     std::size_t len = str.length();
     (*this) << len;
     memcpy(bufData_.getAndAdvance(len), str.data(), len);
@@ -54,4 +78,9 @@ BufferWriter& BufferWriter::operator<<(const Storable& storable) {
     return *this;
 }
 
+BufferWriter& BufferWriter::operator<<(const Value& value) {
+    value.serialize(*this);
+    return *this;
+}
+
 }  // namespace ursql
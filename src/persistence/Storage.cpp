@@ -1,109 +1,321 @@
 #include "persistence/Storage.hpp"
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <format>
 #include <sstream>
 
+#include "common/Messaging.hpp"
 #include "exception/InternalError.hpp"
 #include "model/TOC.hpp"
+#include "persistence/BufferStream.hpp"
 
 namespace ursql {
 
-#ifdef ENABLE_BLOCKCACHE
-/* -------------------------------BlockCache------------------------------- */
-BlockCache::BlockCache(size_type aCapacity)
-    : m_capacity(aCapacity),
-      m_seq(),
-      m_pos() {}
+namespace {
+
+// The cache holds as many bytes whatever the block size.
+constexpr const std::size_t cacheBytes = 1 << 20;
+
+void copyBlock(Block& dst, const Block& src) {
+    URSQL_ASSERT(dst.getSize() == src.getSize(),
+                 std::format("copying a block of {} bytes into one of {}",
+                             src.getSize(), dst.getSize()));
+    std::memcpy(dst.getBytes(), src.getBytes(), src.getSize());
+}
 
-bool BlockCache::contains(blocknum_t aBlocknum) {
-    return m_pos.count(aBlocknum) == 1;
+int openForAllocation(const fs::path& filePath) {
+    int fd = ::open(filePath.c_str(), O_RDWR | O_CLOEXEC);
+    URSQL_EXPECT(fd >= 0, FileAccessError,
+                 std::format("unable to open file {}: {}", filePath.native(),
+                             std::strerror(errno)));
+    return fd;
 }
 
-void BlockCache::put(blocknum_t aBlocknum, const Block& aBlock) {
-    if (contains(aBlocknum)) {
-        _touch(aBlocknum)->second = std::make_unique<Block>(aBlock);
-    } else {
-        _add(aBlocknum, aBlock);
+}  // namespace
+
+/* -------------------------------BlockCache------------------------------- */
+BlockCache::BlockCache(std::size_t blockSize, std::size_t capacity)
+    : blockSize_(blockSize),
+      capacity_(capacity),
+      useSeq_(),
+      frames_() {
+    URSQL_ASSERT(capacity_ > 0, "block cache needs room for one block");
+}
+
+BlockCache::Frame* BlockCache::find(std::size_t blockNum) {
+    auto it = frames_.find(blockNum);
+    if (it == std::end(frames_)) {
+        return nullptr;
     }
+    useSeq_.splice(std::begin(useSeq_), useSeq_, it->second);
+    return &useSeq_.front();
+}
+
+bool BlockCache::full() const {
+    return useSeq_.size() >= capacity_;
+}
+
+BlockCache::Frame& BlockCache::insert(std::size_t blockNum) {
+    URSQL_ASSERT(!full(), "inserting into a full block cache");
+    URSQL_ASSERT(!frames_.contains(blockNum),
+                 std::format("block {} is already cached", blockNum));
+    useSeq_.push_front(
+      { blockNum, std::make_unique<Block>(BlockType::free, blockSize_),
+        false });
+    frames_.emplace(blockNum, std::begin(useSeq_));
+    return useSeq_.front();
+}
+
+BlockCache::Frame& BlockCache::getVictim() {
+    URSQL_ASSERT(!useSeq_.empty(), "evicting from an empty block cache");
+    return useSeq_.back();
 }
 
-const Block& BlockCache::get(blocknum_t aBlocknum) {
-    URSQL_TRUTH(contains(aBlocknum), "Getting a block that's not in cache");
-    return *(_touch(aBlocknum)->second);
+void BlockCache::evict() {
+    URSQL_ASSERT(!useSeq_.empty(), "evicting from an empty block cache");
+    frames_.erase(useSeq_.back().blockNum);
+    useSeq_.pop_back();
 }
 
-BlockCache::UseSequence::iterator BlockCache::_touch(blocknum_t aBlocknum) {
-    if (contains(aBlocknum)) {
-        auto theIter = m_pos[aBlocknum];
-        m_seq.push_front(std::move(*theIter));
-        m_seq.erase(theIter);
-        m_pos[aBlocknum] = m_seq.begin();
+void BlockCache::erase(std::size_t blockNum) {
+    auto it = frames_.find(blockNum);
+    if (it != std::end(frames_)) {
+        useSeq_.erase(it->second);
+        frames_.erase(it);
     }
-    return m_seq.begin();
 }
 
-void BlockCache::_add(blocknum_t aBlocknum, const Block& aBlock) {
-    m_seq.push_front({ aBlocknum, std::make_unique<Block>(aBlock) });
-    m_pos[aBlocknum] = m_seq.begin();
-    _adjustSize();
+std::vector<BlockCache::Frame*> BlockCache::getDirtyFrames() {
+    std::vector<Frame*> dirtyFrames;
+    for (auto& frame : useSeq_) {
+        if (frame.dirty) {
+            dirtyFrames.push_back(&frame);
+        }
+    }
+    return dirtyFrames;
 }
 
-void BlockCache::_adjustSize() {
-    if (m_seq.size() > m_capacity) {
-        _removeTail();
+std::vector<BlockCache::Frame*> BlockCache::getColdDirtyFrames(
+  std::size_t count) {
+    std::vector<Frame*> dirtyFrames;
+    for (auto it = std::rbegin(useSeq_);
+         it != std::rend(useSeq_) && dirtyFrames.size() < count; ++it)
+    {
+        if (it->dirty) {
+            dirtyFrames.push_back(&*it);
+        }
     }
+    return dirtyFrames;
 }
 
-void BlockCache::_removeTail() {
-    blocknum_t theBlocknum = m_seq.back().first;
-    m_seq.pop_back();
-    m_pos.erase(theBlocknum);
+void BlockCache::discardFrom(std::size_t blockNum) {
+    std::erase_if(useSeq_, [&](const Frame& frame) {
+        if (frame.blockNum < blockNum) {
+            return false;
+        }
+        frames_.erase(frame.blockNum);
+        return true;
+    });
 }
-#endif
 
 /* -------------------------------Storage------------------------------- */
-Storage::Storage(const fs::path& filePath, CreateNewFile)
-    : file_(filePath, std::ios_base::binary | std::ios_base::in |
-                        std::ios_base::out | std::ios_base::trunc) {
+Storage::Storage(const fs::path& filePath, CreateNewFile createNewFile)
+    : latch_(),
+      filePath_(filePath),
+      file_(filePath, std::ios_base::binary | std::ios_base::in |
+                        std::ios_base::out | std::ios_base::trunc),
+      fd_(-1),
+      blockSize_(createNewFile.blockSize),
+      blockCache_(blockSize_, cacheBytes / blockSize_),
+      blockCount_(0),
+      blockTypes_() {
     URSQL_EXPECT(file_, FileAccessError,
                  std::format("unable to create file {}", filePath.native()));
+    URSQL_ASSERT(Block::isValidSize(blockSize_),
+                 std::format("invalid block size {}", blockSize_));
+    fd_ = openForAllocation(filePath);
 }
 
 Storage::Storage(const fs::path& filePath, OpenExistingFile)
-    : file_(filePath,
-            std::ios_base::binary | std::ios_base::in | std::ios_base::out) {
-    URSQL_EXPECT(file_, FileAccessError,
-                 std::format("unable to open file {}", filePath.native()));
+    : latch_(),
+      filePath_(filePath),
+      file_(filePath,
+            std::ios_base::binary | std::ios_base::in | std::ios_base::out),
+      fd_(-1),
+      blockSize_(_readBlockSize()),
+      blockCache_(blockSize_, cacheBytes / blockSize_),
+      blockCount_(0),
+      blockTypes_() {
+    fd_ = openForAllocation(filePath);
+    file_.seekg(0, std::ios_base::end);
+    blockCount_ = static_cast<std::size_t>(file_.tellg()) / blockSize_;
+    _loadBlockTypes();
+}
+
+Storage::~Storage() {
+    // A destructor can't throw, so the error is only reported; callers who
+    // need to know call flush() first.
+    try {
+        if (file_.is_open()) {
+            _flush();
+        }
+    } catch (const std::exception& e) {
+        err << std::format("can't write back {}: {}\n", filePath_.native(),
+                           e.what());
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+std::size_t Storage::getBlockSize() const {
+    return blockSize_;
 }
 
 void Storage::readBlock(Block& block, std::size_t blockNum) {
-    _read(&block, Block::size * blockNum, Block::size);
+    std::scoped_lock latch(latch_);
+    copyBlock(block, *_fetch(blockNum, true).block);
+}
+
+void Storage::readBlocks(std::size_t firstBlockNum, std::span<Block> blocks) {
+    std::scoped_lock latch(latch_);
+    URSQL_ASSERT(firstBlockNum + blocks.size() <= blockCount_,
+                 std::format("reading blocks {} to {} past the end",
+                             firstBlockNum, firstBlockNum + blocks.size()));
+    std::vector<char> bytes(blockSize_ * blocks.size());
+    _read(bytes.data(), blockSize_ * firstBlockNum, bytes.size());
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        if (BlockCache::Frame* frame = blockCache_.find(firstBlockNum + i)) {
+            copyBlock(blocks[i], *frame->block);
+        } else {
+            URSQL_ASSERT(blocks[i].getSize() == blockSize_,
+                         "reading into a block of another size");
+            std::memcpy(blocks[i].getBytes(), bytes.data() + blockSize_ * i,
+                        blockSize_);
+        }
+    }
 }
 
 void Storage::writeBlock(const Block& block, std::size_t blockNum) {
-    _write(&block, Block::size * blockNum, Block::size);
+    std::scoped_lock latch(latch_);
+    BlockCache::Frame& frame = _fetch(blockNum, false);
+    copyBlock(*frame.block, block);
+    frame.dirty = true;
+    _setBlockType(blockNum, block.getType());
+}
+
+void Storage::writeBlocks(std::size_t firstBlockNum,
+                          std::span<const Block> blocks) {
+    std::vector<char> bytes(blockSize_ * blocks.size());
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        URSQL_ASSERT(blocks[i].getSize() == blockSize_,
+                     "writing a block of another size");
+        std::memcpy(bytes.data() + blockSize_ * i, blocks[i].getBytes(),
+                    blockSize_);
+    }
+    std::scoped_lock latch(latch_);
+    _write(bytes.data(), blockSize_ * firstBlockNum, bytes.size());
+    // Only once the blocks are on disk are the cached copies clean.
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        if (BlockCache::Frame* frame = blockCache_.find(firstBlockNum + i)) {
+            copyBlock(*frame->block, blocks[i]);
+            frame->dirty = false;
+        }
+        _setBlockType(firstBlockNum + i, blocks[i].getType());
+    }
+}
+
+bool Storage::updateBlock(std::size_t blockNum, const BlockVisitor& visitor) {
+    std::scoped_lock latch(latch_);
+    BlockCache::Frame& frame = _fetch(blockNum, true);
+    bool modified = visitor(*frame.block, blockNum);
+    frame.dirty = frame.dirty || modified;
+    _setBlockType(blockNum, frame.block->getType());
+    return modified;
+}
+
+void Storage::flush() {
+    std::scoped_lock latch(latch_);
+    _flush();
+}
+
+std::size_t Storage::writeBackCold(std::size_t maxBlocks) {
+    std::scoped_lock latch(latch_);
+    std::vector<BlockCache::Frame*> dirtyFrames =
+      blockCache_.getColdDirtyFrames(maxBlocks);
+    if (dirtyFrames.empty()) {
+        return 0;
+    }
+    std::ranges::sort(dirtyFrames, {}, &BlockCache::Frame::blockNum);
+    for (BlockCache::Frame* frame : dirtyFrames) {
+        _writeBack(*frame);
+    }
+    file_.clear();
+    URSQL_EXPECT(file_.flush(), FileAccessError, "flush error");
+    return dirtyFrames.size();
+}
+
+std::size_t Storage::appendFreeBlocks(std::size_t count) {
+    std::scoped_lock latch(latch_);
+    std::size_t first = blockCount_;
+    // The file system lays the space out as one extent instead of growing
+    // the file block by block. Where it can't, the write below still
+    // extends the file in one go.
+    if (::fallocate(fd_, 0, blockSize_ * first, blockSize_ * count) != 0) {
+        URSQL_EXPECT(errno == EOPNOTSUPP || errno == ENOSYS, FileAccessError,
+                     std::format("unable to allocate {} blocks: {}", count,
+                                 std::strerror(errno)));
+    }
+    std::vector<char> bytes(blockSize_ * count);
+    for (std::size_t i = 0; i < count; ++i) {
+        bytes[blockSize_ * i] = static_cast<char>(BlockType::free);
+    }
+    _write(bytes.data(), blockSize_ * first, bytes.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        _setBlockType(first + i, BlockType::free);
+    }
+    return first;
 }
 
 std::size_t Storage::getBlockCount() {
-    file_.seekg(0, std::ios_base::end);
-    std::size_t total = static_cast<std::size_t>(file_.tellg());
-    return static_cast<std::size_t>(total / Block::size);
+    std::scoped_lock latch(latch_);
+    return blockCount_;
 }
 
 BlockType Storage::getBlockType(std::size_t blockNum) {
-    BlockType blockType;
-    _read(&blockType, Block::size * blockNum, sizeof(BlockType));
-    return blockType;
+    std::scoped_lock latch(latch_);
+    URSQL_ASSERT(blockNum < blockCount_,
+                 std::format("block {} is past the end", blockNum));
+    return blockTypes_[blockNum];
+}
+
+std::vector<BlockType> Storage::getBlockTypes() {
+    std::scoped_lock latch(latch_);
+    return blockTypes_;
 }
 
 void Storage::releaseBlock(std::size_t blockNum) {
-    constexpr const BlockType freeType = BlockType::free;
-    _write(&freeType, Block::size * blockNum, sizeof(BlockType));
+    std::scoped_lock latch(latch_);
+    _releaseBlock(blockNum);
+}
+
+void Storage::releaseBlocks(std::vector<std::size_t> blockNums) {
+    // Visiting the blocks in file order keeps the writes sequential.
+    std::ranges::sort(blockNums);
+    std::scoped_lock latch(latch_);
+    for (std::size_t blockNum : blockNums) {
+        _releaseBlock(blockNum);
+    }
 }
 
 void Storage::save(const MonoStorable& monoStorable) {
     if (monoStorable.isDirty()) {
-        Block block;
+        Block block(BlockType::free, blockSize_);
         monoStorable.encode(block);
         writeBlock(block, monoStorable.getBlockNum());
         monoStorable.makeDirty(false);
@@ -111,19 +323,142 @@ void Storage::save(const MonoStorable& monoStorable) {
 }
 
 void Storage::load(MonoStorable& monoStorable) {
-    Block block;
+    Block block(BlockType::free, blockSize_);
     readBlock(block, monoStorable.getBlockNum());
     monoStorable.decode(block);
     monoStorable.makeDirty(false);
 }
 
+std::size_t Storage::truncateFreeTail(std::size_t minBlockCount) {
+    std::scoped_lock latch(latch_);
+    std::size_t blockCount = blockCount_;
+    while (blockCount > minBlockCount &&
+           blockTypes_[blockCount - 1] == BlockType::free)
+    {
+        --blockCount;
+    }
+    if (blockCount == blockCount_) {
+        return 0;
+    }
+    blockCache_.discardFrom(blockCount);
+    file_.clear();
+    URSQL_EXPECT(file_.flush(), FileAccessError, "flush error");
+    std::error_code ec;
+    fs::resize_file(filePath_, blockSize_ * blockCount, ec);
+    URSQL_EXPECT(!ec, FileAccessError,
+                 std::format("unable to truncate file {}: {}",
+                             filePath_.native(), ec.message()));
+    std::size_t truncated = blockCount_ - blockCount;
+    blockCount_ = blockCount;
+    blockTypes_.resize(blockCount);
+    return truncated;
+}
+
+std::size_t Storage::_readBlockSize() {
+    URSQL_EXPECT(file_, FileAccessError,
+                 std::format("unable to open file {}", filePath_.native()));
+    char header[sizeof(BlockType) + sizeof(std::size_t)];
+    _read(header, 0, sizeof(header));
+    auto blockSize =
+      BufferReader(header + sizeof(BlockType), sizeof(std::size_t))
+        .read<std::size_t>();
+    URSQL_EXPECT(static_cast<BlockType>(header[0]) == BlockType::toc,
+                 FileAccessError,
+                 std::format("{} isn't a database file", filePath_.native()));
+    // Files made before the block size could be chosen have blocks of the
+    // least size, and their TOC starts with the table count instead.
+    return Block::isValidSize(blockSize) ? blockSize : Block::minSize;
+}
+
+void Storage::_loadBlockTypes() {
+    // Whole runs of blocks at a time, of which only the types are kept.
+    constexpr const std::size_t runLength = 64;
+    std::vector<char> run(blockSize_ * runLength);
+    blockTypes_.resize(blockCount_);
+    for (std::size_t first = 0; first < blockCount_; first += runLength) {
+        std::size_t count = std::min(runLength, blockCount_ - first);
+        _read(run.data(), blockSize_ * first, blockSize_ * count);
+        for (std::size_t i = 0; i < count; ++i) {
+            blockTypes_[first + i] =
+              static_cast<BlockType>(run[blockSize_ * i]);
+        }
+    }
+}
+
+void Storage::_setBlockType(std::size_t blockNum, BlockType blockType) {
+    if (blockNum >= blockCount_) {
+        blockCount_ = blockNum + 1;
+        blockTypes_.resize(blockCount_, BlockType::free);
+    }
+    blockTypes_[blockNum] = blockType;
+}
+
+void Storage::_releaseBlock(std::size_t blockNum) {
+    _setBlockType(blockNum, BlockType::free);
+    if (BlockCache::Frame* frame = blockCache_.find(blockNum)) {
+        frame->block->setType(BlockType::free);
+        frame->dirty = true;
+        return;
+    }
+    constexpr const BlockType freeType = BlockType::free;
+    _write(&freeType, blockSize_ * blockNum, sizeof(BlockType));
+}
+
+void Storage::_flush() {
+    std::vector<BlockCache::Frame*> dirtyFrames = blockCache_.getDirtyFrames();
+    // One pass in block order instead of a write per modification.
+    std::ranges::sort(dirtyFrames, {}, &BlockCache::Frame::blockNum);
+    for (BlockCache::Frame* frame : dirtyFrames) {
+        _writeBack(*frame);
+    }
+    file_.clear();
+    URSQL_EXPECT(file_.flush(), FileAccessError, "flush error");
+}
+
+BlockCache::Frame& Storage::_fetch(std::size_t blockNum, bool loadFromFile) {
+    if (BlockCache::Frame* frame = blockCache_.find(blockNum)) {
+        return *frame;
+    }
+    URSQL_ASSERT(!loadFromFile || blockNum < blockCount_,
+                 std::format("reading block {} past the end", blockNum));
+    if (blockCache_.full()) {
+        // Written back while it's still cached, so that a block which
+        // can't be written stays in the cache, dirty, instead of being lost.
+        _writeBack(blockCache_.getVictim());
+        blockCache_.evict();
+    }
+    BlockCache::Frame& frame = blockCache_.insert(blockNum);
+    if (loadFromFile) {
+        try {
+            _read(frame.block->getBytes(), blockSize_ * blockNum, blockSize_);
+        } catch (...) {
+            // What was read, if anything, isn't the block.
+            blockCache_.erase(blockNum);
+            throw;
+        }
+    }
+    return frame;
+}
+
+void Storage::_writeBack(BlockCache::Frame& frame) {
+    if (frame.dirty) {
+        _write(frame.block->getBytes(), blockSize_ * frame.blockNum,
+               blockSize_);
+        frame.dirty = false;
+    }
+}
+
+// Each call starts from a clear stream state, so that one failed read or
+// write doesn't fail every later one.
 void Storage::_read(void* dst, std::size_t offset, std::size_t len) {
+    file_.clear();
     URSQL_EXPECT(file_.seekg(offset), FileAccessError, "seekg error");
     URSQL_EXPECT(file_.read(static_cast<char*>(dst), len), FileAccessError,
                  "read error");
 }
 
 void Storage::_write(const void* src, std::size_t offset, std::size_t len) {
+    file_.clear();
     URSQL_EXPECT(file_.seekp(offset), FileAccessError, "seekp error");
     URSQL_EXPECT(file_.write(static_cast<const char*>(src), len),
                  FileAccessError, "write error");
@@ -20,12 +20,12 @@ ExecuteResult CreateTableStatement::run(DBManager& dbManager) const {
     Database* activeDB = dbManager.getActiveDB();
     URSQL_EXPECT(activeDB, NoActiveDB, );
     _validateAttributes();
+    dbManager.commitTransaction();
     activeDB->createTable(tableName_, attributes_);
     return { std::make_unique<RowsAffectedTextView>(0), false };
 }
 
-std::unique_ptr<CreateTableStatement> CreateTableStatement::parse(
-  TokenStream& ts) {
+ResourcePtr<CreateTableStatement> CreateTableStatement::parse(TokenStream& ts) {
     std::string tableName = parser::parseNextIdentifier(ts);
     URSQL_EXPECT(ts.skipIf(Punctuation::lparen), MissingInput,
                  "'(' after table name");
@@ -35,8 +35,8 @@ std::unique_ptr<CreateTableStatement> CreateTableStatement::parse(
     } while (ts.skipIf(Punctuation::comma));
     URSQL_EXPECT(ts.skipIf(Punctuation::rparen), MissingInput,
                  "')' after attribute list");
-    return std::make_unique<CreateTableStatement>(std::move(tableName),
-                                                  std::move(attributes));
+    return allocateUnique<CreateTableStatement>(
+      ts.getResource(), std::move(tableName), std::move(attributes));
 }
 
 void CreateTableStatement::_validateAttributes() const {
@@ -52,7 +52,9 @@ void CreateTableStatement::_validateAttributes() const {
             autoIncDefined = true;
             URSQL_EXPECT(attribute.isPrimary(), InvalidCommand,
                          "auto_increment column should be a key");
-            URSQL_EXPECT(attribute.getType() == ValueType::int_type, MisMatch,
+            URSQL_EXPECT(attribute.getType() == ValueType::int_type ||
+                           attribute.getType() == ValueType::bigint_type,
+                         MisMatch,
                          "auto_increment column should be integer type");
         }
         if (attribute.isPrimary()) {
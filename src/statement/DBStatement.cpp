@@ -1,12 +1,16 @@
 #include "statement/DBStatement.hpp"
 
+#include <algorithm>
+#include <array>
 #include <format>
 
 #include "controller/DBManager.hpp"
 #include "exception/InternalError.hpp"
+#include "exception/UserError.hpp"
 #include "parser/Parser.hpp"
 #include "parser/TokenStream.hpp"
 #include "view/RowsAffectedTextView.hpp"
+#include "view/TextView.hpp"
 #include "view/TabularView.hpp"
 
 namespace ursql {
@@ -19,19 +23,33 @@ MultiDBStatement::MultiDBStatement(std::vector<std::string> dbNames)
     : Statement(),
       dbNames_(std::move(dbNames)) {}
 
-CreateDBStatement::CreateDBStatement(std::vector<std::string> dbNames)
-    : MultiDBStatement(std::move(dbNames)) {}
+CreateDBStatement::CreateDBStatement(std::vector<std::string> dbNames,
+                                     std::size_t blockSize)
+    : MultiDBStatement(std::move(dbNames)),
+      blockSize_(blockSize) {}
 
 ExecuteResult CreateDBStatement::run(DBManager& dbManager) const {
-    dbManager.createDatabases(dbNames_);
+    dbManager.createDatabases(dbNames_, blockSize_);
     return { std::make_unique<RowsAffectedTextView>(dbNames_.size()), false };
 }
 
-std::unique_ptr<CreateDBStatement> CreateDBStatement::parse(TokenStream& ts) {
+ResourcePtr<CreateDBStatement> CreateDBStatement::parse(TokenStream& ts) {
     std::vector<std::string> dbNames =
       parser::parseCommaSeparated(ts, parser::parseNextIdentifier);
+    std::size_t blockSize = Block::defaultSize;
+    if (ts.skipIf(Keyword::block_size_kw)) {
+        URSQL_EXPECT(ts.hasNext() && ts.peek().getType() == TokenType::integer,
+                     MissingInput, "block size");
+        std::uint64_t size = ts.next().get<TokenType::integer>();
+        URSQL_EXPECT(Block::isValidSize(size), InvalidCommand,
+                     std::format("block size should be a power of two from "
+                                 "{} to {}",
+                                 Block::minSize, Block::maxSize));
+        blockSize = size;
+    }
     URSQL_EXPECT(!ts.hasNext(), RedundantInput, ts);
-    return std::make_unique<CreateDBStatement>(std::move(dbNames));
+    return allocateUnique<CreateDBStatement>(ts.getResource(),
+                                             std::move(dbNames), blockSize);
 }
 
 DropDBStatement::DropDBStatement(std::vector<std::string> dbNames)
@@ -42,11 +60,12 @@ ExecuteResult DropDBStatement::run(DBManager& dbManager) const {
     return { std::make_unique<RowsAffectedTextView>(dbNames_.size()), false };
 }
 
-std::unique_ptr<DropDBStatement> DropDBStatement::parse(TokenStream& ts) {
+ResourcePtr<DropDBStatement> DropDBStatement::parse(TokenStream& ts) {
     std::vector<std::string> dbNames =
       parser::parseCommaSeparated(ts, parser::parseNextIdentifier);
     URSQL_EXPECT(!ts.hasNext(), RedundantInput, ts);
-    return std::make_unique<DropDBStatement>(std::move(dbNames));
+    return allocateUnique<DropDBStatement>(ts.getResource(),
+                                           std::move(dbNames));
 }
 
 UseDBStatement::UseDBStatement(std::string dbName)
@@ -57,9 +76,28 @@ ExecuteResult UseDBStatement::run(DBManager& dbManager) const {
     return { std::make_unique<TextView>("Database changed"), false };
 }
 
-std::unique_ptr<UseDBStatement> UseDBStatement::parse(TokenStream& ts) {
-    return std::make_unique<UseDBStatement>(
-      parser::parseNextIdentifierAsLast(ts));
+ResourcePtr<UseDBStatement> UseDBStatement::parse(TokenStream& ts) {
+    return allocateUnique<UseDBStatement>(
+      ts.getResource(), parser::parseNextIdentifierAsLast(ts));
+}
+
+namespace {
+
+std::string blockType2String(BlockType blockType) {
+    switch (blockType) {
+    case BlockType::toc:
+        return "TOC";
+    case BlockType::entity:
+        return "Entity";
+    case BlockType::index:
+        return "Index";
+    case BlockType::row:
+        return "Row";
+    case BlockType::free:
+        return "Free";
+    default:
+        URSQL_UNREACHABLE(std::format("unknown block type {}", blockType));
+    }
 }
 
 class DescDBView : public TabularView {
@@ -77,32 +115,101 @@ private:
         for (std::size_t i = 0; i < blockTypes.size(); ++i) {
             std::vector<Value> valueRow;
             valueRow.emplace_back(static_cast<Value::int_t>(i));
-            valueRow.emplace_back(_blockType2String(blockTypes[i]));
+            valueRow.emplace_back(blockType2String(blockTypes[i]));
             valueRows.push_back(std::move(valueRow));
         }
         return valueRows;
     }
+};
 
-    static std::string _blockType2String(BlockType blockType) {
-        switch (blockType) {
-        case BlockType::toc:
-            return "TOC";
-        case BlockType::entity:
-            return "Entity";
-        case BlockType::index:
-            return "Index";
-        case BlockType::row:
-            return "Row";
-        case BlockType::free:
-            return "Free";
-        default:
-            URSQL_UNREACHABLE(std::format("unknown block type {}", blockType));
+// One row per block type: its blocks, the runs of adjacent blocks they form
+// and how long those runs are. Fragmentation is 0% when the blocks form one
+// run and 100% when no two of them are adjacent.
+class DescDBSummaryView : public TabularView {
+public:
+    explicit DescDBSummaryView(const std::vector<BlockType>& blockTypes)
+        : TabularView({ "Type", "Blocks", "Runs", "Longest run",
+                        "Fragmentation", "Runs of 1", "2-7", "8-63",
+                        "64-511", "512+" },
+                      _summarize(blockTypes)) {}
+
+    ~DescDBSummaryView() override = default;
+
+private:
+    struct TypeSummary {
+        std::size_t blockCount = 0;
+        std::size_t runCount = 0;
+        std::size_t longestRun = 0;
+        // Runs of 1, 2-7, 8-63, 64-511 and 512 or more blocks.
+        std::array<std::size_t, 5> runLengths{};
+    };
+
+    // Where the run length buckets start, after the first one.
+    static constexpr const std::array<std::size_t, 4> runLengthBounds{
+        2, 8, 64, 512
+    };
+
+    static std::vector<std::vector<Value>> _summarize(
+      const std::vector<BlockType>& blockTypes) {
+        constexpr const std::array<BlockType, 5> types{
+            BlockType::toc, BlockType::entity, BlockType::index,
+            BlockType::row, BlockType::free
+        };
+        std::array<TypeSummary, types.size()> summaries;
+        for (std::size_t first = 0; first < blockTypes.size();) {
+            std::size_t end = first + 1;
+            while (end < blockTypes.size() &&
+                   blockTypes[end] == blockTypes[first])
+            {
+                ++end;
+            }
+            auto it = std::ranges::find(types, blockTypes[first]);
+            URSQL_ASSERT(it != std::end(types),
+                         std::format("unknown block type {}",
+                                     blockTypes[first]));
+            TypeSummary& summary = summaries[it - std::begin(types)];
+            std::size_t runLength = end - first;
+            summary.blockCount += runLength;
+            ++summary.runCount;
+            summary.longestRun = std::max(summary.longestRun, runLength);
+            ++summary.runLengths[std::ranges::upper_bound(runLengthBounds,
+                                                          runLength) -
+                                 std::begin(runLengthBounds)];
+            first = end;
         }
+
+        std::vector<std::vector<Value>> valueRows;
+        for (std::size_t i = 0; i < types.size(); ++i) {
+            const TypeSummary& summary = summaries[i];
+            if (summary.blockCount == 0) {
+                continue;
+            }
+            std::size_t fragmentation =
+              summary.blockCount > 1 ? 100 * (summary.runCount - 1) /
+                                         (summary.blockCount - 1) :
+                                       0;
+            std::vector<Value> valueRow;
+            valueRow.emplace_back(blockType2String(types[i]));
+            valueRow.emplace_back(
+              static_cast<Value::int_t>(summary.blockCount));
+            valueRow.emplace_back(static_cast<Value::int_t>(summary.runCount));
+            valueRow.emplace_back(
+              static_cast<Value::int_t>(summary.longestRun));
+            valueRow.emplace_back(std::format("{}%", fragmentation));
+            for (std::size_t runs : summary.runLengths) {
+                valueRow.emplace_back(static_cast<Value::int_t>(runs));
+            }
+            valueRows.push_back(std::move(valueRow));
+        }
+        return valueRows;
     }
 };
 
-DescDBStatement::DescDBStatement(std::string dbName)
-    : SingleDBStatement(std::move(dbName)) {}
+}  // namespace
+
+DescDBStatement::DescDBStatement(std::string dbName, bool summary)
+    : SingleDBStatement(std::move(dbName)),
+      summary_(summary) {}
 
 ExecuteResult DescDBStatement::run(DBManager& dbManager) const {
     std::vector<BlockType> blockTypes;
@@ -111,16 +218,22 @@ ExecuteResult DescDBStatement::run(DBManager& dbManager) const {
     {
         blockTypes = activeDB->getBlockTypes();
     } else {
-        std::unique_ptr<Database> database =
+        std::shared_ptr<Database> database =
           dbManager.getExistingDBByName(dbName_);
         blockTypes = database->getBlockTypes();
     }
+    if (summary_) {
+        return { std::make_unique<DescDBSummaryView>(blockTypes), false };
+    }
     return { std::make_unique<DescDBView>(blockTypes), false };
 }
 
-std::unique_ptr<DescDBStatement> DescDBStatement::parse(TokenStream& ts) {
-    return std::make_unique<DescDBStatement>(
-      parser::parseNextIdentifierAsLast(ts));
+ResourcePtr<DescDBStatement> DescDBStatement::parse(TokenStream& ts) {
+    std::string dbName = parser::parseNextIdentifier(ts);
+    bool summary = ts.skipIf(Keyword::summary_kw);
+    URSQL_EXPECT(!ts.hasNext(), RedundantInput, ts);
+    return allocateUnique<DescDBStatement>(ts.getResource(), std::move(dbName),
+                                           summary);
 }
 
 }  // namespace ursql
@@ -0,0 +1,39 @@
+#include "statement/DeleteFromTableStatement.hpp"
+
+#include "controller/DBManager.hpp"
+#include "exception/UserError.hpp"
+#include "model/Database.hpp"
+#include "parser/Parser.hpp"
+#include "parser/TokenStream.hpp"
+#include "view/RowsAffectedTextView.hpp"
+
+namespace ursql {
+
+DeleteFromTableStatement::DeleteFromTableStatement(
+  std::string tableName, ResourcePtr<Filter> filter)
+    : SingleTableStatement(std::move(tableName)),
+      filter_(std::move(filter)) {}
+
+ExecuteResult DeleteFromTableStatement::run(DBManager& dbManager) const {
+    Database* activeDB = dbManager.getActiveDB();
+    URSQL_EXPECT(activeDB, NoActiveDB, );
+    std::size_t rowCount =
+      activeDB->deleteFromTable(tableName_, filter_.get(),
+                                dbManager.getTransaction());
+    return { std::make_unique<RowsAffectedTextView>(rowCount), false };
+}
+
+ResourcePtr<DeleteFromTableStatement> DeleteFromTableStatement::parse(
+  TokenStream& ts) {
+    URSQL_EXPECT(ts.skipIf(Keyword::from_kw), MissingInput, "'from'");
+    std::string tableName = parser::parseNextIdentifier(ts);
+    ResourcePtr<Filter> filter;
+    if (ts.skipIf(Keyword::where_kw)) {
+        filter = Filter::parse(ts);
+    }
+    URSQL_EXPECT(!ts.hasNext(), RedundantInput, ts);
+    return allocateUnique<DeleteFromTableStatement>(
+      ts.getResource(), std::move(tableName), std::move(filter));
+}
+
+}  // namespace ursql
@@ -12,16 +12,18 @@ DropTableStatement::DropTableStatement(std::vector<std::string> tableNames)
 ExecuteResult DropTableStatement::run(DBManager& dbManager) const {
     Database* activeDB = dbManager.getActiveDB();
     URSQL_EXPECT(activeDB, NoActiveDB, );
+    dbManager.commitTransaction();
     activeDB->dropTables(tableNames_);
     return { std::make_unique<RowsAffectedTextView>(tableNames_.size()),
              false };
 }
 
-std::unique_ptr<DropTableStatement> DropTableStatement::parse(TokenStream& ts) {
+ResourcePtr<DropTableStatement> DropTableStatement::parse(TokenStream& ts) {
     std::vector<std::string> tableNames =
       parser::parseCommaSeparated(ts, parser::parseNextIdentifier);
     URSQL_EXPECT(!ts.hasNext(), RedundantInput, ts);
-    return std::make_unique<DropTableStatement>(std::move(tableNames));
+    return allocateUnique<DropTableStatement>(ts.getResource(),
+                                              std::move(tableNames));
 }
 
 }  // namespace ursql
@@ -19,4 +19,8 @@ bool ExecuteResult::quit() const {
     return quit_;
 }
 
+std::unique_ptr<View> ExecuteResult::releaseView() {
+    return std::move(view_);
+}
+
 }  // namespace ursql
@@ -1,47 +1,300 @@
 #include "statement/Filter.hpp"
 
-#include "model/Row.hpp"
-#include "parser/TokenStream.hpp"
+#include <algorithm>
+#include <format>
+
+#include "exception/InternalError.hpp"
 #include "exception/UserError.hpp"
+#include "model/Entity.hpp"
+#include "parser/TokenStream.hpp"
 
 namespace ursql {
 
+namespace {
+
+bool isNumeric(ValueType type) {
+    return type == ValueType::int_type || type == ValueType::float_type ||
+           type == ValueType::bigint_type;
+}
+
+bool comparable(ValueType lhs, ValueType rhs) {
+    return lhs == ValueType::null_type || rhs == ValueType::null_type ||
+           lhs == rhs || (isNumeric(lhs) && isNumeric(rhs));
+}
+
+using Truth = Filter::Truth;
+
+Truth truthOf(bool b) {
+    return b ? Truth::true_value : Truth::false_value;
+}
+
+// Not unknown is still unknown.
+Truth negate(Truth truth) {
+    switch (truth) {
+    case Truth::false_value:
+        return Truth::true_value;
+    case Truth::true_value:
+        return Truth::false_value;
+    default:
+        return Truth::unknown;
+    }
+}
+
+bool compare(const Value& lhs, Comparator comparator, const Value& rhs) {
+    switch (comparator) {
+    case Comparator::eq:
+        return lhs == rhs;
+    case Comparator::ne:
+        return !(lhs == rhs);
+    case Comparator::lt:
+        return lhs < rhs;
+    case Comparator::le:
+        return lhs <= rhs;
+    case Comparator::gt:
+        return lhs > rhs;
+    case Comparator::ge:
+        return lhs >= rhs;
+    default:
+        URSQL_UNREACHABLE(std::format("unknown comparator {}", comparator));
+    }
+}
+
+// Either a column reference or a literal value.
 class Operand {
 public:
+    // An operand resolved against an entity: a column index or a literal.
+    struct Bound {
+        std::optional<std::size_t> index;
+        Value literal;
+        ValueType type;
+
+        [[nodiscard]] const Value& get(const ValueRow& row) const {
+            return index.has_value() ? row[index.value()] : literal;
+        }
+    };
+
+    explicit Operand(std::string attrName) : var_(std::move(attrName)) {}
+
+    explicit Operand(Value value) : var_(std::move(value)) {}
+
+    [[nodiscard]] Bound bind(const Entity& entity) const {
+        if (auto pAttrName = std::get_if<std::string>(&var_)) {
+            std::size_t index = entity.attributeIndex(*pAttrName);
+            return { index, Value(), entity.getAttribute(index).getType() };
+        }
+        auto& literal = std::get<Value>(var_);
+        return { std::nullopt, literal, literal.getType() };
+    }
 
     static Operand parse(TokenStream& ts) {
         URSQL_EXPECT(ts.hasNext(), MissingInput, "operand");
         auto& token = ts.peek();
-        switch (token.getType()) {
-        case TokenType::identifier:
-            return
+        if (token.getType() == TokenType::identifier) {
+            return Operand(std::string(ts.next().get<TokenType::identifier>()));
         }
+        return Operand(Value::parse(ts));
     }
+
 private:
     std::variant<std::string, Value> var_;
+};
+
+class ComparisonFilter : public Filter {
+public:
+    ComparisonFilter(Operand lhs, Comparator comparator, Operand rhs)
+        : Filter(),
+          lhs_(std::move(lhs)),
+          comparator_(comparator),
+          rhs_(std::move(rhs)) {}
+
+    ~ComparisonFilter() override = default;
 
-    struct IdentifierTag {};
-    struct ValueTag {};
-    Operand(std::string identifier)
+    [[nodiscard]] RowTruth bindTruth(const Entity& entity) const override {
+        Operand::Bound lhs = lhs_.bind(entity);
+        Operand::Bound rhs = rhs_.bind(entity);
+        URSQL_EXPECT(comparable(lhs.type, rhs.type), MisMatch,
+                     "operand types in comparison");
+        return [lhs = std::move(lhs), comparator = comparator_,
+                rhs = std::move(rhs)](const ValueRow& row) {
+            const Value& lhsVal = lhs.get(row);
+            const Value& rhsVal = rhs.get(row);
+            // Like SQL, any comparison against NULL is unknown.
+            if (lhsVal.isNull() || rhsVal.isNull()) {
+                return Truth::unknown;
+            }
+            return truthOf(compare(lhsVal, comparator, rhsVal));
+        };
+    }
+
+private:
+    const Operand lhs_;
+    const Comparator comparator_;
+    const Operand rhs_;
 };
 
-class Expr {
+class IsNullFilter : public Filter {
 public:
+    IsNullFilter(Operand operand, bool negated)
+        : Filter(),
+          operand_(std::move(operand)),
+          negated_(negated) {}
+
+    ~IsNullFilter() override = default;
+
+    [[nodiscard]] RowTruth bindTruth(const Entity& entity) const override {
+        return [operand = operand_.bind(entity),
+                negated = negated_](const ValueRow& row) {
+            return truthOf(operand.get(row).isNull() != negated);
+        };
+    }
 
 private:
+    const Operand operand_;
+    const bool negated_;
+};
 
+class NotFilter : public Filter {
+public:
+    explicit NotFilter(ResourcePtr<Filter> filter)
+        : Filter(),
+          filter_(std::move(filter)) {}
+
+    ~NotFilter() override = default;
+
+    [[nodiscard]] RowTruth bindTruth(const Entity& entity) const override {
+        return [truth = filter_->bindTruth(entity)](const ValueRow& row) {
+            return negate(truth(row));
+        };
+    }
+
+private:
+    const ResourcePtr<Filter> filter_;
 };
 
 class AndFilter : public Filter {
 public:
-    explicit AndFilter(std::vector<std::unique_ptr<Filter>> filters) : Filter(), filters_(std::move(filters)) {}
+    explicit AndFilter(std::pmr::vector<ResourcePtr<Filter>> filters)
+        : Filter(),
+          filters_(std::move(filters)) {}
+
     ~AndFilter() override = default;
 
-    [[nodiscard]] bool eval(const Entity& entity, const Row& row) const override {
-        return std::ranges::all_of(filters_, [&](auto& filter) { return filter->eval(entity, row); });
+    [[nodiscard]] RowTruth bindTruth(const Entity& entity) const override {
+        std::vector<RowTruth> truths;
+        for (auto& filter : filters_) {
+            truths.push_back(filter->bindTruth(entity));
+        }
+        // False if any is false, else unknown if any is unknown.
+        return [truths = std::move(truths)](const ValueRow& row) {
+            Truth result = Truth::true_value;
+            for (auto& truth : truths) {
+                result = std::min(result, truth(row));
+                if (result == Truth::false_value) {
+                    break;
+                }
+            }
+            return result;
+        };
+    }
+
+private:
+    const std::pmr::vector<ResourcePtr<Filter>> filters_;
+};
+
+class OrFilter : public Filter {
+public:
+    explicit OrFilter(std::pmr::vector<ResourcePtr<Filter>> filters)
+        : Filter(),
+          filters_(std::move(filters)) {}
+
+    ~OrFilter() override = default;
+
+    [[nodiscard]] RowTruth bindTruth(const Entity& entity) const override {
+        std::vector<RowTruth> truths;
+        for (auto& filter : filters_) {
+            truths.push_back(filter->bindTruth(entity));
+        }
+        // True if any is true, else unknown if any is unknown.
+        return [truths = std::move(truths)](const ValueRow& row) {
+            Truth result = Truth::false_value;
+            for (auto& truth : truths) {
+                result = std::max(result, truth(row));
+                if (result == Truth::true_value) {
+                    break;
+                }
+            }
+            return result;
+        };
     }
+
 private:
-    const std::vector<std::unique_ptr<Filter>> filters_;
+    const std::pmr::vector<ResourcePtr<Filter>> filters_;
 };
 
+ResourcePtr<Filter> parseOr(TokenStream& ts);
+
+ResourcePtr<Filter> parsePrimary(TokenStream& ts) {
+    if (ts.skipIf(Punctuation::lparen)) {
+        ResourcePtr<Filter> filter = parseOr(ts);
+        URSQL_EXPECT(ts.skipIf(Punctuation::rparen), MissingInput,
+                     "')' after condition");
+        return filter;
+    }
+    Operand lhs = Operand::parse(ts);
+    if (ts.skipIf(Keyword::is_kw)) {
+        bool negated = ts.skipIf(Keyword::not_kw);
+        URSQL_EXPECT(ts.skipIf(Keyword::null_kw), MissingInput,
+                     "'null' after 'is'");
+        return allocateUnique<IsNullFilter>(ts.getResource(), std::move(lhs),
+                                            negated);
+    }
+    URSQL_EXPECT(ts.hasNext() && ts.peek().getType() == TokenType::comparator,
+                 MissingInput, "comparator");
+    Comparator comparator = ts.next().get<TokenType::comparator>();
+    Operand rhs = Operand::parse(ts);
+    return allocateUnique<ComparisonFilter>(ts.getResource(), std::move(lhs),
+                                            comparator, std::move(rhs));
+}
+
+ResourcePtr<Filter> parseNot(TokenStream& ts) {
+    if (ts.skipIf(Keyword::not_kw)) {
+        return allocateUnique<NotFilter>(ts.getResource(), parseNot(ts));
+    }
+    return parsePrimary(ts);
+}
+
+ResourcePtr<Filter> parseAnd(TokenStream& ts) {
+    std::pmr::vector<ResourcePtr<Filter>> filters(ts.getResource());
+    do {
+        filters.push_back(parseNot(ts));
+    } while (ts.skipIf(Keyword::and_kw));
+    if (filters.size() == 1) {
+        return std::move(filters.front());
+    }
+    return allocateUnique<AndFilter>(ts.getResource(), std::move(filters));
 }
+
+ResourcePtr<Filter> parseOr(TokenStream& ts) {
+    std::pmr::vector<ResourcePtr<Filter>> filters(ts.getResource());
+    do {
+        filters.push_back(parseAnd(ts));
+    } while (ts.skipIf(Keyword::or_kw));
+    if (filters.size() == 1) {
+        return std::move(filters.front());
+    }
+    return allocateUnique<OrFilter>(ts.getResource(), std::move(filters));
+}
+
+}  // namespace
+
+Filter::RowPredicate Filter::bind(const Entity& entity) const {
+    return [truth = bindTruth(entity)](const ValueRow& row) {
+        return truth(row) == Truth::true_value;
+    };
+}
+
+ResourcePtr<Filter> Filter::parse(TokenStream& ts) {
+    return parseOr(ts);
+}
+
+}  // namespace ursql
@@ -5,13 +5,103 @@
 #include "model/Database.hpp"
 #include "parser/Parser.hpp"
 #include "parser/TokenStream.hpp"
+#include "statement/PreparedStatement.hpp"
 #include "view/RowsAffectedTextView.hpp"
 
 namespace ursql {
 
+namespace {
+
+// Where a '?' placeholder sits among the value lists.
+struct ParamSlot {
+    std::size_t row;
+    std::size_t column;
+};
+
+// The value lists are allocated where the statement is.
+struct ParsedInsert {
+    explicit ParsedInsert(std::pmr::memory_resource* resource)
+        : valueLists(resource) {}
+
+    std::string tableName;
+    std::optional<std::vector<std::string>> attrNames;
+    std::pmr::vector<ValueList> valueLists;
+    std::vector<ParamSlot> paramSlots;
+};
+
+ParsedInsert parseInsert(TokenStream& ts) {
+    URSQL_EXPECT(ts.skipIf(Keyword::into_kw), MissingInput, "'into'");
+    ParsedInsert parsed(ts.getResource());
+    parsed.tableName = parser::parseNextIdentifier(ts);
+    if (ts.skipIf(Punctuation::lparen)) {
+        parsed.attrNames =
+          parser::parseCommaSeparated(ts, parser::parseNextIdentifier);
+        URSQL_EXPECT(ts.skipIf(Punctuation::rparen), MissingInput,
+                     "')' after column names");
+    }
+    URSQL_EXPECT(ts.skipIf(Keyword::values_kw), MissingInput, "'values'");
+    std::size_t row = 0;
+    do {
+        URSQL_EXPECT(ts.skipIf(Punctuation::lparen), MissingInput,
+                     "'(' before value list");
+        ValueList& valueList = parsed.valueLists.emplace_back();
+        do {
+            if (ts.skipIf(Punctuation::question)) {
+                parsed.paramSlots.push_back({ row, valueList.size() });
+                valueList.emplace_back();
+            } else {
+                valueList.push_back(Value::parse(ts));
+            }
+        } while (ts.skipIf(Punctuation::comma));
+        URSQL_EXPECT(ts.skipIf(Punctuation::rparen), MissingInput,
+                     "')' after value list");
+        ++row;
+    } while (ts.skipIf(Punctuation::comma));
+    URSQL_EXPECT(!ts.hasNext(), RedundantInput, ts);
+    return parsed;
+}
+
+// Keeps the insert plan across executions and only re-plans once the
+// schema of the active database changed, or another database became
+// active. Executing just binds the values into the cached value lists.
+class PreparedInsert : public PreparedStatement {
+public:
+    PreparedInsert(std::unique_ptr<Arena> arena, ParsedInsert parsed)
+        : PreparedStatement(std::move(arena), parsed.paramSlots.size()),
+          parsed_(std::move(parsed)),
+          plan_() {}
+
+    ~PreparedInsert() override = default;
+
+protected:
+    ExecuteResult _execute(DBManager& dbManager,
+                           const ValueList& params) override {
+        Database* activeDB = dbManager.getActiveDB();
+        URSQL_EXPECT(activeDB, NoActiveDB, );
+        if (!plan_ || plan_->schemaStamp != activeDB->getSchemaStamp()) {
+            plan_ = activeDB->planInsert(parsed_.tableName, parsed_.attrNames);
+        }
+        for (std::size_t i = 0; i < params.size(); ++i) {
+            auto [row, column] = parsed_.paramSlots[i];
+            parsed_.valueLists[row][column] = params[i];
+        }
+        activeDB->insertRows(*plan_, parsed_.valueLists,
+                             dbManager.getTransaction());
+        return { std::make_unique<RowsAffectedTextView>(
+                   parsed_.valueLists.size()),
+                 false };
+    }
+
+private:
+    ParsedInsert parsed_;
+    std::optional<Database::InsertPlan> plan_;
+};
+
+}  // namespace
+
 InsertIntoTableStatement::InsertIntoTableStatement(
   std::string tableName, std::optional<std::vector<std::string>> attrNames,
-  std::vector<std::vector<Value>> valueLists)
+  std::pmr::vector<ValueList> valueLists)
     : SingleTableStatement(std::move(tableName)),
       attrNames_(std::move(attrNames)),
       valueLists_(std::move(valueLists)) {}
@@ -19,36 +109,25 @@ InsertIntoTableStatement::InsertIntoTableStatement(
 ExecuteResult InsertIntoTableStatement::run(DBManager& dbManager) const {
     Database* activeDB = dbManager.getActiveDB();
     URSQL_EXPECT(activeDB, NoActiveDB, );
-    activeDB->insertIntoTable(tableName_, attrNames_, valueLists_);
+    activeDB->insertIntoTable(tableName_, attrNames_, valueLists_,
+                              dbManager.getTransaction());
     return { std::make_unique<RowsAffectedTextView>(valueLists_.size()),
              false };
 }
 
-std::unique_ptr<InsertIntoTableStatement> InsertIntoTableStatement::parse(
+ResourcePtr<InsertIntoTableStatement> InsertIntoTableStatement::parse(
   TokenStream& ts) {
-    URSQL_EXPECT(ts.skipIf(Keyword::into_kw), MissingInput, "'into'");
-    std::string tableName = parser::parseNextIdentifier(ts);
-    std::optional<std::vector<std::string>> attrNames;
-    if (ts.skipIf(Punctuation::lparen)) {
-        attrNames =
-          parser::parseCommaSeparated(ts, parser::parseNextIdentifier);
-        URSQL_EXPECT(ts.skipIf(Punctuation::rparen), MissingInput,
-                     "')' after column names");
-    }
-    URSQL_EXPECT(ts.skipIf(Keyword::values_kw), MissingInput, "'values'");
-    std::vector<std::vector<Value>> valueRows =
-      parser::parseCommaSeparated(ts, [](TokenStream& ts1) {
-          URSQL_EXPECT(ts1.skipIf(Punctuation::lparen), MissingInput,
-                       "'(' before value list");
-          std::vector<Value> valueRow =
-            parser::parseCommaSeparated(ts1, Value::parse);
-          URSQL_EXPECT(ts1.skipIf(Punctuation::rparen), MissingInput,
-                       "')' after value list");
-          return valueRow;
-      });
-    URSQL_EXPECT(!ts.hasNext(), RedundantInput, ts);
-    return std::make_unique<InsertIntoTableStatement>(
-      std::move(tableName), std::move(attrNames), std::move(valueRows));
+    ParsedInsert parsed = parseInsert(ts);
+    URSQL_EXPECT(parsed.paramSlots.empty(), UnexpectedInput,
+                 "'?' outside of a prepared statement");
+    return allocateUnique<InsertIntoTableStatement>(
+      ts.getResource(), std::move(parsed.tableName),
+      std::move(parsed.attrNames), std::move(parsed.valueLists));
+}
+
+std::unique_ptr<PreparedStatement> InsertIntoTableStatement::prepare(
+  TokenStream& ts, std::unique_ptr<Arena> arena) {
+    return std::make_unique<PreparedInsert>(std::move(arena), parseInsert(ts));
 }
 
 }  // namespace ursql
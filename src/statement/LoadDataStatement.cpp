@@ -0,0 +1,39 @@
+#include "statement/LoadDataStatement.hpp"
+
+#include "controller/DBManager.hpp"
+#include "exception/UserError.hpp"
+#include "model/Database.hpp"
+#include "parser/Parser.hpp"
+#include "parser/TokenStream.hpp"
+#include "view/RowsAffectedTextView.hpp"
+
+namespace ursql {
+
+LoadDataStatement::LoadDataStatement(std::string filePath,
+                                     std::string tableName)
+    : SingleTableStatement(std::move(tableName)),
+      filePath_(std::move(filePath)) {}
+
+ExecuteResult LoadDataStatement::run(DBManager& dbManager) const {
+    Database* activeDB = dbManager.getActiveDB();
+    URSQL_EXPECT(activeDB, NoActiveDB, );
+    std::size_t rowCount = activeDB->loadIntoTable(
+      tableName_, filePath_, dbManager.getTransaction());
+    return { std::make_unique<RowsAffectedTextView>(rowCount), false };
+}
+
+ResourcePtr<LoadDataStatement> LoadDataStatement::parse(TokenStream& ts) {
+    URSQL_EXPECT(ts.skipIf(Keyword::data_kw), MissingInput, "'data'");
+    URSQL_EXPECT(ts.skipIf(Keyword::infile_kw), MissingInput, "'infile'");
+    URSQL_EXPECT(ts.hasNext() && ts.peek().getType() == TokenType::text,
+                 MissingInput, "file path");
+    std::string filePath(ts.next().get<TokenType::text>());
+    URSQL_EXPECT(ts.skipIf(Keyword::into_kw), MissingInput, "'into'");
+    URSQL_EXPECT(ts.skipIf(Keyword::table_kw), MissingInput, "'table'");
+    std::string tableName = parser::parseNextIdentifier(ts);
+    URSQL_EXPECT(!ts.hasNext(), RedundantInput, ts);
+    return allocateUnique<LoadDataStatement>(
+      ts.getResource(), std::move(filePath), std::move(tableName));
+}
+
+}  // namespace ursql
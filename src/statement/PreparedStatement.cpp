@@ -0,0 +1,150 @@
+#include "statement/PreparedStatement.hpp"
+
+#include <algorithm>
+#include <format>
+
+#include "controller/DBManager.hpp"
+#include "exception/UserError.hpp"
+#include "parser/Lexer.hpp"
+#include "parser/Parser.hpp"
+#include "parser/TokenStream.hpp"
+#include "statement/InsertIntoTableStatement.hpp"
+#include "view/TextView.hpp"
+
+namespace ursql {
+
+namespace {
+
+class ReparsedStatement : public PreparedStatement {
+public:
+    ReparsedStatement(std::unique_ptr<Arena> arena, TokenList tokens,
+                      std::shared_ptr<const std::string> source,
+                      std::size_t paramCount)
+        : PreparedStatement(std::move(arena), paramCount),
+          tokens_(std::move(tokens)),
+          source_(std::move(source)) {
+        // Surfaces syntax errors when preparing rather than executing.
+        Arena scratch;
+        (void)_parse(scratch, ValueList(paramCount));
+    }
+
+    ~ReparsedStatement() override = default;
+
+protected:
+    ExecuteResult _execute(DBManager& dbManager,
+                           const ValueList& params) override {
+        Arena scratch;
+        return _parse(scratch, params)->run(dbManager);
+    }
+
+private:
+    const TokenList tokens_;
+    const std::shared_ptr<const std::string> source_;
+
+    // Each execution parses a copy of the tokens into an arena of its own.
+    [[nodiscard]] ResourcePtr<Statement> _parse(
+      Arena& scratch, const ValueList& params) const {
+        TokenStream ts(TokenList(tokens_, scratch.resource()), source_);
+        ts.bindParams(params);
+        return parser::parse(ts);
+    }
+};
+
+}  // namespace
+
+PreparedStatement::PreparedStatement(std::unique_ptr<Arena> arena,
+                                     std::size_t paramCount)
+    : arena_(std::move(arena)),
+      paramCount_(paramCount) {}
+
+std::size_t PreparedStatement::getParamCount() const {
+    return paramCount_;
+}
+
+ExecuteResult PreparedStatement::execute(DBManager& dbManager,
+                                         const ValueList& params) {
+    URSQL_EXPECT(params.size() == paramCount_, MisMatch,
+                 std::format("{} values for {} placeholders", params.size(),
+                             paramCount_));
+    return _execute(dbManager, params);
+}
+
+std::unique_ptr<PreparedStatement> PreparedStatement::prepare(
+  std::string text) {
+    auto arena = std::make_unique<Arena>();
+    auto source = std::make_shared<const std::string>(std::move(text));
+    TokenList tokens = Lexer(*source).lex(arena->resource());
+    auto paramCount = static_cast<std::size_t>(
+      std::ranges::count_if(tokens, [](const Token& token) {
+          return token.is<TokenType::punctuation>(Punctuation::question);
+      }));
+    if (!tokens.empty() &&
+        tokens.front().is<TokenType::keyword>(Keyword::insert_kw))
+    {
+        TokenStream ts(std::move(tokens), std::move(source));
+        ts.next();
+        return InsertIntoTableStatement::prepare(ts, std::move(arena));
+    }
+    return std::make_unique<ReparsedStatement>(
+      std::move(arena), std::move(tokens), std::move(source), paramCount);
+}
+
+PrepareStatement::PrepareStatement(std::string name, std::string text)
+    : Statement(),
+      name_(std::move(name)),
+      text_(std::move(text)) {}
+
+ExecuteResult PrepareStatement::run(DBManager& dbManager) const {
+    dbManager.addPreparedStatement(name_, PreparedStatement::prepare(text_));
+    return { std::make_unique<TextView>("Statement prepared"), false };
+}
+
+ResourcePtr<PrepareStatement> PrepareStatement::parse(TokenStream& ts) {
+    std::string name = parser::parseNextIdentifier(ts);
+    URSQL_EXPECT(ts.skipIf(Keyword::from_kw), MissingInput, "'from'");
+    URSQL_EXPECT(ts.hasNext() && ts.peek().getType() == TokenType::text,
+                 MissingInput, "statement text");
+    std::string text(ts.next().get<TokenType::text>());
+    URSQL_EXPECT(!ts.hasNext(), RedundantInput, ts);
+    return allocateUnique<PrepareStatement>(ts.getResource(), std::move(name),
+                                            std::move(text));
+}
+
+ExecuteStatement::ExecuteStatement(std::string name, ValueList params)
+    : Statement(),
+      name_(std::move(name)),
+      params_(std::move(params)) {}
+
+ExecuteResult ExecuteStatement::run(DBManager& dbManager) const {
+    return dbManager.getPreparedStatement(name_).execute(dbManager, params_);
+}
+
+ResourcePtr<ExecuteStatement> ExecuteStatement::parse(TokenStream& ts) {
+    std::string name = parser::parseNextIdentifier(ts);
+    ValueList params(ts.getResource());
+    if (ts.skipIf(Keyword::using_kw)) {
+        do {
+            params.push_back(Value::parse(ts));
+        } while (ts.skipIf(Punctuation::comma));
+    }
+    URSQL_EXPECT(!ts.hasNext(), RedundantInput, ts);
+    return allocateUnique<ExecuteStatement>(ts.getResource(), std::move(name),
+                                            std::move(params));
+}
+
+DeallocateStatement::DeallocateStatement(std::string name)
+    : Statement(),
+      name_(std::move(name)) {}
+
+ExecuteResult DeallocateStatement::run(DBManager& dbManager) const {
+    dbManager.deallocatePreparedStatement(name_);
+    return { std::make_unique<TextView>("Statement deallocated"), false };
+}
+
+ResourcePtr<DeallocateStatement> DeallocateStatement::parse(TokenStream& ts) {
+    URSQL_EXPECT(ts.skipIf(Keyword::prepare_kw), MissingInput, "'prepare'");
+    return allocateUnique<DeallocateStatement>(
+      ts.getResource(), parser::parseNextIdentifierAsLast(ts));
+}
+
+}  // namespace ursql
@@ -1,3 +1,83 @@
-//
-// Created by Anran Zhao on 6/1/24.
-//
+#include "statement/SelectStatement.hpp"
+
+#include "controller/DBManager.hpp"
+#include "exception/UserError.hpp"
+#include "model/Database.hpp"
+#include "parser/Parser.hpp"
+#include "parser/TokenStream.hpp"
+#include "view/TabularView.hpp"
+
+namespace ursql {
+
+SelectStatement::SelectStatement(
+  std::string tableName, std::optional<std::vector<std::string>> attrNames,
+  std::optional<JoinClause> joinClause, ResourcePtr<Filter> filter)
+    : SingleTableStatement(std::move(tableName)),
+      attrNames_(std::move(attrNames)),
+      joinClause_(std::move(joinClause)),
+      filter_(std::move(filter)) {}
+
+ExecuteResult SelectStatement::run(DBManager& dbManager) const {
+    Database* activeDB = dbManager.getActiveDB();
+    URSQL_EXPECT(activeDB, NoActiveDB, );
+    std::vector<std::string> headers;
+    std::vector<std::vector<Value>> valueRows;
+    if (joinClause_.has_value()) {
+        valueRows = activeDB->joinTables(
+          tableName_, joinClause_->tableName, joinClause_->leftAttrName,
+          joinClause_->rightAttrName, attrNames_,
+          dbManager.getTransaction());
+        if (attrNames_.has_value()) {
+            headers = attrNames_.value();
+        } else {
+            headers = activeDB->getAttributeNames(tableName_);
+            std::ranges::copy(
+              activeDB->getAttributeNames(joinClause_->tableName),
+              std::back_inserter(headers));
+        }
+    } else {
+        valueRows = activeDB->selectFromTable(tableName_, attrNames_,
+                                              filter_.get(),
+                                              dbManager.getTransaction());
+        headers = attrNames_.has_value() ?
+                    attrNames_.value() :
+                    activeDB->getAttributeNames(tableName_);
+    }
+    return { std::make_unique<TabularView>(std::move(headers),
+                                           std::move(valueRows)),
+             false };
+}
+
+ResourcePtr<SelectStatement> SelectStatement::parse(TokenStream& ts) {
+    std::optional<std::vector<std::string>> attrNames;
+    if (!ts.skipIf(Operator::star)) {
+        attrNames =
+          parser::parseCommaSeparated(ts, parser::parseNextIdentifier);
+    }
+    URSQL_EXPECT(ts.skipIf(Keyword::from_kw), MissingInput, "'from'");
+    std::string tableName = parser::parseNextIdentifier(ts);
+    std::optional<JoinClause> joinClause;
+    if (ts.skipIf(Keyword::join_kw)) {
+        JoinClause clause;
+        clause.tableName = parser::parseNextIdentifier(ts);
+        URSQL_EXPECT(ts.skipIf(Keyword::on_kw), MissingInput,
+                     "'on' after joined table name");
+        clause.leftAttrName = parser::parseNextIdentifier(ts);
+        URSQL_EXPECT(ts.skipIf(Comparator::eq), MissingInput,
+                     "'=' in join condition");
+        clause.rightAttrName = parser::parseNextIdentifier(ts);
+        joinClause = std::move(clause);
+    }
+    ResourcePtr<Filter> filter;
+    if (ts.skipIf(Keyword::where_kw)) {
+        URSQL_EXPECT(!joinClause.has_value(), InvalidCommand,
+                     "'where' can't be combined with 'join' yet");
+        filter = Filter::parse(ts);
+    }
+    URSQL_EXPECT(!ts.hasNext(), RedundantInput, ts);
+    return allocateUnique<SelectStatement>(
+      ts.getResource(), std::move(tableName), std::move(attrNames),
+      std::move(joinClause), std::move(filter));
+}
+
+}  // namespace ursql
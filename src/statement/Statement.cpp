@@ -56,9 +56,9 @@ ExecuteResult ShowDBStatement::run(DBManager& dbManager) const {
     return { std::make_unique<ShowDBView>(dbNames), false };
 }
 
-std::unique_ptr<ShowDBStatement> ShowDBStatement::parse(TokenStream& ts) {
+ResourcePtr<ShowDBStatement> ShowDBStatement::parse(TokenStream& ts) {
     URSQL_EXPECT(!ts.hasNext(), RedundantInput, ts);
-    return std::make_unique<ShowDBStatement>();
+    return allocateUnique<ShowDBStatement>(ts.getResource());
 }
 
 class ShowTablesView : public TabularView {
@@ -90,10 +90,9 @@ ExecuteResult ShowTablesStatement::run(DBManager& dbManager) const {
              false };
 }
 
-std::unique_ptr<ShowTablesStatement> ShowTablesStatement::parse(
-  TokenStream& ts) {
+ResourcePtr<ShowTablesStatement> ShowTablesStatement::parse(TokenStream& ts) {
     URSQL_EXPECT(!ts.hasNext(), RedundantInput, ts);
-    return std::make_unique<ShowTablesStatement>();
+    return allocateUnique<ShowTablesStatement>(ts.getResource());
 }
 
 }  // namespace ursql
@@ -0,0 +1,23 @@
+#include "statement/TransactionStatement.hpp"
+
+#include "controller/DBManager.hpp"
+#include "view/RowsAffectedTextView.hpp"
+
+namespace ursql {
+
+ExecuteResult BeginStatement::run(DBManager& dbManager) const {
+    dbManager.beginTransaction();
+    return { std::make_unique<RowsAffectedTextView>(0), false };
+}
+
+ExecuteResult CommitStatement::run(DBManager& dbManager) const {
+    dbManager.commitTransaction();
+    return { std::make_unique<RowsAffectedTextView>(0), false };
+}
+
+ExecuteResult RollbackStatement::run(DBManager& dbManager) const {
+    dbManager.rollbackTransaction();
+    return { std::make_unique<RowsAffectedTextView>(0), false };
+}
+
+}  // namespace ursql
@@ -0,0 +1,32 @@
+#include "statement/TruncateTableStatement.hpp"
+
+#include "controller/DBManager.hpp"
+#include "exception/UserError.hpp"
+#include "model/Database.hpp"
+#include "parser/Parser.hpp"
+#include "parser/TokenStream.hpp"
+#include "view/RowsAffectedTextView.hpp"
+
+namespace ursql {
+
+TruncateTableStatement::TruncateTableStatement(std::string tableName)
+    : SingleTableStatement(std::move(tableName)) {}
+
+ExecuteResult TruncateTableStatement::run(DBManager& dbManager) const {
+    Database* activeDB = dbManager.getActiveDB();
+    URSQL_EXPECT(activeDB, NoActiveDB, );
+    std::size_t rowCount =
+      activeDB->truncateTable(tableName_, dbManager.getTransaction());
+    return { std::make_unique<RowsAffectedTextView>(rowCount), false };
+}
+
+ResourcePtr<TruncateTableStatement> TruncateTableStatement::parse(
+  TokenStream& ts) {
+    URSQL_EXPECT(ts.skipIf(Keyword::table_kw), MissingInput, "'table'");
+    std::string tableName = parser::parseNextIdentifier(ts);
+    URSQL_EXPECT(!ts.hasNext(), RedundantInput, ts);
+    return allocateUnique<TruncateTableStatement>(ts.getResource(),
+                                                  std::move(tableName));
+}
+
+}  // namespace ursql
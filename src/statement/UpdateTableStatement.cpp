@@ -0,0 +1,48 @@
+#include "statement/UpdateTableStatement.hpp"
+
+#include "controller/DBManager.hpp"
+#include "exception/UserError.hpp"
+#include "model/Database.hpp"
+#include "parser/Parser.hpp"
+#include "parser/TokenStream.hpp"
+#include "view/RowsAffectedTextView.hpp"
+
+namespace ursql {
+
+UpdateTableStatement::UpdateTableStatement(
+  std::string tableName, std::vector<Assignment> assignments,
+  ResourcePtr<Filter> filter)
+    : SingleTableStatement(std::move(tableName)),
+      assignments_(std::move(assignments)),
+      filter_(std::move(filter)) {}
+
+ExecuteResult UpdateTableStatement::run(DBManager& dbManager) const {
+    Database* activeDB = dbManager.getActiveDB();
+    URSQL_EXPECT(activeDB, NoActiveDB, );
+    std::size_t rowCount =
+      activeDB->updateTable(tableName_, assignments_, filter_.get(),
+                            dbManager.getTransaction());
+    return { std::make_unique<RowsAffectedTextView>(rowCount), false };
+}
+
+ResourcePtr<UpdateTableStatement> UpdateTableStatement::parse(TokenStream& ts) {
+    std::string tableName = parser::parseNextIdentifier(ts);
+    URSQL_EXPECT(ts.skipIf(Keyword::set_kw), MissingInput, "'set'");
+    std::vector<Assignment> assignments =
+      parser::parseCommaSeparated(ts, [](TokenStream& ts1) {
+          std::string attrName = parser::parseNextIdentifier(ts1);
+          URSQL_EXPECT(ts1.skipIf(Comparator::eq), MissingInput,
+                       "'=' after column name");
+          return Assignment(std::move(attrName), Value::parse(ts1));
+      });
+    ResourcePtr<Filter> filter;
+    if (ts.skipIf(Keyword::where_kw)) {
+        filter = Filter::parse(ts);
+    }
+    URSQL_EXPECT(!ts.hasNext(), RedundantInput, ts);
+    return allocateUnique<UpdateTableStatement>(
+      ts.getResource(), std::move(tableName), std::move(assignments),
+      std::move(filter));
+}
+
+}  // namespace ursql
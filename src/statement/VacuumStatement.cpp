@@ -0,0 +1,34 @@
+#include "statement/VacuumStatement.hpp"
+
+#include "controller/DBManager.hpp"
+#include "exception/UserError.hpp"
+#include "model/Database.hpp"
+#include "parser/Parser.hpp"
+#include "parser/TokenStream.hpp"
+#include "view/RowsAffectedTextView.hpp"
+
+namespace ursql {
+
+VacuumStatement::VacuumStatement(std::optional<std::string> tableName)
+    : tableName_(std::move(tableName)) {}
+
+ExecuteResult VacuumStatement::run(DBManager& dbManager) const {
+    Database* activeDB = dbManager.getActiveDB();
+    URSQL_EXPECT(activeDB, NoActiveDB, );
+    // The rows are moved in a transaction of their own.
+    dbManager.commitTransaction();
+    std::size_t rowCount = activeDB->vacuum(tableName_);
+    return { std::make_unique<RowsAffectedTextView>(rowCount), false };
+}
+
+ResourcePtr<VacuumStatement> VacuumStatement::parse(TokenStream& ts) {
+    std::optional<std::string> tableName;
+    if (ts.hasNext()) {
+        tableName = parser::parseNextIdentifier(ts);
+    }
+    URSQL_EXPECT(!ts.hasNext(), RedundantInput, ts);
+    return allocateUnique<VacuumStatement>(ts.getResource(),
+                                           std::move(tableName));
+}
+
+}  // namespace ursql
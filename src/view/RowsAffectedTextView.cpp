@@ -4,16 +4,17 @@
 
 namespace ursql {
 
-namespace {
+RowsAffectedTextView::RowsAffectedTextView(std::size_t numRows)
+    : View(),
+      numRows_(numRows) {}
 
-std::string num2RowsAffectedText(std::size_t numRows) {
-    return std::format("Query OK, {} row{} affected", numRows,
-                       numRows > 1 ? "s" : "");
+void RowsAffectedTextView::show(std::ostream& os) const {
+    os << std::format("Query OK, {} row{} affected", numRows_,
+                      numRows_ > 1 ? "s" : "");
 }
 
-}  // namespace
-
-RowsAffectedTextView::RowsAffectedTextView(std::size_t numRows)
-    : TextView(num2RowsAffectedText(numRows)) {}
+std::size_t RowsAffectedTextView::getNumRows() const {
+    return numRows_;
+}
 
 }  // namespace ursql
@@ -47,6 +47,14 @@ void TabularView::show(std::ostream& os) const {
        << " in set";
 }
 
+const std::vector<std::string>& TabularView::getHeaders() const {
+    return headers_;
+}
+
+const std::vector<std::vector<Value>>& TabularView::getValueRows() const {
+    return valueRows_;
+}
+
 void TabularView::_printBreak(std::ostream& os,
                               const std::vector<std::size_t>& widths) {
     os << '+';
@@ -8,4 +8,8 @@ void TextView::show(std::ostream& os) const {
     os << text_;
 }
 
+const std::string& TextView::getText() const {
+    return text_;
+}
+
 }  // namespace ursql
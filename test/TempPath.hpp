@@ -0,0 +1,39 @@
+#pragma once
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <format>
+
+#include "common/Macros.hpp"
+
+namespace ursql {
+
+// A file or directory in the temporary directory, named after the test and
+// the process, which is removed with everything in it when this goes away.
+class TempPath {
+public:
+    explicit TempPath(std::string_view stem, std::string_view extension = "")
+        : path_(std::filesystem::temp_directory_path() /
+                std::format("ursql_{}_{}{}", stem, ::getpid(), extension)) {}
+
+    ~TempPath() {
+        std::error_code ec;
+        std::filesystem::remove_all(path_, ec);
+    }
+
+    URSQL_DISABLE_COPY(TempPath);
+
+    [[nodiscard]] const std::filesystem::path& get() const {
+        return path_;
+    }
+
+    operator const std::filesystem::path&() const {
+        return path_;
+    }
+
+private:
+    const std::filesystem::path path_;
+};
+
+}  // namespace ursql
@@ -1,6 +1,17 @@
+#include "controller/ConnectionTest.hpp"
+#include "controller/DatabasePoolTest.hpp"
+#include "controller/ServerTest.hpp"
+#include "execution/CsvParserTest.hpp"
+#include "execution/SortMergeJoinTest.hpp"
+#include "model/DatabaseTest.hpp"
+#include "model/LockManagerTest.hpp"
 #include "model/ValueTest.hpp"
+#include "parser/ScriptReaderTest.hpp"
 #include "parser/TokenStreamTest.hpp"
 #include "parser/TokenTest.hpp"
+#include "persistence/StorageTest.hpp"
+#include "statement/FilterTest.hpp"
+#include "statement/PreparedStatementTest.hpp"
 
 namespace ursql {
 
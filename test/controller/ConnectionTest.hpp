@@ -0,0 +1,115 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "TempPath.hpp"
+#include "controller/Connection.hpp"
+#include "exception/UserError.hpp"
+#include "statement/PreparedStatement.hpp"
+
+namespace ursql {
+
+class ConnectionTest : public testing::Test {
+protected:
+    void SetUp() override {
+        fs::create_directories(dir_);
+        conn_.open("embedded", true);
+        (void)conn_.execute("create table t (id int primary key "
+                            "auto_increment, n bigint, s varchar)");
+    }
+
+    const TempPath dir_{ "connection" };
+    Connection conn_{ dir_, ".db" };
+};
+
+TEST_F(ConnectionTest, execute) {
+    auto result = conn_.execute("insert into t (n, s) values (1, 'a'), "
+                                "(2, 'b')");
+    ASSERT_FALSE(result.hasRows());
+    ASSERT_EQ(2, result.getRowsAffected());
+
+    result = conn_.execute("select s, n from t where n > 1");
+    ASSERT_TRUE(result.hasRows());
+    ASSERT_EQ((std::vector<std::string>{ "s", "n" }), result.getColumnNames());
+    ASSERT_EQ(1, result.getRows().size());
+    ASSERT_EQ("b", result.getRows()[0][0].toString());
+
+    auto stmt = conn_.prepare("select id from t where n = ?");
+    result = conn_.execute(*stmt, { Value(1) });
+    ASSERT_EQ("1", result.getRows()[0][0].toString());
+    ASSERT_EQ("Database changed",
+              conn_.execute("use embedded").getMessage());
+}
+
+TEST_F(ConnectionTest, transactions) {
+    (void)conn_.execute("insert into t (n) values (1), (2)");
+    (void)conn_.execute("begin");
+    (void)conn_.execute("insert into t (n) values (3)");
+    (void)conn_.execute("update t set n = 0 where n = 1");
+    ASSERT_EQ(1, conn_.execute("delete from t where n = 2").getRowsAffected());
+    // The transaction sees its own changes, and rolling back undoes them.
+    ASSERT_EQ(2, conn_.execute("select * from t").getRows().size());
+    (void)conn_.execute("rollback");
+    auto rows = conn_.execute("select n from t").getRows();
+    ASSERT_EQ(2, rows.size());
+    ASSERT_EQ("1", rows[0][0].toString());
+    ASSERT_EQ("2", rows[1][0].toString());
+
+    (void)conn_.execute("begin");
+    (void)conn_.execute("truncate table t");
+    (void)conn_.execute("insert into t (n) values (4)");
+    (void)conn_.execute("commit");
+    rows = conn_.execute("select n from t").getRows();
+    ASSERT_EQ(1, rows.size());
+    ASSERT_EQ("4", rows[0][0].toString());
+}
+
+TEST_F(ConnectionTest, append) {
+    ASSERT_EQ(3, conn_.append("t", { "s", "n" },
+                              { { Value(std::string("a")), Value(),
+                                  Value(std::string("c")) },
+                                { Value(1), Value(2), Value(3) } }));
+    auto rows = conn_.execute("select * from t").getRows();
+    ASSERT_EQ(3, rows.size());
+    ASSERT_EQ("3", rows[2][0].toString());
+    ASSERT_EQ(ValueType::bigint_type, rows[2][1].getType());
+    ASSERT_TRUE(rows[1][2].isNull());
+
+    ASSERT_THROW((void)conn_.append("t", { "n" }, { { Value(1) }, {} }),
+                 MisMatch);
+    ASSERT_THROW(
+      (void)conn_.append("t", { "n", "s" }, { { Value(1) }, {} }), MisMatch);
+    ASSERT_THROW((void)conn_.append("t", { "nope" }, { { Value(1) } }),
+                 DoesNotExist);
+    ASSERT_EQ(3, conn_.execute("select * from t").getRows().size());
+}
+
+TEST_F(ConnectionTest, describeDatabaseSummary) {
+    // t's rows fill the rest of the first extent and the start of a
+    // second one, whose rest t keeps, so u starts a third one.
+    std::string insert = "insert into t (n) values (0)";
+    for (int i = 1; i < 100; ++i) {
+        insert += std::format(", ({})", i);
+    }
+    (void)conn_.execute(insert);
+    (void)conn_.execute("create table u (n int)");
+    auto result = conn_.execute("desc database embedded summary");
+    std::vector<std::vector<std::string>> rows;
+    for (auto& row : result.getRows()) {
+        auto& strs = rows.emplace_back();
+        for (auto& value : row) {
+            strs.push_back(value.toString());
+        }
+    }
+    // A lone block is a single run, and blocks of which no two are
+    // adjacent are as fragmented as can be.
+    std::vector<std::vector<std::string>> expected{
+        { "TOC", "1", "1", "1", "0%", "1", "0", "0", "0", "0" },
+        { "Entity", "2", "2", "1", "100%", "2", "0", "0", "0", "0" },
+        { "Row", "100", "1", "100", "0%", "0", "0", "0", "1", "0" },
+        { "Free", "90", "2", "63", "1%", "0", "0", "2", "0", "0" },
+    };
+    ASSERT_EQ(expected, rows);
+}
+
+}  // namespace ursql
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "TempPath.hpp"
+#include "controller/DatabasePool.hpp"
+
+namespace ursql {
+
+class DatabasePoolTest : public testing::Test {
+protected:
+    void SetUp() override {
+        fs::create_directories(dir_);
+    }
+
+    const TempPath dir_{ "pool" };
+};
+
+TEST_F(DatabasePoolTest, keepsRecentDatabasesOpen) {
+    DatabasePool pool(dir_, ".db", 2);
+    pool.create({ "a", "b", "c" });
+    Database* a = pool.open("a").get();
+    // Nobody uses it any more, but it's still open.
+    ASSERT_EQ(a, pool.open("a").get());
+    ASSERT_EQ(1, pool.getOpenDatabases().size());
+
+    (void)pool.open("b");
+    (void)pool.open("a");
+    (void)pool.open("c");
+    // The least recently used one was closed.
+    std::vector<std::string> openNames;
+    for (auto& database : pool.getOpenDatabases()) {
+        openNames.push_back(database->getName());
+    }
+    std::ranges::sort(openNames);
+    ASSERT_EQ((std::vector<std::string>{ "a", "c" }), openNames);
+
+    pool.drop({ "a" });
+    ASSERT_EQ(1, pool.getOpenDatabases().size());
+}
+
+}  // namespace ursql
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <thread>
+
+#include "TempPath.hpp"
+#include "controller/Server.hpp"
+
+namespace ursql {
+
+class ServerTest : public testing::Test {
+protected:
+    void SetUp() override {
+        fs::create_directories(dir_);
+        server_ = std::make_unique<Server>(
+          dir_.get() / "ursql.sock",
+          std::make_shared<DatabasePool>(dir_, ".db"), 2);
+        serving_ = std::thread([this]() {
+            server_->run();
+        });
+    }
+
+    void TearDown() override {
+        server_->stop();
+        serving_.join();
+        server_.reset();
+    }
+
+    int connect() {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strcpy(addr.sun_path, (dir_.get() / "ursql.sock").c_str());
+        EXPECT_EQ(0, ::connect(fd, reinterpret_cast<sockaddr*>(&addr),
+                               sizeof(addr)));
+        return fd;
+    }
+
+    // Sends the statements and reads until one reply per statement, each
+    // ending with an empty line, has arrived.
+    static std::string query(int fd, std::string_view sql,
+                             std::size_t replyCount) {
+        EXPECT_EQ(sql.size(), ::write(fd, sql.data(), sql.size()));
+        std::string replies;
+        auto countReplies = [&replies]() {
+            std::size_t count = 0;
+            for (auto pos = replies.find("\n\n"); pos != std::string::npos;
+                 pos = replies.find("\n\n", pos + 2))
+            {
+                ++count;
+            }
+            return count;
+        };
+        pollfd pfd{ fd, POLLIN, 0 };
+        char buf[4096];
+        while (countReplies() < replyCount && ::poll(&pfd, 1, 5000) > 0) {
+            ssize_t n = ::read(fd, buf, sizeof(buf));
+            if (n <= 0) {
+                break;
+            }
+            replies.append(buf, static_cast<std::size_t>(n));
+        }
+        return replies;
+    }
+
+    const TempPath dir_{ "server" };
+    std::unique_ptr<Server> server_;
+    std::thread serving_;
+};
+
+TEST_F(ServerTest, sessionsShareDatabases) {
+    int a = connect();
+    int b = connect();
+    std::string replies =
+      query(a, "create database shop; use shop; create table t (id int);", 3);
+    ASSERT_NE(std::string::npos, replies.find("Database changed"));
+
+    // Statements may arrive split anywhere.
+    ASSERT_EQ(std::string::npos, query(b, "use sh", 0).find("\n\n"));
+    replies = query(b, "op; insert into t values (7);", 2);
+    ASSERT_NE(std::string::npos, replies.find("1 row affected"));
+
+    // a sees b's row through the database both sessions share.
+    replies = query(a, "select * from t where id = 7;", 1);
+    ASSERT_NE(std::string::npos, replies.find("7"));
+
+    // Each session has its own active database.
+    ::close(b);
+    int c = connect();
+    replies = query(c, "select * from t;", 1);
+    ASSERT_NE(std::string::npos, replies.find("No database selected"));
+    ASSERT_NE(std::string::npos, query(c, "quit;", 1).find("Bye"));
+    char byte;
+    ASSERT_EQ(0, ::read(c, &byte, 1));
+    ::close(c);
+    ::close(a);
+}
+
+}  // namespace ursql
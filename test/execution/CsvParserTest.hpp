@@ -0,0 +1,69 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "exception/UserError.hpp"
+#include "execution/CsvParser.hpp"
+
+namespace ursql {
+
+TEST(CsvParser, typedFields) {
+    CsvParser parser({ ValueType::int_type, ValueType::float_type,
+                       ValueType::bool_type, ValueType::varchar_type });
+    std::vector<ValueRow> rows;
+    parser.parse("1,2.5,true,plain\r\n"
+                 "-3,,0,\"a, \"\"quoted\"\"\nfield\"\n"
+                 "\\N,1e2,FALSE,\"\"\n",
+                 rows);
+    ASSERT_EQ(3, rows.size());
+    ASSERT_EQ("1", rows[0][0].toString());
+    ASSERT_EQ("2.500000", rows[0][1].toString());
+    ASSERT_EQ(ValueType::bool_type, rows[0][2].getType());
+    ASSERT_EQ("plain", rows[0][3].toString());
+    ASSERT_EQ("-3", rows[1][0].toString());
+    ASSERT_TRUE(rows[1][1].isNull());
+    ASSERT_EQ("a, \"quoted\"\nfield", rows[1][3].toString());
+    ASSERT_TRUE(rows[2][0].isNull());
+    ASSERT_EQ("100.000000", rows[2][1].toString());
+    ASSERT_EQ(ValueType::varchar_type, rows[2][3].getType());
+    ASSERT_EQ("", rows[2][3].toString());
+}
+
+TEST(CsvParser, blankLines) {
+    CsvParser parser({ ValueType::int_type, ValueType::varchar_type });
+    std::vector<ValueRow> rows;
+    parser.parse("\n1,a\n\n\r\n2,b\n\n", rows);
+    ASSERT_EQ(2, rows.size());
+    ASSERT_EQ("1", rows[0][0].toString());
+    ASSERT_EQ("b", rows[1][1].toString());
+}
+
+TEST(CsvParser, malformed) {
+    CsvParser parser({ ValueType::int_type, ValueType::varchar_type });
+    std::vector<ValueRow> rows;
+    ASSERT_THROW(parser.parse("1\n", rows), MisMatch);
+    ASSERT_THROW(parser.parse("1,a,b\n", rows), MisMatch);
+    ASSERT_THROW(parser.parse("x,a\n", rows), MisMatch);
+    ASSERT_THROW(parser.parse("1,\"a\"b\n", rows), UnexpectedInput);
+}
+
+TEST(CsvParser, splitRecords) {
+    std::string_view text = "1,\"a\nb\"\n2,c\n3,d\n4,";
+    auto cuts = CsvParser::splitRecords(text, 2);
+    ASSERT_EQ(std::vector<std::size_t>({ 12, 16 }), cuts);
+    ASSERT_EQ(std::vector<std::size_t>({ 16 }),
+              CsvParser::splitRecords(text, 1));
+    ASSERT_EQ(std::vector<std::size_t>({ 0 }),
+              CsvParser::splitRecords("1,\"open\n", 4));
+    // Quotes inside unquoted fields and doubled quotes inside quoted ones
+    // don't start or end a quoted section.
+    text = "1,a\"b\n2,\"c\"\"\nd\"\n3,e\n";
+    ASSERT_EQ(std::vector<std::size_t>({ 6, 16, 20 }),
+              CsvParser::splitRecords(text, 3));
+    std::vector<ValueRow> rows;
+    CsvParser({ ValueType::int_type, ValueType::varchar_type })
+      .parse(text.substr(0, 6), rows);
+    ASSERT_EQ("a\"b", rows[0][1].toString());
+}
+
+}  // namespace ursql
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "execution/ExternalSorter.hpp"
+#include "execution/SortMergeJoin.hpp"
+
+namespace ursql {
+
+namespace {
+
+ValueRow makeRow(Value key, std::string payload) {
+    ValueRow row;
+    row.push_back(std::move(key));
+    row.emplace_back(std::move(payload));
+    return row;
+}
+
+std::vector<ValueRow> drain(RowCursor& cursor) {
+    std::vector<ValueRow> rows;
+    for (ValueRow row; cursor.next(row);) {
+        rows.push_back(std::move(row));
+    }
+    return rows;
+}
+
+}  // namespace
+
+TEST(ExternalSorter, inMemory) {
+    ExternalSorter sorter(0);
+    for (int i : { 5, 3, 9, 1, 3 }) {
+        sorter.add(makeRow(Value(i), std::to_string(i)));
+    }
+    auto rows = drain(*sorter.finish());
+    ASSERT_EQ(5, rows.size());
+    for (std::size_t i = 1; i < rows.size(); ++i) {
+        ASSERT_FALSE(rows[i][0] < rows[i - 1][0]);
+    }
+}
+
+TEST(ExternalSorter, spill) {
+    constexpr const int rowCount = 2000;
+    ExternalSorter sorter(0, 4 * Block::minSize);
+    for (int i = 0; i < rowCount; ++i) {
+        int key = (i * 7919) % rowCount;
+        sorter.add(makeRow(Value(key), std::format("payload {}", key)));
+    }
+    ASSERT_LT(1, sorter.getRunCount());
+    auto rows = drain(*sorter.finish());
+    ASSERT_EQ(rowCount, rows.size());
+    for (int i = 0; i < rowCount; ++i) {
+        ASSERT_EQ(Value(i), rows[i][0]);
+        ASSERT_EQ(std::format("payload {}", i), rows[i][1].toString());
+    }
+}
+
+TEST(SortMergeJoin, duplicateRuns) {
+    std::vector<ValueRow> left;
+    left.push_back(makeRow(Value(), "l-null"));
+    left.push_back(makeRow(Value(1), "l1"));
+    left.push_back(makeRow(Value(2), "l2a"));
+    left.push_back(makeRow(Value(2), "l2b"));
+    left.push_back(makeRow(Value(4), "l4"));
+    std::vector<ValueRow> right;
+    right.push_back(makeRow(Value(), "r-null"));
+    right.push_back(makeRow(Value(2.0f), "r2a"));
+    right.push_back(makeRow(Value(2), "r2b"));
+    right.push_back(makeRow(Value(2), "r2c"));
+    right.push_back(makeRow(Value(3), "r3"));
+    right.push_back(makeRow(Value(4), "r4"));
+
+    SortMergeJoin join(std::make_unique<VectorRowCursor>(std::move(left)), 0,
+                       std::make_unique<VectorRowCursor>(std::move(right)),
+                       0);
+    auto rows = drain(join);
+    ASSERT_EQ(7, rows.size());
+    std::vector<std::pair<std::string, std::string>> expected{
+        { "l2a", "r2a" }, { "l2a", "r2b" }, { "l2a", "r2c" }, { "l2b", "r2a" },
+        { "l2b", "r2b" }, { "l2b", "r2c" }, { "l4", "r4" }
+    };
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        ASSERT_EQ(4, rows[i].size());
+        ASSERT_EQ(expected[i].first, rows[i][1].toString());
+        ASSERT_EQ(expected[i].second, rows[i][3].toString());
+    }
+}
+
+}  // namespace ursql
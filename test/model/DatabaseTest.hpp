@@ -0,0 +1,571 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <fstream>
+#include <latch>
+#include <thread>
+
+#include "TempPath.hpp"
+#include "exception/UserError.hpp"
+#include "execution/CsvLoader.hpp"
+#include "model/Database.hpp"
+#include "model/Transaction.hpp"
+#include "parser/Lexer.hpp"
+#include "parser/TokenStream.hpp"
+#include "statement/Filter.hpp"
+
+namespace ursql {
+
+class DatabaseTest : public testing::Test {
+protected:
+    // A single int column named n, which most tables here are made of.
+    static std::vector<Attribute> intColumn() {
+        std::vector<Attribute> attributes(1);
+        attributes[0].setName("n");
+        attributes[0].setValueType(ValueType::int_type);
+        return attributes;
+    }
+
+    static ResourcePtr<Filter> parseFilter(std::string_view condition) {
+        TokenStream stream(Lexer(condition).lex());
+        return Filter::parse(stream);
+    }
+
+    const TempPath path_{ "database", ".tmp" };
+};
+
+TEST_F(DatabaseTest, concurrentReadersAndWriters) {
+    constexpr const int rowsPerWriter = 100;
+    Database database("shared", path_, CreateNewFile{});
+    std::vector<Attribute> attributes = intColumn();
+    database.createTable("a", attributes);
+    database.createTable("b", attributes);
+
+    std::vector<std::jthread> threads;
+    for (std::string table : { "a", "b" }) {
+        threads.emplace_back([&database, table]() {
+            for (int i = 0; i < rowsPerWriter; ++i) {
+                database.insertIntoTable(table, std::nullopt,
+                                         { { Value(i) } });
+            }
+        });
+        threads.emplace_back([&database, table]() {
+            // Each read sees a whole number of inserts.
+            std::size_t last = 0;
+            while (last < rowsPerWriter) {
+                std::size_t count =
+                  database.selectFromTable(table, std::nullopt, nullptr)
+                    .size();
+                ASSERT_GE(count, last);
+                last = count;
+            }
+        });
+    }
+    threads.emplace_back([&database, &attributes]() {
+        for (int i = 0; i < 20; ++i) {
+            database.createTable(std::format("t{}", i), attributes);
+            ASSERT_EQ(0, database.truncateTable(std::format("t{}", i)));
+            database.dropTables({ std::format("t{}", i) });
+        }
+    });
+    threads.clear();
+
+    auto rows = database.joinTables("a", "b", "a.n", "b.n", std::nullopt);
+    ASSERT_EQ(rowsPerWriter, rows.size());
+    std::vector<std::string> tableNames = database.getAllEntityNames();
+    std::ranges::sort(tableNames);
+    ASSERT_EQ((std::vector<std::string>{ "a", "b" }), tableNames);
+}
+
+TEST_F(DatabaseTest, readersSeeConsistentSnapshots) {
+    constexpr const int rowCount = 50;
+    Database database("versions", path_, CreateNewFile{});
+    std::vector<Attribute> attributes = intColumn();
+    database.createTable("t", attributes);
+    std::pmr::vector<ValueList> valueLists;
+    for (int i = 0; i < rowCount; ++i) {
+        valueLists.push_back({ Value(0) });
+    }
+    database.insertIntoTable("t", std::nullopt, valueLists);
+
+    constexpr const int updateCount = 200;
+    std::atomic<bool> updating = true;
+    std::vector<std::jthread> threads;
+    threads.emplace_back([&database, &updating, rowCount]() {
+        for (int i = 1; i <= updateCount; ++i) {
+            ASSERT_EQ(rowCount,
+                      database.updateTable("t", { { "n", Value(i) } },
+                                           nullptr));
+        }
+        updating = false;
+    });
+    for (int reader = 0; reader < 2; ++reader) {
+        threads.emplace_back([&database, &updating, rowCount]() {
+            // Each read sees every row as of one update.
+            while (updating) {
+                auto rows =
+                  database.selectFromTable("t", std::nullopt, nullptr);
+                ASSERT_EQ(rowCount, rows.size());
+                for (auto& row : rows) {
+                    ASSERT_EQ(rows.front()[0].toInteger(),
+                              row[0].toInteger());
+                }
+            }
+        });
+    }
+    threads.clear();
+
+    // Nothing reads any more, so only the live versions are left.
+    database.reclaimVersions();
+    ASSERT_EQ(0, database.reclaimVersions());
+    auto rows = database.selectFromTable("t", std::nullopt, nullptr);
+    ASSERT_EQ(rowCount, rows.size());
+    ASSERT_EQ(updateCount, rows.front()[0].toInteger());
+    std::vector<BlockType> blockTypes = database.getBlockTypes();
+    ASSERT_EQ(rowCount, std::ranges::count(blockTypes, BlockType::row));
+}
+
+TEST_F(DatabaseTest, transactionIsolation) {
+    Database database("transactions", path_, CreateNewFile{});
+    std::vector<Attribute> attributes = intColumn();
+    database.createTable("t", attributes);
+    database.insertIntoTable("t", std::nullopt, { { Value(1) } });
+
+    std::unique_ptr<Transaction> transaction = database.beginTransaction();
+    database.insertIntoTable("t", std::nullopt, { { Value(2) } },
+                             transaction.get());
+    ASSERT_EQ(2, database.selectFromTable("t", std::nullopt, nullptr,
+                                          transaction.get())
+                   .size());
+    // Others don't see the uncommitted row, but can add rows next to it.
+    database.insertIntoTable("t", std::nullopt, { { Value(4) } });
+    ASSERT_EQ(2, database.selectFromTable("t", std::nullopt, nullptr).size());
+
+    // Later commits stay invisible to the transaction's snapshot.
+    database.createTable("u", attributes);
+    database.insertIntoTable("u", std::nullopt, { { Value(3) } });
+    ASSERT_EQ(0, database.selectFromTable("u", std::nullopt, nullptr,
+                                          transaction.get())
+                   .size());
+    database.commit(*transaction);
+    ASSERT_EQ(3, database.selectFromTable("t", std::nullopt, nullptr).size());
+    ASSERT_EQ(3, database.truncateTable("t"));
+}
+
+TEST_F(DatabaseTest, deleteRemovesMatchingRows) {
+    Database database("delete", path_, CreateNewFile{});
+    std::vector<Attribute> attributes = intColumn();
+    database.createTable("t", attributes);
+    std::pmr::vector<ValueList> valueLists;
+    for (int i = 0; i < 10; ++i) {
+        valueLists.push_back({ Value(i) });
+    }
+    valueLists.push_back({ Value() });
+    database.insertIntoTable("t", std::nullopt, valueLists);
+
+    auto remaining = [&database](const Transaction* transaction = nullptr) {
+        std::vector<std::string> values;
+        for (auto& row :
+             database.selectFromTable("t", std::nullopt, nullptr, transaction))
+        {
+            values.push_back(row[0].toString());
+        }
+        std::ranges::sort(values);
+        return values;
+    };
+    // NULL is neither in the range nor out of it, so it stays.
+    auto inRange = parseFilter("n >= 3 and n < 7");
+    ASSERT_EQ(4, database.deleteFromTable("t", inRange.get()));
+    ASSERT_EQ((std::vector<std::string>{ "0", "1", "2", "7", "8", "9",
+                                         "NULL" }),
+              remaining());
+    auto outOfRange = parseFilter("not (n >= 3 and n < 7)");
+    ASSERT_EQ(0, database.deleteFromTable("t", inRange.get()));
+
+    std::unique_ptr<Transaction> transaction = database.beginTransaction();
+    auto odd = parseFilter("n = 1 or n = 7 or n = 9");
+    ASSERT_EQ(3, database.deleteFromTable("t", odd.get(), transaction.get()));
+    ASSERT_EQ((std::vector<std::string>{ "0", "2", "8", "NULL" }),
+              remaining(transaction.get()));
+    ASSERT_EQ(7, remaining().size());
+    database.commit(*transaction);
+    ASSERT_EQ((std::vector<std::string>{ "0", "2", "8", "NULL" }),
+              remaining());
+    ASSERT_EQ(3, database.deleteFromTable("t", outOfRange.get()));
+    ASSERT_EQ((std::vector<std::string>{ "NULL" }), remaining());
+}
+
+TEST_F(DatabaseTest, updateChangesMatchingRows) {
+    Database database("update", path_, CreateNewFile{});
+    std::vector<Attribute> attributes = intColumn();
+    attributes.resize(2);
+    attributes[1].setName("s");
+    attributes[1].setValueType(ValueType::varchar_type);
+    database.createTable("t", attributes);
+    std::pmr::vector<ValueList> valueLists;
+    for (int i = 0; i < 6; ++i) {
+        valueLists.push_back({ Value(i), Value(std::string("old")) });
+    }
+    database.insertIntoTable("t", std::nullopt, valueLists);
+
+    auto values = [&database](const Transaction* transaction = nullptr) {
+        std::vector<std::string> values(6);
+        for (auto& row :
+             database.selectFromTable("t", std::nullopt, nullptr, transaction))
+        {
+            values.at(row[0].toInteger()) = row[1].toString();
+        }
+        return values;
+    };
+    // In place, then as new versions inside a transaction.
+    auto low = parseFilter("n < 2");
+    ASSERT_EQ(2, database.updateTable(
+                   "t", { { "s", Value(std::string("new")) } }, low.get()));
+    ASSERT_EQ((std::vector<std::string>{ "new", "new", "old", "old", "old",
+                                         "old" }),
+              values());
+
+    std::unique_ptr<Transaction> transaction = database.beginTransaction();
+    auto high = parseFilter("n >= 4 or s = 'new'");
+    ASSERT_EQ(4, database.updateTable("t",
+                                      { { "s", Value(std::string("longer")) } },
+                                      high.get(), transaction.get()));
+    ASSERT_EQ((std::vector<std::string>{ "longer", "longer", "old", "old",
+                                         "longer", "longer" }),
+              values(transaction.get()));
+    ASSERT_EQ((std::vector<std::string>{ "new", "new", "old", "old", "old",
+                                         "old" }),
+              values());
+    database.commit(*transaction);
+    ASSERT_EQ((std::vector<std::string>{ "longer", "longer", "old", "old",
+                                         "longer", "longer" }),
+              values());
+}
+
+TEST_F(DatabaseTest, checkpointSavesCommittedState) {
+    Database database("checkpoint", path_, CreateNewFile{});
+    std::vector<Attribute> attributes = intColumn();
+    database.createTable("t", attributes);
+    // The blocks of the new table and of the TOC wait in the cache.
+    ASSERT_EQ(2, database.writeDirtyBlocks(64));
+    ASSERT_EQ(0, database.writeDirtyBlocks(64));
+
+    database.insertIntoTable("t", std::nullopt,
+                             { { Value(1) }, { Value(2) } });
+    std::unique_ptr<Transaction> transaction = database.beginTransaction();
+    database.insertIntoTable("t", std::nullopt, { { Value(3) } },
+                             transaction.get());
+    database.checkpoint();
+    {
+        // The file holds the committed rows without being closed.
+        Database copy("checkpoint", path_, OpenExistingFile{});
+        auto rows = copy.selectFromTable("t", std::nullopt, nullptr);
+        ASSERT_EQ(2, rows.size());
+    }
+    database.rollback(*transaction);
+}
+
+TEST_F(DatabaseTest, vacuumMovesRowsDownAndShrinksFile) {
+    Database database("vacuum", path_, CreateNewFile{});
+    std::vector<Attribute> attributes = intColumn();
+    std::pmr::vector<ValueList> valueLists;
+    for (int i = 0; i < 50; ++i) {
+        valueLists.push_back({ Value(i) });
+    }
+    for (std::string table : { "a", "b" }) {
+        database.createTable(table, attributes);
+        database.insertIntoTable(table, std::nullopt, valueLists);
+    }
+    ASSERT_EQ(50, database.truncateTable("a"));
+
+    // A snapshot taken before still reads the rows where they were.
+    std::unique_ptr<Transaction> transaction = database.beginTransaction();
+    ASSERT_EQ(50, database.vacuum("b"));
+    ASSERT_EQ(50, database.selectFromTable("b", std::nullopt, nullptr,
+                                           transaction.get())
+                    .size());
+    // The old blocks are only cut off once the snapshot is done.
+    auto rowBlockCount = [&database]() {
+        return std::ranges::count(database.getBlockTypes(), BlockType::row);
+    };
+    ASSERT_EQ(100, rowBlockCount());
+    std::size_t blockCnt = database.getBlockTypes().size();
+    database.commit(*transaction);
+
+    ASSERT_EQ(0, database.vacuum(std::nullopt));
+    ASSERT_EQ(50, rowBlockCount());
+    std::vector<BlockType> blockTypes = database.getBlockTypes();
+    ASSERT_EQ(blockCnt - 50, blockTypes.size());
+    ASSERT_NE(BlockType::free, blockTypes.back());
+    auto rows = database.selectFromTable("b", std::nullopt, nullptr);
+    ASSERT_EQ(50, rows.size());
+    for (int i = 0; i < 50; ++i) {
+        ASSERT_EQ(Value(i), rows[i][0]);
+    }
+}
+
+TEST_F(DatabaseTest, largeBlocksHoldLargeRows) {
+    std::vector<Attribute> attributes(1);
+    attributes[0].setName("s");
+    attributes[0].setValueType(ValueType::varchar_type);
+    std::string text(10000, 'x');
+    {
+        Database database("large", path_, CreateNewFile{ 16384 });
+        database.createTable("t", attributes);
+        database.insertIntoTable("t", std::nullopt, { { Value(text) } });
+    }
+    // The block size comes back from the file.
+    Database database("large", path_, OpenExistingFile{});
+    auto rows = database.selectFromTable("t", std::nullopt, nullptr);
+    ASSERT_EQ(1, rows.size());
+    ASSERT_EQ(text, rows[0][0].toString());
+}
+
+TEST_F(DatabaseTest, deadlockVictimRollsBack) {
+    Database database("deadlock", path_, CreateNewFile{});
+    std::vector<Attribute> attributes = intColumn();
+    for (std::string table : { "a", "b" }) {
+        database.createTable(table, attributes);
+        database.insertIntoTable(table, std::nullopt, { { Value(0) } });
+    }
+
+    // Each transaction updates one table, then the other one's.
+    std::atomic<int> deadlocks = 0;
+    std::latch firstUpdates(2);
+    auto run = [&](std::string first, std::string second, int n) {
+        std::unique_ptr<Transaction> transaction =
+          database.beginTransaction();
+        try {
+            database.updateTable(first, { { "n", Value(n) } }, nullptr,
+                                 transaction.get());
+            firstUpdates.arrive_and_wait();
+            database.updateTable(second, { { "n", Value(n) } }, nullptr,
+                                 transaction.get());
+            database.commit(*transaction);
+        } catch (const Deadlock&) {
+            ASSERT_TRUE(transaction->hasEnded());
+            ++deadlocks;
+        }
+    };
+    {
+        std::jthread one(run, "a", "b", 1);
+        std::jthread two(run, "b", "a", 2);
+    }
+
+    // The victim's changes are gone, the other's are all there.
+    ASSERT_EQ(1, deadlocks);
+    auto a = database.selectFromTable("a", std::nullopt, nullptr);
+    auto b = database.selectFromTable("b", std::nullopt, nullptr);
+    ASSERT_EQ(1, a.size());
+    ASSERT_EQ(1, b.size());
+    ASSERT_EQ(a[0][0].toInteger(), b[0][0].toInteger());
+}
+
+TEST_F(DatabaseTest, truncatedTableReusesItsBlocks) {
+    Database database("reuse", path_, CreateNewFile{});
+    std::vector<Attribute> attributes = intColumn();
+    database.createTable("t", attributes);
+    // The rows take every free block, so new ones could only be appended.
+    std::pmr::vector<ValueList> valueLists(
+      std::ranges::count(database.getBlockTypes(), BlockType::free),
+      { Value(1) });
+    database.insertIntoTable("t", std::nullopt, valueLists);
+    std::vector<BlockType> blockTypes = database.getBlockTypes();
+    ASSERT_EQ(0, std::ranges::count(blockTypes, BlockType::free));
+
+    ASSERT_EQ(valueLists.size(), database.truncateTable("t"));
+    ASSERT_EQ(valueLists.size(),
+              std::ranges::count(database.getBlockTypes(), BlockType::free));
+    database.insertIntoTable("t", std::nullopt, valueLists);
+    ASSERT_EQ(blockTypes, database.getBlockTypes());
+    ASSERT_EQ(valueLists.size(),
+              database.selectFromTable("t", std::nullopt, nullptr).size());
+}
+
+TEST_F(DatabaseTest, failedInsertGivesItsBlocksBack) {
+    Database database("oversized", path_, CreateNewFile{});
+    std::vector<Attribute> attributes(1);
+    attributes[0].setName("s");
+    attributes[0].setValueType(ValueType::varchar_type);
+    database.createTable("t", attributes);
+    // The rows fill the file, and then wait to be released.
+    std::size_t blockCnt = database.getBlockTypes().size();
+    std::pmr::vector<ValueList> valueLists(
+      std::ranges::count(database.getBlockTypes(), BlockType::free),
+      { Value(std::string("x")) });
+    database.insertIntoTable("t", std::nullopt, valueLists);
+    ASSERT_EQ(valueLists.size(), database.truncateTable("t"));
+
+    std::string text(Block::defaultSize, 'x');
+    ASSERT_ANY_THROW(
+      database.insertIntoTable("t", std::nullopt, { { Value(text) } }));
+    // The block taken for the row that didn't fit is reused.
+    database.insertIntoTable("t", std::nullopt, valueLists);
+    ASSERT_EQ(blockCnt, database.getBlockTypes().size());
+}
+
+TEST_F(DatabaseTest, rowDirectorySpansBlocks) {
+    constexpr const int rowCount = 100000;
+    TempPath csvPath("database", ".csv");
+    {
+        std::ofstream csv(csvPath.get());
+        for (int i = 0; i < rowCount; ++i) {
+            csv << i << '\n';
+        }
+    }
+    std::vector<Attribute> attributes = intColumn();
+    auto entityBlockCount = [](Database& database) {
+        return std::ranges::count(database.getBlockTypes(), BlockType::entity);
+    };
+    {
+        Database database("directory", path_,
+                          CreateNewFile{ Block::minSize });
+        database.createTable("t", attributes);
+        ASSERT_EQ(rowCount, database.loadIntoTable("t", csvPath));
+        database.checkpoint();
+        // The entity block holds all but the attributes and three counts,
+        // the last slot leading to the directory blocks, which hold all
+        // but a count and the number of the next one.
+        constexpr const std::size_t payloadSize =
+          Block::minSize - sizeof(BlockType);
+        std::size_t entityBlockRows =
+          (payloadSize - 3 * sizeof(std::size_t) -
+           attributes[0].encodedSize()) / sizeof(std::size_t) - 1;
+        std::size_t directoryBlockRows =
+          payloadSize / sizeof(std::size_t) - 2;
+        ASSERT_EQ(1 + (rowCount - entityBlockRows + directoryBlockRows - 1) /
+                        directoryBlockRows,
+                  entityBlockCount(database));
+    }
+    {
+        // The directory comes back whole and in order.
+        Database database("directory", path_, OpenExistingFile{});
+        auto rows = database.selectFromTable("t", std::nullopt, nullptr);
+        ASSERT_EQ(rowCount, rows.size());
+        for (int i = 0; i < rowCount; ++i) {
+            ASSERT_EQ(Value(i), rows[i][0]);
+        }
+        // Directory blocks it no longer needs are given back.
+        auto filter = parseFilter("n >= 100");
+        ASSERT_EQ(rowCount - 100, database.deleteFromTable("t", filter.get()));
+        database.checkpoint();
+        ASSERT_EQ(1, entityBlockCount(database));
+    }
+    Database database("directory", path_, OpenExistingFile{});
+    ASSERT_EQ(100, database.selectFromTable("t", std::nullopt, nullptr).size());
+    ASSERT_EQ(1, entityBlockCount(database));
+}
+
+TEST_F(DatabaseTest, failedLoadLeavesNothingBehind) {
+    // The first chunk of the file loads, the second one doesn't parse.
+    TempPath csvPath("database", ".csv");
+    {
+        std::ofstream csv(csvPath.get());
+        std::string text(4200, 'x');
+        for (std::size_t size = 0; size <= CsvLoader::chunkSize;
+             size += text.size())
+        {
+            csv << "1," << text << '\n';
+        }
+        csv << "x,y\n";
+    }
+    Database database("load", path_, CreateNewFile{ 8192 });
+    std::vector<Attribute> attributes = intColumn();
+    attributes.resize(2);
+    attributes[1].setName("s");
+    attributes[1].setValueType(ValueType::varchar_type);
+    database.createTable("t", attributes);
+    ASSERT_THROW((void)database.loadIntoTable("t", csvPath), MisMatch);
+    ASSERT_EQ(0, database.selectFromTable("t", std::nullopt, nullptr).size());
+    ASSERT_EQ(0,
+              std::ranges::count(database.getBlockTypes(), BlockType::row));
+
+    // Inside a transaction, the whole transaction is rolled back.
+    std::unique_ptr<Transaction> transaction = database.beginTransaction();
+    database.insertIntoTable("t", std::nullopt,
+                             { { Value(1), Value(std::string("a")) } },
+                             transaction.get());
+    ASSERT_THROW((void)database.loadIntoTable("t", csvPath, transaction.get()),
+                 MisMatch);
+    ASSERT_TRUE(transaction->hasEnded());
+    ASSERT_EQ(0, database.selectFromTable("t", std::nullopt, nullptr).size());
+}
+
+TEST_F(DatabaseTest, updateInPlaceIsAllOrNothing) {
+    Database database("inplace", path_, CreateNewFile{ Block::minSize });
+    std::vector<Attribute> attributes(2);
+    attributes[0].setName("s");
+    attributes[0].setValueType(ValueType::varchar_type);
+    attributes[1].setName("t");
+    attributes[1].setValueType(ValueType::varchar_type);
+    database.createTable("t", attributes);
+    database.insertIntoTable(
+      "t", std::nullopt,
+      { { Value(std::string("a")), Value(std::string("b")) },
+        { Value(std::string(600, 'a')), Value(std::string("b")) } });
+
+    // The new value fits the first row's block, but not the second's.
+    ASSERT_THROW((void)database.updateTable(
+                   "t", { { "t", Value(std::string(500, 'b')) } }, nullptr),
+                 InvalidCommand);
+    auto rows = database.selectFromTable("t", std::nullopt, nullptr);
+    ASSERT_EQ(2, rows.size());
+    ASSERT_EQ("b", rows[0][1].toString());
+    ASSERT_EQ("b", rows[1][1].toString());
+
+    // A field of the same size is patched, a longer one re-encodes its row.
+    ASSERT_EQ(2, database.updateTable(
+                   "t", { { "t", Value(std::string("c")) } }, nullptr));
+    ASSERT_EQ(2, database.updateTable(
+                   "t", { { "s", Value(std::string("longer")) } }, nullptr));
+    rows = database.selectFromTable("t", std::nullopt, nullptr);
+    ASSERT_EQ(2, rows.size());
+    for (auto& row : rows) {
+        ASSERT_EQ("longer", row[0].toString());
+        ASSERT_EQ("c", row[1].toString());
+    }
+}
+
+TEST_F(DatabaseTest, opensFilesWithoutBlockSize) {
+    std::vector<Attribute> attributes = intColumn();
+    {
+        Database database("old", path_, CreateNewFile{ Block::minSize });
+        database.createTable("t", attributes);
+        database.insertIntoTable("t", std::nullopt, { { Value(7) } });
+    }
+    {
+        // The TOC as it was before, with the table count right after the
+        // block type.
+        std::fstream file(path_.get(), std::ios_base::binary |
+                                         std::ios_base::in |
+                                         std::ios_base::out);
+        std::string block(Block::minSize, '\0');
+        file.read(block.data(), static_cast<std::streamsize>(block.size()));
+        block.erase(sizeof(BlockType), sizeof(std::size_t));
+        block.resize(Block::minSize, '\0');
+        file.seekp(0);
+        file.write(block.data(), static_cast<std::streamsize>(block.size()));
+    }
+    {
+        Database database("old", path_, OpenExistingFile{});
+        auto rows = database.selectFromTable("t", std::nullopt, nullptr);
+        ASSERT_EQ(1, rows.size());
+        ASSERT_EQ(Value(7), rows[0][0]);
+        database.createTable("u", attributes);
+    }
+    // Once changed, the TOC starts with the block size again.
+    {
+        std::ifstream file(path_.get(), std::ios_base::binary);
+        file.seekg(sizeof(BlockType));
+        std::size_t blockSize = 0;
+        file.read(reinterpret_cast<char*>(&blockSize), sizeof(blockSize));
+        ASSERT_EQ(Block::minSize, blockSize);
+    }
+    Database database("old", path_, OpenExistingFile{});
+    ASSERT_EQ(1, database.selectFromTable("t", std::nullopt, nullptr).size());
+    ASSERT_EQ(0, database.selectFromTable("u", std::nullopt, nullptr).size());
+}
+
+}  // namespace ursql
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include "exception/UserError.hpp"
+#include "model/LockManager.hpp"
+
+namespace ursql {
+
+TEST(LockManagerTest, compatibleModes) {
+    LockManager lockManager(std::chrono::milliseconds(10));
+    LockTarget table = LockTarget::ofTable("t");
+    ASSERT_TRUE(lockManager.tryLock(1, table, LockMode::intention_exclusive));
+    ASSERT_TRUE(lockManager.tryLock(2, table, LockMode::intention_exclusive));
+    ASSERT_TRUE(lockManager.tryLock(1, LockTarget::ofRow("t", 0),
+                                    LockMode::exclusive));
+    ASSERT_TRUE(lockManager.tryLock(2, LockTarget::ofRow("t", 1),
+                                    LockMode::exclusive));
+    ASSERT_FALSE(lockManager.tryLock(2, LockTarget::ofRow("t", 0),
+                                     LockMode::shared));
+    ASSERT_FALSE(lockManager.tryLock(3, table, LockMode::shared));
+
+    lockManager.unlockAll(2);
+    // Shared and intention exclusive together take the table exclusively.
+    ASSERT_TRUE(lockManager.tryLock(1, table, LockMode::shared));
+    ASSERT_FALSE(lockManager.tryLock(3, table, LockMode::intention_shared));
+    lockManager.unlockAll(1);
+    ASSERT_TRUE(lockManager.tryLock(3, table, LockMode::exclusive));
+    ASSERT_EQ(1, lockManager.getLockedTargetCount());
+    lockManager.unlockAll(3);
+    ASSERT_EQ(0, lockManager.getLockedTargetCount());
+}
+
+TEST(LockManagerTest, waitsUntilUnlockedOrTimeout) {
+    LockManager lockManager(std::chrono::milliseconds(50));
+    LockTarget row = LockTarget::ofRow("t", 7);
+    lockManager.lock(1, row, LockMode::exclusive);
+    ASSERT_THROW(lockManager.lock(2, row, LockMode::exclusive), LockTimeout);
+    ASSERT_FALSE(lockManager.tryLock(3, row, LockMode::shared));
+    ASSERT_EQ(1, lockManager.getLockedTargetCount());
+
+    std::jthread holder([&lockManager]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        lockManager.unlockAll(1);
+    });
+    lockManager.lock(2, row, LockMode::exclusive);
+}
+
+TEST(LockManagerTest, detectsDeadlocks) {
+    LockManager lockManager(std::chrono::seconds(10));
+    LockTarget a = LockTarget::ofTable("a");
+    LockTarget b = LockTarget::ofTable("b");
+    lockManager.lock(1, a, LockMode::exclusive);
+    lockManager.lock(2, b, LockMode::exclusive);
+    // Whichever waits second closes the cycle and gives up, which lets the
+    // other one through.
+    std::atomic<int> deadlocks = 0;
+    auto wait = [&lockManager, &deadlocks](TxnId txn, LockTarget target) {
+        try {
+            lockManager.lock(txn, target, LockMode::exclusive);
+        } catch (const Deadlock&) {
+            ++deadlocks;
+        }
+        lockManager.unlockAll(txn);
+    };
+    {
+        std::jthread one(wait, 1, b);
+        std::jthread two(wait, 2, a);
+    }
+    ASSERT_EQ(1, deadlocks);
+}
+
+}  // namespace ursql
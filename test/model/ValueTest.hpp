@@ -2,7 +2,10 @@
 
 #include <gtest/gtest.h>
 
+#include "exception/UserError.hpp"
 #include "model/Value.hpp"
+#include "parser/Lexer.hpp"
+#include "parser/TokenStream.hpp"
 #include "persistence/BufferStream.hpp"
 
 namespace ursql {
@@ -21,9 +24,9 @@ protected:
 
 private:
     static Value saveAndRestore(const Value& original) {
-        BufferWriter writer(block_.getData(), Block::size);
+        BufferWriter writer(block_.getData(), block_.getPayloadSize());
         writer << original;
-        BufferReader reader(block_.getData(), Block::size);
+        BufferReader reader(block_.getData(), block_.getPayloadSize());
         return reader.read<Value>();
     }
 
@@ -61,10 +64,69 @@ TEST_F(ValueTest, bool) {
     }
 }
 
+TEST_F(ValueTest, bigint) {
+    for (std::int64_t i : { std::int64_t{ 0 }, std::int64_t{ -1 },
+                            std::int64_t{ 9007199254740993 },
+                            std::numeric_limits<std::int64_t>::max() })
+    {
+        doTest(ValueType::bigint_type, std::to_string(i), i);
+    }
+}
+
+TEST_F(ValueTest, integerCast) {
+    Value big = Value::fromInteger(9007199254740993);
+    ASSERT_EQ(ValueType::bigint_type, big.getType());
+    ASSERT_EQ(ValueType::int_type, Value::fromInteger(-7).getType());
+    ASSERT_EQ("9007199254740993", big.cast(ValueType::bigint_type).toString());
+    ASSERT_FALSE(big == Value::fromInteger(9007199254740992));
+    ASSERT_TRUE(Value(16777217) == Value(std::int64_t{ 16777217 }));
+    ASSERT_EQ("16777217", Value(16777217).cast(ValueType::bigint_type)
+                            .toString());
+    ASSERT_THROW((void)big.cast(ValueType::int_type), MisMatch);
+    ASSERT_THROW((void)Value(3e10f).cast(ValueType::int_type), MisMatch);
+}
+
+TEST_F(ValueTest, parseIntegerLiterals) {
+    auto parse = [](std::string_view text) {
+        TokenStream stream(Lexer(text).lex());
+        return Value::parse(stream);
+    };
+    ASSERT_EQ(ValueType::int_type, parse("-2147483648").getType());
+    ASSERT_EQ(ValueType::bigint_type, parse("2147483648").getType());
+    Value least = parse("-9223372036854775808");
+    ASSERT_EQ(ValueType::bigint_type, least.getType());
+    ASSERT_EQ(std::numeric_limits<std::int64_t>::min(), least.toInteger());
+    ASSERT_EQ(std::numeric_limits<std::int64_t>::max(),
+              parse("9223372036854775807").toInteger());
+    ASSERT_THROW((void)parse("9223372036854775808"), SyntaxError);
+    ASSERT_THROW((void)parse("-9223372036854775809"), SyntaxError);
+    ASSERT_THROW((void)parse("18446744073709551616"), SyntaxError);
+}
+
 TEST_F(ValueTest, varchar) {
-    for (std::string s : { "asd", "aioj123", "annie", "hanhan" }) {
+    for (std::string s : { "", "asd", "aioj123", "annie", "hanhan",
+                           "fourteen chars", "fifteen chars!!",
+                           "a string that has to live on the heap" })
+    {
         doTest(ValueType::varchar_type, s, s);
     }
 }
 
+TEST_F(ValueTest, varcharOwnership) {
+    std::string text(Value::inlineCapacity + 1, 'x');
+    Value heap(text);
+    Value copy(heap);
+    ASSERT_NE(heap.raw<ValueType::varchar_type>().data(),
+              copy.raw<ValueType::varchar_type>().data());
+    Value moved(std::move(heap));
+    ASSERT_TRUE(heap.isNull());
+    ASSERT_EQ(text, moved.toString());
+    moved = Value(std::string("short"));
+    copy = moved;
+    ASSERT_EQ("short", copy.toString());
+    ASSERT_TRUE(copy == moved);
+    ASSERT_TRUE(Value(std::string("abc")) < Value(text));
+    ASSERT_EQ(16, sizeof(Value));
+}
+
 }  // namespace ursql
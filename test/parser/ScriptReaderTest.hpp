@@ -0,0 +1,83 @@
+#pragma once
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <thread>
+
+#include "TempPath.hpp"
+#include "parser/ScriptReader.hpp"
+
+namespace ursql {
+
+namespace {
+
+constexpr const std::string_view script =
+  "create table t (s varchar);\n"
+  "insert into t values ('a;b'), (\"it's\");;  \n"
+  "select * from t;\n"
+  "quit";
+
+std::vector<std::string> readAll(int fd) {
+    ScriptReader reader(fd);
+    std::vector<std::string> statements;
+    for (std::string_view statement; reader.next(statement);) {
+        statements.emplace_back(statement);
+    }
+    return statements;
+}
+
+const std::vector<std::string> expected{
+    "create table t (s varchar)",
+    "\ninsert into t values ('a;b'), (\"it's\")",
+    "  \nselect * from t",
+    "\nquit",
+};
+
+}  // namespace
+
+TEST(ScriptReaderTest, mappedFile) {
+    TempPath path("script", ".sql");
+    std::ofstream(path.get()) << script;
+    int fd = ::open(path.get().c_str(), O_RDONLY);
+    ASSERT_LE(0, fd);
+    ASSERT_EQ(expected, readAll(fd));
+    ::close(fd);
+}
+
+TEST(ScriptReaderTest, pipe) {
+    // Statements span the blocks read from the pipe.
+    std::string text;
+    while (text.size() <= ScriptReader::blockSize) {
+        text += script;
+        text += ";\n";
+    }
+    int fds[2];
+    ASSERT_EQ(0, ::pipe(fds));
+    std::thread writer([&text, fd = fds[1]]() {
+        for (std::string_view rest = text; !rest.empty();) {
+            ssize_t n = ::write(fd, rest.data(), rest.size());
+            if (n <= 0) {
+                break;
+            }
+            rest.remove_prefix(static_cast<std::size_t>(n));
+        }
+        ::close(fd);
+    });
+    std::vector<std::string> statements = readAll(fds[0]);
+    writer.join();
+    ::close(fds[0]);
+    ASSERT_EQ(0, statements.size() % expected.size());
+    for (std::size_t i = 0; i < statements.size(); ++i) {
+        std::string_view statement = statements[i];
+        if (i >= expected.size()) {
+            // Repeats start after the ";\n" that ends each copy.
+            statement.remove_prefix(i % expected.size() == 0 ? 1 : 0);
+        }
+        ASSERT_EQ(expected[i % expected.size()], statement) << i;
+    }
+}
+
+}  // namespace ursql
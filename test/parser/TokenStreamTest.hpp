@@ -72,7 +72,7 @@ TEST(TokenStream, insert) {
     ASSERT_EQ("zqdsffa", stream.next().get<TokenType::text>());
     ASSERT_EQ(Punctuation::comma, stream.next().get<TokenType::punctuation>());
     ASSERT_EQ(Operator::minus, stream.next().get<TokenType::op>());
-    ASSERT_FLOAT_EQ(3.33, stream.next().get<TokenType::number>());
+    ASSERT_FLOAT_EQ(3.33, stream.next().get<TokenType::decimal>());
     ASSERT_EQ(Punctuation::comma, stream.next().get<TokenType::punctuation>());
     ASSERT_EQ(Keyword::true_kw, stream.next().get<TokenType::keyword>());
     ASSERT_EQ(Punctuation::rparen, stream.next().get<TokenType::punctuation>());
@@ -96,7 +96,7 @@ TEST(TokenStream, del) {
     ASSERT_EQ(Keyword::or_kw, stream.next().get<TokenType::keyword>());
     ASSERT_EQ("num", stream.next().get<TokenType::identifier>());
     ASSERT_EQ(Comparator::lt, stream.next().get<TokenType::comparator>());
-    ASSERT_FLOAT_EQ(222.543, stream.next().get<TokenType::number>());
+    ASSERT_FLOAT_EQ(222.543, stream.next().get<TokenType::decimal>());
     ASSERT_EQ(Keyword::and_kw, stream.next().get<TokenType::keyword>());
     ASSERT_EQ("free form", stream.next().get<TokenType::identifier>());
     ASSERT_EQ(Comparator::eq, stream.next().get<TokenType::comparator>());
@@ -143,9 +143,9 @@ TEST(TokenStream, select) {
     ASSERT_EQ(Keyword::where_kw, stream.next().get<TokenType::keyword>());
     ASSERT_EQ("some id", stream.next().get<TokenType::identifier>());
     ASSERT_EQ(Operator::minus, stream.next().get<TokenType::op>());
-    ASSERT_FLOAT_EQ(34.5, stream.next().get<TokenType::number>());
+    ASSERT_FLOAT_EQ(34.5, stream.next().get<TokenType::decimal>());
     ASSERT_EQ(Comparator::eq, stream.next().get<TokenType::comparator>());
-    ASSERT_FLOAT_EQ(1, stream.next().get<TokenType::number>());
+    ASSERT_EQ(1, stream.next().get<TokenType::integer>());
     ASSERT_EQ(Keyword::and_kw, stream.next().get<TokenType::keyword>());
     ASSERT_EQ("jOb", stream.next().get<TokenType::identifier>());
     ASSERT_EQ(Comparator::eq, stream.next().get<TokenType::comparator>());
@@ -154,7 +154,7 @@ TEST(TokenStream, select) {
     ASSERT_EQ(Punctuation::lparen, stream.next().get<TokenType::punctuation>());
     ASSERT_EQ("age", stream.next().get<TokenType::identifier>());
     ASSERT_EQ(Comparator::gt, stream.next().get<TokenType::comparator>());
-    ASSERT_FLOAT_EQ(5, stream.next().get<TokenType::number>());
+    ASSERT_EQ(5, stream.next().get<TokenType::integer>());
     ASSERT_EQ(Keyword::or_kw, stream.next().get<TokenType::keyword>());
     ASSERT_EQ("address", stream.next().get<TokenType::identifier>());
     ASSERT_EQ(Keyword::is_kw, stream.next().get<TokenType::keyword>());
@@ -202,18 +202,27 @@ TEST(TokenStream, comp) {
 }
 
 TEST(TokenStream, number) {
-    for (std::string numStr :
-         { "152736.67123", "0", "0.0000", "00000.123400112", "001739" })
+    for (std::string numStr : { "152736.67123", "0.0000", "00000.123400112" })
     {
         SQLBlob blob;
         std::istringstream iss(numStr);
         iss >> blob;
         TokenStream stream = blob.tokenize();
         ASSERT_EQ(1, stream.remaining());
-        ASSERT_EQ(TokenType::number, stream.next().getType());
+        ASSERT_EQ(TokenType::decimal, stream.next().getType());
     }
-    for (std::string numStr :
-         { "0.000.0", "123a", "0789?", "921.123.", "897!2" })
+    // The magnitude of the least bigint is lexed too; the parser checks it
+    // against the sign.
+    for (std::string numStr : { "0", "001739", "9223372036854775808" }) {
+        SQLBlob blob;
+        std::istringstream iss(numStr);
+        iss >> blob;
+        TokenStream stream = blob.tokenize();
+        ASSERT_EQ(1, stream.remaining());
+        ASSERT_EQ(TokenType::integer, stream.next().getType());
+    }
+    for (std::string numStr : { "0.000.0", "123a", "0789@", "921.123.", "897!2",
+                                "18446744073709551616" })
     {
         SQLBlob blob;
         std::istringstream iss(numStr);
@@ -260,4 +269,16 @@ TEST(TokenStream, unknown) {
     }
 }
 
+TEST(TokenStream, numberValue) {
+    SQLBlob blob;
+    std::istringstream iss("12 3.25,7)");
+    iss >> blob;
+    TokenStream stream = blob.tokenize();
+    ASSERT_EQ(5, stream.remaining());
+    ASSERT_EQ(12, stream.next().get<TokenType::integer>());
+    ASSERT_EQ(3.25f, stream.next().get<TokenType::decimal>());
+    ASSERT_EQ(Punctuation::comma, stream.next().get<TokenType::punctuation>());
+    ASSERT_EQ(7, stream.next().get<TokenType::integer>());
+}
+
 }  // namespace ursql
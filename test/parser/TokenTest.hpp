@@ -9,7 +9,7 @@ TEST(TokenTest, identifier) {
     ASSERT_EQ(TokenType::identifier, token.getType());
     ASSERT_EQ("id1", token.get<TokenType::identifier>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::keyword>());
-    ASSERT_EQ(nullptr, token.getIf<TokenType::number>());
+    ASSERT_EQ(nullptr, token.getIf<TokenType::decimal>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::op>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::punctuation>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::text>());
@@ -20,30 +20,41 @@ TEST(TokenTest, keyword) {
     ASSERT_EQ(TokenType::keyword, token.getType());
     ASSERT_EQ(nullptr, token.getIf<TokenType::identifier>());
     ASSERT_EQ(Keyword::select_kw, token.get<TokenType::keyword>());
-    ASSERT_EQ(nullptr, token.getIf<TokenType::number>());
+    ASSERT_EQ(nullptr, token.getIf<TokenType::decimal>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::op>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::punctuation>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::text>());
 }
 
-TEST(TokenTest, number) {
+TEST(TokenTest, decimal) {
     float num = 1123.12321;
-    Token token(token_type_index<TokenType::number>, num);
-    ASSERT_EQ(TokenType::number, token.getType());
+    Token token(token_type_index<TokenType::decimal>, num);
+    ASSERT_EQ(TokenType::decimal, token.getType());
     ASSERT_EQ(nullptr, token.getIf<TokenType::identifier>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::keyword>());
-    ASSERT_EQ(num, token.get<TokenType::number>());
+    ASSERT_EQ(num, token.get<TokenType::decimal>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::op>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::punctuation>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::text>());
 }
 
+TEST(TokenTest, integer) {
+    std::uint64_t num = 9007199254740993;
+    Token token(token_type_index<TokenType::integer>, num);
+    ASSERT_EQ(TokenType::integer, token.getType());
+    ASSERT_EQ(nullptr, token.getIf<TokenType::decimal>());
+    ASSERT_EQ(nullptr, token.getIf<TokenType::identifier>());
+    ASSERT_EQ(num, token.get<TokenType::integer>());
+    ASSERT_EQ(nullptr, token.getIf<TokenType::keyword>());
+    ASSERT_EQ(nullptr, token.getIf<TokenType::text>());
+}
+
 TEST(TokenTest, op) {
     Token token(token_type_index<TokenType::op>, Operator::plus);
     ASSERT_EQ(TokenType::op, token.getType());
     ASSERT_EQ(nullptr, token.getIf<TokenType::identifier>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::keyword>());
-    ASSERT_EQ(nullptr, token.getIf<TokenType::number>());
+    ASSERT_EQ(nullptr, token.getIf<TokenType::decimal>());
     ASSERT_EQ(Operator::plus, token.get<TokenType::op>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::punctuation>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::text>());
@@ -54,7 +65,7 @@ TEST(TokenTest, punctuation) {
     ASSERT_EQ(TokenType::punctuation, token.getType());
     ASSERT_EQ(nullptr, token.getIf<TokenType::identifier>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::keyword>());
-    ASSERT_EQ(nullptr, token.getIf<TokenType::number>());
+    ASSERT_EQ(nullptr, token.getIf<TokenType::decimal>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::op>());
     ASSERT_EQ(Punctuation::lparen, token.get<TokenType::punctuation>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::text>());
@@ -66,10 +77,24 @@ TEST(TokenTest, text) {
     ASSERT_EQ(TokenType::text, token.getType());
     ASSERT_EQ(nullptr, token.getIf<TokenType::identifier>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::keyword>());
-    ASSERT_EQ(nullptr, token.getIf<TokenType::number>());
+    ASSERT_EQ(nullptr, token.getIf<TokenType::decimal>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::op>());
     ASSERT_EQ(nullptr, token.getIf<TokenType::punctuation>());
     ASSERT_EQ(str, token.get<TokenType::text>());
 }
 
+TEST(TokenTest, keywordLookup) {
+    ASSERT_EQ(Keyword::select_kw, findKeyword("SeLeCt"));
+    ASSERT_EQ(Keyword::auto_increment_kw, findKeyword("AUTO_INCREMENT"));
+    ASSERT_EQ(Keyword::integer_kw, findKeyword("int"));
+    ASSERT_EQ(Keyword::integer_kw, findKeyword("Integer"));
+    for (auto str : { "", "selec", "selects", "s3lect", "intt", "whereabouts",
+                      "t.col", "auto_increment_" })
+    {
+        ASSERT_FALSE(findKeyword(str).has_value()) << str;
+    }
+    ASSERT_EQ("auto_increment", toString(Keyword::auto_increment_kw));
+    ASSERT_EQ("where", std::format("{}", Keyword::where_kw));
+}
+
 }  // namespace ursql
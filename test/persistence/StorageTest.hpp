@@ -0,0 +1,181 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "TempPath.hpp"
+#include "exception/InternalError.hpp"
+#include "model/Row.hpp"
+#include "model/TOC.hpp"
+#include "persistence/BufferStream.hpp"
+#include "persistence/Storage.hpp"
+
+namespace ursql {
+
+class StorageTest : public testing::Test {
+protected:
+    const TempPath path_{ "storage", ".tmp" };
+};
+
+TEST_F(StorageTest, writeBack) {
+    constexpr const std::size_t blockCount =
+      BlockCache::defaultCapacity * 2 + 3;
+    constexpr const std::size_t blockSize = 8192;
+    {
+        // Opening the file takes the block size from the TOC.
+        Storage storage(path_, CreateNewFile{ blockSize });
+        storage.save(TOC(blockSize));
+        for (std::size_t i = 1; i < blockCount; ++i) {
+            Block block(BlockType::row, blockSize);
+            BufferWriter(block.getData(), block.getPayloadSize()) << i;
+            storage.writeBlock(block, i);
+        }
+        ASSERT_EQ(blockCount, storage.getBlockCount());
+        storage.releaseBlock(blockCount - 1);
+    }
+    Storage storage(path_, OpenExistingFile{});
+    ASSERT_EQ(blockSize, storage.getBlockSize());
+    ASSERT_EQ(blockCount, storage.getBlockCount());
+    ASSERT_EQ(BlockType::free, storage.getBlockType(blockCount - 1));
+    std::vector<BlockType> blockTypes = storage.getBlockTypes();
+    ASSERT_EQ(blockCount - 2, std::ranges::count(blockTypes, BlockType::row));
+    for (std::size_t i = 1; i + 1 < blockCount; ++i) {
+        Block block(BlockType::free, blockSize);
+        storage.readBlock(block, i);
+        ASSERT_EQ(BlockType::row, block.getType());
+        ASSERT_EQ(i, BufferReader(block.getData(), block.getPayloadSize())
+                       .read<std::size_t>());
+    }
+}
+
+TEST_F(StorageTest, updateRowInBlock) {
+    Storage storage(path_, CreateNewFile{});
+    storage.save(Row(0, { Value(1), Value(std::string("ab")), Value(2) }));
+    auto update = [&storage](std::size_t index, Value value) {
+        storage.updateBlock(0, [&](Block& block, std::size_t blockNum) {
+            Row row(blockNum);
+            row.decode(block);
+            row.updateInBlock(block, { { index, std::move(value) } });
+            return true;
+        });
+    };
+    update(1, Value(std::string("cd")));
+    update(2, Value(3));
+    update(1, Value(std::string("longer")));
+    storage.flush();
+
+    Row row(0);
+    storage.load(row);
+    auto& values = row.getValues();
+    ASSERT_EQ(3, values.size());
+    ASSERT_EQ("1", values[0].toString());
+    ASSERT_EQ("longer", values[1].toString());
+    ASSERT_EQ("3", values[2].toString());
+}
+
+TEST_F(StorageTest, writeBlocks) {
+    Storage storage(path_, CreateNewFile{});
+    Block cached(BlockType::row);
+    storage.writeBlock(cached, 1);
+    std::vector<Block> blocks(3);
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        blocks[i].setType(BlockType::row);
+        BufferWriter(blocks[i].getData(), blocks[i].getPayloadSize())
+          << i + 10;
+    }
+    storage.writeBlocks(1, blocks);
+    ASSERT_EQ(4, storage.getBlockCount());
+    // The cached copy of block 1 follows the write and isn't written back.
+    storage.flush();
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        Block block;
+        storage.readBlock(block, i + 1);
+        ASSERT_EQ(i + 10,
+                  BufferReader(block.getData(), block.getPayloadSize())
+                    .read<std::size_t>());
+    }
+}
+
+TEST_F(StorageTest, appendFreeBlocksAndReadBlocks) {
+    Storage storage(path_, CreateNewFile{});
+    ASSERT_EQ(0, storage.appendFreeBlocks(64));
+    ASSERT_EQ(64, storage.appendFreeBlocks(64));
+    ASSERT_EQ(128, storage.getBlockCount());
+    storage.flush();
+    ASSERT_EQ(Block::defaultSize * 128, fs::file_size(path_));
+
+    std::vector<Block> blocks(2);
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        blocks[i].setType(BlockType::row);
+        BufferWriter(blocks[i].getData(), blocks[i].getPayloadSize())
+          << i + 10;
+    }
+    storage.writeBlocks(63, blocks);
+    // The cached copy is newer than the file.
+    Block cached(BlockType::row);
+    BufferWriter(cached.getData(), cached.getPayloadSize()) << std::size_t(20);
+    storage.writeBlock(cached, 64);
+    std::vector<Block> run(3);
+    storage.readBlocks(62, run);
+    ASSERT_EQ(BlockType::free, run[0].getType());
+    ASSERT_EQ(10, BufferReader(run[1].getData(), run[1].getPayloadSize())
+                    .read<std::size_t>());
+    ASSERT_EQ(20, BufferReader(run[2].getData(), run[2].getPayloadSize())
+                    .read<std::size_t>());
+}
+
+TEST_F(StorageTest, closingOnlyReportsWriteErrors) {
+    // Every write to the device fails for lack of space.
+    std::optional<Storage> storage(std::in_place, "/dev/full",
+                                   CreateNewFile{});
+    storage->save(TOC(Block::defaultSize));
+    ASSERT_THROW(storage->flush(), FileAccessError);
+    storage.reset();
+}
+
+TEST_F(StorageTest, keepsBlocksItCantWriteBack) {
+    constexpr const std::size_t blockSize = Block::maxSize;
+    std::optional<Storage> storage(std::in_place, "/dev/full",
+                                   CreateNewFile{ blockSize });
+    // Once the cache is full, each write evicts the oldest block, and
+    // writing it back fails.
+    std::size_t blockNum = 0;
+    ASSERT_THROW(
+      for (; blockNum < 64; ++blockNum) {
+          Block block(BlockType::row, blockSize);
+          BufferWriter(block.getData(), block.getPayloadSize()) << blockNum;
+          storage->writeBlock(block, blockNum);
+      },
+      FileAccessError);
+    ASSERT_GT(blockNum, 1);
+    Block block(BlockType::free, blockSize);
+    storage->readBlock(block, 0);
+    ASSERT_EQ(BlockType::row, block.getType());
+    ASSERT_EQ(0, BufferReader(block.getData(), block.getPayloadSize())
+                   .read<std::size_t>());
+    storage.reset();
+}
+
+TEST_F(StorageTest, doesntCacheFailedReads) {
+    {
+        Storage storage(path_, CreateNewFile{});
+        storage.save(TOC(Block::defaultSize));
+        std::vector<Block> blocks(3);
+        for (std::size_t i = 0; i < blocks.size(); ++i) {
+            blocks[i].setType(BlockType::row);
+            BufferWriter(blocks[i].getData(), blocks[i].getPayloadSize())
+              << i + 1;
+        }
+        storage.writeBlocks(1, blocks);
+    }
+    Storage storage(path_, OpenExistingFile{});
+    fs::resize_file(path_, Block::defaultSize * 2);
+    Block block;
+    ASSERT_THROW(storage.readBlock(block, 3), FileAccessError);
+    ASSERT_THROW(storage.readBlock(block, 3), FileAccessError);
+    // A failed read doesn't fail the reads after it.
+    storage.readBlock(block, 1);
+    ASSERT_EQ(1, BufferReader(block.getData(), block.getPayloadSize())
+                   .read<std::size_t>());
+}
+
+}  // namespace ursql
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "exception/UserError.hpp"
+#include "model/Entity.hpp"
+#include "parser/SQLBlob.hpp"
+#include "parser/TokenStream.hpp"
+#include "statement/Filter.hpp"
+
+namespace ursql {
+
+class FilterTest : public testing::Test {
+protected:
+    void SetUp() override {
+        std::vector<Attribute> attributes(2);
+        attributes[0].setName("a");
+        attributes[0].setValueType(ValueType::int_type);
+        attributes[1].setName("b");
+        attributes[1].setValueType(ValueType::varchar_type);
+        entity_.setAttributes(std::move(attributes));
+    }
+
+    Filter::RowPredicate bind(std::string_view condition) {
+        SQLBlob blob;
+        std::istringstream iss(std::format("{};", condition));
+        iss >> blob;
+        TokenStream stream = blob.tokenize();
+        ResourcePtr<Filter> filter = Filter::parse(stream);
+        EXPECT_FALSE(stream.hasNext());
+        return filter->bind(entity_);
+    }
+
+    Entity entity_{ 0 };
+};
+
+TEST_F(FilterTest, comparison) {
+    auto pred = bind("a >= 2 and b != 'x'");
+    ASSERT_TRUE(pred({ Value(2), Value(std::string("y")) }));
+    ASSERT_FALSE(pred({ Value(2), Value(std::string("x")) }));
+    ASSERT_FALSE(pred({ Value(1), Value(std::string("y")) }));
+    ASSERT_FALSE(pred({ Value(), Value(std::string("y")) }));
+}
+
+TEST_F(FilterTest, precedence) {
+    auto pred = bind("not a = -1 or b is null and (a < 0)");
+    ASSERT_TRUE(pred({ Value(3), Value(std::string("y")) }));
+    ASSERT_FALSE(pred({ Value(-1), Value(std::string("y")) }));
+    ASSERT_TRUE(pred({ Value(-1), Value() }));
+    // Both sides of the 'or' are unknown.
+    ASSERT_FALSE(pred({ Value(), Value() }));
+}
+
+TEST_F(FilterTest, nullIsUnknown) {
+    // Unknown stays unknown when negated.
+    ASSERT_FALSE(bind("not a = -1")({ Value(), Value() }));
+    ASSERT_FALSE(bind("not (a = -1 or b = 'x')")({ Value(), Value() }));
+    // Unknown is ignored next to a true 'or' or a false 'and'.
+    ASSERT_TRUE(bind("a = 1 or b is null")({ Value(), Value() }));
+    ASSERT_TRUE(
+      bind("not (a = 1 and b = 'x')")({ Value(), Value(std::string("y")) }));
+    ASSERT_FALSE(
+      bind("not (a = 1 and b = 'y')")({ Value(), Value(std::string("y")) }));
+}
+
+TEST_F(FilterTest, typeMismatch) {
+    ASSERT_THROW(bind("a = 'x'"), MisMatch);
+    ASSERT_THROW(bind("c = 1"), DoesNotExist);
+}
+
+}  // namespace ursql
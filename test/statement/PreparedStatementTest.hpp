@@ -0,0 +1,103 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "TempPath.hpp"
+#include "controller/DBManager.hpp"
+#include "exception/UserError.hpp"
+#include "parser/Lexer.hpp"
+#include "parser/Parser.hpp"
+#include "statement/PreparedStatement.hpp"
+
+namespace ursql {
+
+class PreparedStatementTest : public testing::Test {
+protected:
+    void SetUp() override {
+        fs::create_directories(dir_);
+        run("create database prepared");
+        run("use prepared");
+        run("create table t (id int primary key auto_increment, "
+            "n bigint, s varchar)");
+    }
+
+    void run(std::string_view text) {
+        TokenStream ts(Lexer(text).lex());
+        (void)parser::parse(ts)->run(dbManager_);
+    }
+
+    std::vector<std::vector<Value>> selectAll() {
+        return dbManager_.getActiveDB()->selectFromTable("t", std::nullopt,
+                                                         nullptr);
+    }
+
+    const TempPath dir_{ "prepared" };
+    DBManager dbManager_{ dir_, ".db" };
+};
+
+TEST_F(PreparedStatementTest, insert) {
+    auto stmt = PreparedStatement::prepare(
+      "insert into t (n, s) values (?, 'x'), (?, ?)");
+    ASSERT_EQ(3, stmt->getParamCount());
+    (void)stmt->execute(dbManager_, { Value(std::int64_t{ 1 } << 40), Value(2),
+                                      Value(std::string("y")) });
+    (void)stmt->execute(dbManager_, { Value(3), Value(), Value() });
+    ASSERT_THROW((void)stmt->execute(dbManager_, { Value(1) }), MisMatch);
+    auto rows = selectAll();
+    ASSERT_EQ(4, rows.size());
+    ASSERT_EQ("1099511627776", rows[0][1].toString());
+    ASSERT_EQ("x", rows[0][2].toString());
+    ASSERT_EQ("y", rows[1][2].toString());
+    ASSERT_EQ("4", rows[3][0].toString());
+    ASSERT_TRUE(rows[3][1].isNull());
+
+    // The cached plan follows the table when it's recreated.
+    run("drop table t");
+    run("create table t (s varchar, n int, id int)");
+    (void)stmt->execute(dbManager_, { Value(5), Value(6),
+                                      Value(std::string("z")) });
+    rows = selectAll();
+    ASSERT_EQ(2, rows.size());
+    ASSERT_EQ("z", rows[1][0].toString());
+    ASSERT_EQ("6", rows[1][1].toString());
+}
+
+TEST_F(PreparedStatementTest, reparsed) {
+    run("insert into t (n, s) values (1, 'a'), (2, 'b'), (3, 'c')");
+    auto stmt = PreparedStatement::prepare("delete from t where n < ?");
+    ASSERT_EQ(1, stmt->getParamCount());
+    (void)stmt->execute(dbManager_, { Value(2) });
+    ASSERT_EQ(2, selectAll().size());
+    (void)stmt->execute(dbManager_, { Value(3) });
+    ASSERT_EQ(1, selectAll().size());
+    ASSERT_THROW((void)PreparedStatement::prepare("delete t where n < ?"),
+                 MissingInput);
+    ASSERT_THROW(run("delete from t where n < ?"), UnexpectedInput);
+}
+
+TEST_F(PreparedStatementTest, statementsOutliveTheirTokens) {
+    // Like a parse-ahead batch: the statements are kept in one arena while
+    // the tokens of each are lexed into another, reset in between.
+    Arena batch;
+    Arena scratch;
+    std::vector<ResourcePtr<Statement>> statements;
+    for (std::string_view text :
+         { "insert into t (n, s) values (1, 'a'), (2, 'a longer string')",
+           "update t set s = 'b' where n = 1 or s = 'a'",
+           "delete from t where not (n = 1)" })
+    {
+        TokenStream ts(Lexer(text).lex(scratch.resource()));
+        ts.setResource(batch.resource());
+        statements.push_back(parser::parse(ts));
+        scratch.reset();
+    }
+    for (auto& statement : statements) {
+        (void)statement->run(dbManager_);
+    }
+    auto rows = selectAll();
+    ASSERT_EQ(1, rows.size());
+    ASSERT_EQ("1", rows[0][1].toString());
+    ASSERT_EQ("b", rows[0][2].toString());
+}
+
+}  // namespace ursql